@@ -30,6 +30,7 @@
 #import "OFSerialization.h"
 #import "OFJSONRepresentation.h"
 #import "OFMessagePackRepresentation.h"
+#import "OFBinaryPropertyListRepresentation.h"
 
 OF_ASSUME_NONNULL_BEGIN
 
@@ -91,7 +92,7 @@ typedef id _Nullable (^of_array_fold_block_t)(id _Nullable left, id right);
  */
 @interface OFArray OF_GENERIC(ObjectType): OFObject <OFCopying,
     OFMutableCopying, OFCollection, OFSerialization, OFJSONRepresentation,
-    OFMessagePackRepresentation>
+    OFMessagePackRepresentation, OFBinaryPropertyListRepresentation>
 #if !defined(OF_HAVE_GENERICS) && !defined(DOXYGEN)
 # define ObjectType id
 #endif
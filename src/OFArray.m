@@ -20,11 +20,11 @@
 #include <stdarg.h>
 #include <stdlib.h>
 
-#include <assert.h>
-
 #import "OFArray.h"
 #import "OFAdjacentArray.h"
+#import "OFBinaryPropertyListWriter.h"
 #import "OFData.h"
+#import "OFMessagePackWriter.h"
 #import "OFNull.h"
 #import "OFString.h"
 #import "OFSubarray.h"
@@ -655,56 +655,13 @@ static struct {
 
 - (OFData *)messagePackRepresentation
 {
-	OFMutableData *data;
-	size_t i, count;
-	void *pool;
-
-	data = [OFMutableData data];
-	count = self.count;
-
-	if (count <= 15) {
-		uint8_t tmp = 0x90 | ((uint8_t)count & 0xF);
-		[data addItem: &tmp];
-	} else if (count <= UINT16_MAX) {
-		uint8_t type = 0xDC;
-		uint16_t tmp = OF_BSWAP16_IF_LE((uint16_t)count);
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else if (count <= UINT32_MAX) {
-		uint8_t type = 0xDD;
-		uint32_t tmp = OF_BSWAP32_IF_LE((uint32_t)count);
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else
-		@throw [OFOutOfRangeException exception];
-
-	pool = objc_autoreleasePoolPush();
-
-	i = 0;
-	for (id object in self) {
-		void *pool2 = objc_autoreleasePoolPush();
-		OFData *child;
-
-		i++;
-
-		child = [object messagePackRepresentation];
-		[data addItems: child.items
-			 count: child.count];
-
-		objc_autoreleasePoolPop(pool2);
-	}
-
-	assert(i == count);
-
-	[data makeImmutable];
-
-	objc_autoreleasePoolPop(pool);
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
+}
 
-	return data;
+- (OFData *)binaryPropertyListRepresentation
+{
+	return [OFBinaryPropertyListWriter
+	    binaryPropertyListRepresentationOfObject: self];
 }
 
 - (void)makeObjectsPerformSelector: (SEL)selector
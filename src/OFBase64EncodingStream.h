@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFStream.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#define OF_BASE64_ENCODING_STREAM_BUFFER_SIZE 4096
+
+/*!
+ * @class OFBase64EncodingStream \
+ *	  OFBase64EncodingStream.h ObjFW/OFBase64EncodingStream.h
+ *
+ * @brief A class that Base64-encodes everything written to it and writes the
+ *	  result to an underlying stream.
+ *
+ * This allows encoding large amounts of data, e.g. attachments, without ever
+ * having the complete data or the complete encoded string in memory.
+ *
+ * Closing the stream writes the final group including the padding. The
+ * underlying stream is not closed.
+ */
+@interface OFBase64EncodingStream: OFStream
+{
+	OFStream *_Nullable _stream;
+	uint8_t _rest[3];
+	uint8_t _restLength;
+	char _buffer[OF_BASE64_ENCODING_STREAM_BUFFER_SIZE];
+}
+
+/*!
+ * @brief Creates a new OFBase64EncodingStream with the specified underlying
+ *	  stream.
+ *
+ * @param stream The underlying stream to which the encoded data is written
+ * @return A new, autoreleased OFBase64EncodingStream
+ */
++ (instancetype)streamWithStream: (OFStream *)stream;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated OFBase64EncodingStream with the
+ *	  specified underlying stream.
+ *
+ * @param stream The underlying stream to which the encoded data is written
+ * @return An initialized OFBase64EncodingStream
+ */
+- (instancetype)initWithStream: (OFStream *)stream OF_DESIGNATED_INITIALIZER;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFBase64EncodingStream.h"
+
+#import "base64.h"
+
+#import "OFNotOpenException.h"
+
+@implementation OFBase64EncodingStream
++ (instancetype)streamWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [super init];
+
+	_stream = [stream retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_stream != nil)
+		[self close];
+
+	[super dealloc];
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	const uint8_t *bytes = buffer;
+	size_t i = 0;
+
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	/* Complete the group that was left over from the last write first. */
+	if (_restLength > 0) {
+		while (_restLength < 3 && i < length)
+			_rest[_restLength++] = bytes[i++];
+
+		if (_restLength < 3)
+			return length;
+
+		[_stream writeBuffer: _buffer
+			      length: of_base64_encode_buffer(_buffer, _rest, 3)];
+		_restLength = 0;
+	}
+
+	while (length - i >= 3) {
+		size_t count = (length - i) / 3 * 3;
+
+		if (count > OF_BASE64_ENCODING_STREAM_BUFFER_SIZE / 4 * 3)
+			count = OF_BASE64_ENCODING_STREAM_BUFFER_SIZE / 4 * 3;
+
+		[_stream writeBuffer: _buffer
+			      length: of_base64_encode_buffer(_buffer,
+					  bytes + i, count)];
+		i += count;
+	}
+
+	while (i < length)
+		_rest[_restLength++] = bytes[i++];
+
+	return length;
+}
+
+- (void)close
+{
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	@try {
+		if (_restLength > 0)
+			[_stream writeBuffer: _buffer
+				      length: of_base64_encode_buffer(_buffer,
+						  _rest, _restLength)];
+	} @finally {
+		_restLength = 0;
+
+		[_stream release];
+		_stream = nil;
+	}
+
+	[super close];
+}
+@end
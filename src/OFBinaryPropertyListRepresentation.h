@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+
+/*!
+ * @protocol OFBinaryPropertyListRepresentation \
+ *	     OFBinaryPropertyListRepresentation.h \
+ *	     ObjFW/OFBinaryPropertyListRepresentation.h
+ *
+ * @brief A protocol implemented by classes that support encoding to a binary
+ *	  property list representation.
+ */
+@protocol OFBinaryPropertyListRepresentation
+/*!
+ * @brief The object as a binary property list (`bplist00`).
+ *
+ * Equal strings, numbers, data and dates are only stored once. Only OFArray,
+ * OFDictionary with OFString keys, OFString, OFNumber, OFData, OFDate and
+ * OFNull are supported as members.
+ *
+ * @throw OFInvalidArgumentException The object contains an object that cannot
+ *				     be represented in a property list
+ */
+@property (readonly, nonatomic) OFData *binaryPropertyListRepresentation;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,675 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFBinaryPropertyListWriter.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFEnumerator.h"
+#import "OFMapTable.h"
+#import "OFMapTable+Private.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+
+/* Dates are stored relative to 2001-01-01 00:00:00 UTC. */
+#define DATE_EPOCH 978307200
+#define TRAILER_SIZE 32
+
+enum kind {
+	KIND_NULL,
+	KIND_FALSE,
+	KIND_TRUE,
+	KIND_INTEGER,
+	KIND_FLOAT,
+	KIND_DOUBLE,
+	KIND_DATE,
+	KIND_DATA,
+	KIND_ASCII_STRING,
+	KIND_UTF16_STRING,
+	KIND_ARRAY,
+	KIND_DICTIONARY
+};
+
+struct entry {
+	id object;
+	enum kind kind;
+	/* The number of bytes, characters or members */
+	size_t count;
+	/* The index of the first reference to a member */
+	size_t references;
+	size_t offset;
+};
+
+struct writer {
+	struct entry *entries;
+	size_t entriesCount, entriesCapacity;
+	size_t *references;
+	size_t referencesCount, referencesCapacity;
+	size_t nullIndex, falseIndex, trueIndex;
+	/* Map strings, data, dates and numbers to their index + 1 */
+	OFMapTable *objects, *numbers;
+};
+
+static enum kind
+kindOfNumber(OFNumber *number)
+{
+	of_number_type_t type = number.type;
+
+	if (type == OF_NUMBER_TYPE_BOOL)
+		return (number.boolValue ? KIND_TRUE : KIND_FALSE);
+	if (type == OF_NUMBER_TYPE_FLOAT)
+		return KIND_FLOAT;
+	if (type & OF_NUMBER_TYPE_FLOAT)
+		return KIND_DOUBLE;
+
+	return KIND_INTEGER;
+}
+
+static bool
+isNegative(OFNumber *number)
+{
+	return (number.type & OF_NUMBER_TYPE_SIGNED && number.intMaxValue < 0);
+}
+
+/*
+ * -[OFNumber isEqual:] considers 1, 1.0 and true equal, but they need to be
+ * stored as different objects. Reals are compared bitwise so that e.g. -0.0
+ * is not replaced with 0.0.
+ */
+static bool
+numberEqual(void *object1, void *object2)
+{
+	OFNumber *number1 = object1, *number2 = object2;
+	enum kind kind = kindOfNumber(number1);
+
+	if (kind != kindOfNumber(number2))
+		return false;
+
+	if (kind == KIND_FLOAT) {
+		float value1 = number1.floatValue, value2 = number2.floatValue;
+
+		return (memcmp(&value1, &value2, sizeof(float)) == 0);
+	}
+
+	if (kind == KIND_DOUBLE) {
+		double value1 = number1.doubleValue;
+		double value2 = number2.doubleValue;
+
+		return (memcmp(&value1, &value2, sizeof(double)) == 0);
+	}
+
+	return (isNegative(number1) == isNegative(number2) &&
+	    number1.uIntMaxValue == number2.uIntMaxValue);
+}
+
+static const of_map_table_functions_t numberFunctions = {
+	.retain = of_map_table_object_retain,
+	.release = of_map_table_object_release,
+	.hash = of_map_table_object_hash,
+	.equal = numberEqual
+};
+static const of_map_table_functions_t indexFunctions = { NULL };
+
+static size_t
+addLength(size_t length, size_t add)
+{
+	if (SIZE_MAX - length < add)
+		@throw [OFOutOfRangeException exception];
+
+	return length + add;
+}
+
+static size_t
+multiplyLength(size_t length, size_t factor)
+{
+	if (factor != 0 && length > SIZE_MAX / factor)
+		@throw [OFOutOfRangeException exception];
+
+	return length * factor;
+}
+
+/* The number of bytes needed for a reference or an offset */
+static uint8_t
+sizeForValue(uint64_t value)
+{
+	if (value <= UINT8_MAX)
+		return 1;
+	if (value <= UINT16_MAX)
+		return 2;
+	if (value <= UINT32_MAX)
+		return 4;
+
+	return 8;
+}
+
+/*
+ * Integers of 1, 2 and 4 bytes are unsigned, those of 8 bytes are signed and
+ * those of 16 bytes are only used for unsigned values above INT64_MAX.
+ */
+static size_t
+integerSize(OFNumber *number)
+{
+	uintmax_t value;
+
+	if (isNegative(number))
+		return 8;
+
+	value = number.uIntMaxValue;
+
+#if UINTMAX_MAX > UINT64_MAX
+	if (value > UINT64_MAX)
+		@throw [OFOutOfRangeException exception];
+#endif
+
+	if (value > INT64_MAX)
+		return 16;
+
+	return sizeForValue(value);
+}
+
+static void
+writeBigEndian(unsigned char *buffer, uint64_t value, size_t size)
+{
+	while (size > 0) {
+		buffer[--size] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+static uint8_t
+exponentForSize(size_t size)
+{
+	switch (size) {
+	case 1:
+		return 0;
+	case 2:
+		return 1;
+	case 4:
+		return 2;
+	case 8:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+static size_t
+headerLength(size_t count)
+{
+	if (count < 15)
+		return 1;
+
+	return 2 + sizeForValue(count);
+}
+
+static size_t
+writeHeader(unsigned char *buffer, uint8_t marker, size_t count)
+{
+	uint8_t size;
+
+	if (count < 15) {
+		buffer[0] = marker | (uint8_t)count;
+		return 1;
+	}
+
+	size = sizeForValue(count);
+	buffer[0] = marker | 0x0F;
+	buffer[1] = 0x10 | exponentForSize(size);
+	writeBigEndian(buffer + 2, count, size);
+
+	return 2 + size;
+}
+
+static size_t
+addEntry(struct writer *writer, id object, enum kind kind, size_t count,
+    size_t references)
+{
+	struct entry *entry;
+
+	if (writer->entriesCount == writer->entriesCapacity) {
+		size_t capacity = (writer->entriesCapacity > 0
+		    ? multiplyLength(writer->entriesCapacity, 2) : 16);
+		struct entry *entries = realloc(writer->entries,
+		    multiplyLength(capacity, sizeof(*entries)));
+
+		if (entries == NULL)
+			@throw [OFOutOfMemoryException
+			    exceptionWithRequestedSize:
+			    capacity * sizeof(*entries)];
+
+		writer->entries = entries;
+		writer->entriesCapacity = capacity;
+	}
+
+	entry = &writer->entries[writer->entriesCount];
+	entry->object = object;
+	entry->kind = kind;
+	entry->count = count;
+	entry->references = references;
+	entry->offset = 0;
+
+	return writer->entriesCount++;
+}
+
+/*
+ * Reserves the references for all members of a container up front, so that
+ * they are contiguous even though the members are flattened recursively.
+ */
+static size_t
+reserveReferences(struct writer *writer, size_t count)
+{
+	size_t first = writer->referencesCount;
+
+	if (writer->referencesCapacity - writer->referencesCount < count) {
+		size_t capacity = addLength(writer->referencesCount, count);
+		size_t *references;
+
+		if (capacity < writer->referencesCapacity * 2 &&
+		    writer->referencesCapacity <= SIZE_MAX / 2)
+			capacity = writer->referencesCapacity * 2;
+
+		references = realloc(writer->references,
+		    multiplyLength(capacity, sizeof(*references)));
+		if (references == NULL)
+			@throw [OFOutOfMemoryException
+			    exceptionWithRequestedSize:
+			    capacity * sizeof(*references)];
+
+		writer->references = references;
+		writer->referencesCapacity = capacity;
+	}
+
+	writer->referencesCount += count;
+
+	return first;
+}
+
+static size_t
+addUniqueEntry(struct writer *writer, OFMapTable *table, id object,
+    enum kind kind, size_t count)
+{
+	size_t idx;
+
+	idx = addEntry(writer, object, kind, count, 0);
+	[table setObject: (void *)(uintptr_t)(idx + 1)
+		  forKey: object];
+
+	return idx;
+}
+
+static size_t
+addSingletonEntry(struct writer *writer, size_t *idx, enum kind kind)
+{
+	if (*idx == SIZE_MAX)
+		*idx = addEntry(writer, nil, kind, 0, 0);
+
+	return *idx;
+}
+
+static size_t
+flattenObject(struct writer *writer, id object)
+{
+	void *existing;
+
+	if ([object isKindOfClass: [OFArray class]]) {
+		size_t count = [object count];
+		size_t references = reserveReferences(writer, count);
+		size_t idx = addEntry(writer, object, KIND_ARRAY, count,
+		    references);
+		size_t i = 0;
+
+		for (id member in object) {
+			size_t memberIdx;
+
+			if (i >= count)
+				@throw [OFOutOfRangeException exception];
+
+			memberIdx = flattenObject(writer, member);
+			writer->references[references + i++] = memberIdx;
+		}
+
+		if (i != count)
+			@throw [OFOutOfRangeException exception];
+
+		return idx;
+	}
+
+	if ([object isKindOfClass: [OFDictionary class]]) {
+		size_t count = [object count];
+		size_t references = reserveReferences(writer,
+		    multiplyLength(count, 2));
+		size_t idx = addEntry(writer, object, KIND_DICTIONARY, count,
+		    references);
+		OFEnumerator *keyEnumerator = [object keyEnumerator];
+		OFEnumerator *objectEnumerator = [object objectEnumerator];
+		size_t i = 0;
+		id key, value;
+
+		while ((key = [keyEnumerator nextObject]) != nil &&
+		    (value = [objectEnumerator nextObject]) != nil) {
+			size_t keyIdx, valueIdx;
+
+			if (![key isKindOfClass: [OFString class]])
+				@throw [OFInvalidArgumentException exception];
+
+			if (i >= count)
+				@throw [OFOutOfRangeException exception];
+
+			keyIdx = flattenObject(writer, key);
+			valueIdx = flattenObject(writer, value);
+			writer->references[references + i] = keyIdx;
+			writer->references[references + count + i] = valueIdx;
+			i++;
+		}
+
+		if (i != count)
+			@throw [OFOutOfRangeException exception];
+
+		return idx;
+	}
+
+	if ([object isKindOfClass: [OFNumber class]]) {
+		enum kind kind = kindOfNumber(object);
+
+		if (kind == KIND_FALSE)
+			return addSingletonEntry(writer, &writer->falseIndex,
+			    KIND_FALSE);
+		if (kind == KIND_TRUE)
+			return addSingletonEntry(writer, &writer->trueIndex,
+			    KIND_TRUE);
+
+		if ((existing = [writer->numbers objectForKey: object]) != NULL)
+			return (uintptr_t)existing - 1;
+
+		if (kind == KIND_INTEGER)
+			return addUniqueEntry(writer, writer->numbers, object,
+			    kind, integerSize(object));
+
+		return addUniqueEntry(writer, writer->numbers, object, kind, 0);
+	}
+
+	if ([object isKindOfClass: [OFNull class]])
+		return addSingletonEntry(writer, &writer->nullIndex, KIND_NULL);
+
+	if (![object isKindOfClass: [OFString class]] &&
+	    ![object isKindOfClass: [OFData class]] &&
+	    ![object isKindOfClass: [OFDate class]])
+		@throw [OFInvalidArgumentException exception];
+
+	if ((existing = [writer->objects objectForKey: object]) != NULL)
+		return (uintptr_t)existing - 1;
+
+	if ([object isKindOfClass: [OFString class]]) {
+		size_t length = [object length];
+		const of_unichar_t *characters;
+		size_t UTF16Length;
+
+		if ([object UTF8StringLength] == length)
+			return addUniqueEntry(writer, writer->objects, object,
+			    KIND_ASCII_STRING, length);
+
+		characters = [object characters];
+		UTF16Length = length;
+		for (size_t i = 0; i < length; i++)
+			if (characters[i] > 0xFFFF)
+				UTF16Length++;
+
+		return addUniqueEntry(writer, writer->objects, object,
+		    KIND_UTF16_STRING, UTF16Length);
+	}
+
+	if ([object isKindOfClass: [OFData class]])
+		return addUniqueEntry(writer, writer->objects, object,
+		    KIND_DATA, multiplyLength([object count],
+		    [object itemSize]));
+
+	return addUniqueEntry(writer, writer->objects, object, KIND_DATE, 0);
+}
+
+static size_t
+lengthOfEntry(const struct entry *entry, uint8_t referenceSize)
+{
+	switch (entry->kind) {
+	case KIND_NULL:
+	case KIND_FALSE:
+	case KIND_TRUE:
+		return 1;
+	case KIND_INTEGER:
+		return 1 + entry->count;
+	case KIND_FLOAT:
+		return 1 + 4;
+	case KIND_DOUBLE:
+	case KIND_DATE:
+		return 1 + 8;
+	case KIND_DATA:
+	case KIND_ASCII_STRING:
+		return addLength(headerLength(entry->count), entry->count);
+	case KIND_UTF16_STRING:
+		return addLength(headerLength(entry->count),
+		    multiplyLength(entry->count, 2));
+	case KIND_ARRAY:
+		return addLength(headerLength(entry->count),
+		    multiplyLength(entry->count, referenceSize));
+	case KIND_DICTIONARY:
+		return addLength(headerLength(entry->count),
+		    multiplyLength(entry->count, 2 * referenceSize));
+	default:
+		@throw [OFInvalidArgumentException exception];
+	}
+}
+
+static void
+writeEntry(unsigned char *buffer, const struct entry *entry,
+    const size_t *references, uint8_t referenceSize)
+{
+	size_t length;
+
+	switch (entry->kind) {
+	case KIND_NULL:
+		buffer[0] = 0x00;
+		break;
+	case KIND_FALSE:
+		buffer[0] = 0x08;
+		break;
+	case KIND_TRUE:
+		buffer[0] = 0x09;
+		break;
+	case KIND_INTEGER:
+		buffer[0] = 0x10 | exponentForSize(entry->count);
+
+		if (entry->count == 16) {
+			memset(buffer + 1, 0, 8);
+			writeBigEndian(buffer + 9,
+			    [entry->object uIntMaxValue], 8);
+		} else if (isNegative(entry->object))
+			writeBigEndian(buffer + 1,
+			    (uint64_t)[entry->object intMaxValue], 8);
+		else
+			writeBigEndian(buffer + 1,
+			    [entry->object uIntMaxValue], entry->count);
+
+		break;
+	case KIND_FLOAT:;
+		float floatValue = OF_BSWAP_FLOAT_IF_LE(
+		    [entry->object floatValue]);
+
+		buffer[0] = 0x22;
+		memcpy(buffer + 1, &floatValue, 4);
+		break;
+	case KIND_DOUBLE:;
+		double doubleValue = OF_BSWAP_DOUBLE_IF_LE(
+		    [entry->object doubleValue]);
+
+		buffer[0] = 0x23;
+		memcpy(buffer + 1, &doubleValue, 8);
+		break;
+	case KIND_DATE:;
+		double dateValue = OF_BSWAP_DOUBLE_IF_LE(
+		    [entry->object timeIntervalSince1970] - DATE_EPOCH);
+
+		buffer[0] = 0x33;
+		memcpy(buffer + 1, &dateValue, 8);
+		break;
+	case KIND_DATA:
+		length = writeHeader(buffer, 0x40, entry->count);
+		memcpy(buffer + length, [entry->object items], entry->count);
+		break;
+	case KIND_ASCII_STRING:
+		length = writeHeader(buffer, 0x50, entry->count);
+		memcpy(buffer + length, [entry->object UTF8String],
+		    entry->count);
+		break;
+	case KIND_UTF16_STRING:;
+		const of_unichar_t *characters = [entry->object characters];
+		size_t charactersLength = [entry->object length];
+
+		buffer += writeHeader(buffer, 0x60, entry->count);
+
+		for (size_t i = 0; i < charactersLength; i++) {
+			of_unichar_t c = characters[i];
+
+			if (c > 0xFFFF) {
+				c -= 0x10000;
+				writeBigEndian(buffer, 0xD800 | (c >> 10), 2);
+				writeBigEndian(buffer + 2,
+				    0xDC00 | (c & 0x3FF), 2);
+				buffer += 4;
+			} else {
+				writeBigEndian(buffer, c, 2);
+				buffer += 2;
+			}
+		}
+
+		break;
+	case KIND_ARRAY:
+	case KIND_DICTIONARY:;
+		size_t count = (entry->kind == KIND_DICTIONARY
+		    ? 2 * entry->count : entry->count);
+
+		buffer += writeHeader(buffer,
+		    (entry->kind == KIND_DICTIONARY ? 0xD0 : 0xA0),
+		    entry->count);
+
+		for (size_t i = 0; i < count; i++) {
+			writeBigEndian(buffer,
+			    references[entry->references + i], referenceSize);
+			buffer += referenceSize;
+		}
+
+		break;
+	}
+}
+
+@implementation OFBinaryPropertyListWriter
++ (OFData *)binaryPropertyListRepresentationOfObject:
+    (id <OFBinaryPropertyListRepresentation>)object
+{
+	void *pool = objc_autoreleasePoolPush();
+	struct writer writer = {
+		.nullIndex = SIZE_MAX,
+		.falseIndex = SIZE_MAX,
+		.trueIndex = SIZE_MAX
+	};
+	unsigned char *buffer = NULL;
+	OFData *ret;
+
+	@try {
+		uint8_t referenceSize, offsetSize;
+		size_t offsetTableOffset, length;
+		unsigned char *trailer;
+
+		writer.objects = [OFMapTable
+		    mapTableWithKeyFunctions: of_map_table_object_functions
+			     objectFunctions: indexFunctions];
+		writer.numbers = [OFMapTable
+		    mapTableWithKeyFunctions: numberFunctions
+			     objectFunctions: indexFunctions];
+
+		flattenObject(&writer, object);
+
+		/*
+		 * Now that the number of objects is known, the size of the
+		 * references and with it the offset of every object is known.
+		 */
+		referenceSize = sizeForValue(writer.entriesCount - 1);
+
+		offsetTableOffset = 8;
+		for (size_t i = 0; i < writer.entriesCount; i++) {
+			writer.entries[i].offset = offsetTableOffset;
+			offsetTableOffset = addLength(offsetTableOffset,
+			    lengthOfEntry(&writer.entries[i], referenceSize));
+		}
+
+		offsetSize = sizeForValue(
+		    writer.entries[writer.entriesCount - 1].offset);
+
+		length = addLength(offsetTableOffset,
+		    multiplyLength(writer.entriesCount, offsetSize));
+		length = addLength(length, TRAILER_SIZE);
+
+		if ((buffer = malloc(length)) == NULL)
+			@throw [OFOutOfMemoryException
+			    exceptionWithRequestedSize: length];
+
+		memcpy(buffer, "bplist00", 8);
+
+		for (size_t i = 0; i < writer.entriesCount; i++) {
+			const struct entry *entry = &writer.entries[i];
+
+			writeEntry(buffer + entry->offset, entry,
+			    writer.references, referenceSize);
+			writeBigEndian(
+			    buffer + offsetTableOffset + i * offsetSize,
+			    entry->offset, offsetSize);
+		}
+
+		trailer = buffer + length - TRAILER_SIZE;
+		memset(trailer, 0, 6);
+		trailer[6] = offsetSize;
+		trailer[7] = referenceSize;
+		writeBigEndian(trailer + 8, writer.entriesCount, 8);
+		/* The top object is always the first one. */
+		writeBigEndian(trailer + 16, 0, 8);
+		writeBigEndian(trailer + 24, offsetTableOffset, 8);
+
+		ret = [[OFData alloc] initWithItemsNoCopy: buffer
+						    count: length
+					     freeWhenDone: true];
+	} @catch (id e) {
+		free(buffer);
+		@throw e;
+	} @finally {
+		free(writer.entries);
+		free(writer.references);
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+@end
@@ -160,6 +160,20 @@ struct {
 				@throw [OFInvalidEncodingException exception];
 		}
 
+		/*
+		 * Literals are mostly used as dictionary keys and for
+		 * comparisons, so hash them right away while the string is
+		 * still in the cache from the check above.
+		 */
+		@try {
+			ivars->hash = of_string_utf8_hash(ivars->cString,
+			    ivars->cStringLength, ivars->isUTF8);
+		} @catch (id e) {
+			free(ivars);
+			@throw e;
+		}
+		ivars->hashed = true;
+
 		_cString = (char *)ivars;
 		object_setClass(self, [OFConstantUTF8String class]);
 	}
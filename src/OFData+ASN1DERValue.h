@@ -28,6 +28,17 @@ extern int _OFData_ASN1DERValue_reference;
 }
 #endif
 
+/*!
+ * @brief Options for parsing an ASN.1 DER representation.
+ */
+enum {
+	/*!
+	 * Return sequences and sets that only parse their contents when they
+	 * are accessed for the first time.
+	 */
+	OF_ASN1_DER_VALUE_LAZY = 0x01
+};
+
 @interface OFData (ASN1DERValue)
 /*!
  * @brief The data interpreted as ASN.1 in DER representation and parsed as an
@@ -49,6 +60,27 @@ extern int _OFData_ASN1DERValue_reference;
  * @return The ASN.1 DER representation as an object
  */
 - (id)ASN1DERValueWithDepthLimit: (size_t)depthLimit;
+
+/*!
+ * @brief Parses the ASN.1 DER representation with the specified options and
+ *	  returns it as an object.
+ *
+ * The contents of all values reference the data instead of a copy of it. If
+ * `OF_ASN1_DER_VALUE_LAZY` is specified, the contents of sequences and sets
+ * are only parsed when they are accessed for the first time, which means that
+ * errors inside of them are only reported then.
+ *
+ * @param options The options to use when parsing.@n
+ *		  Possible values are:
+ *		  Value                    | Description
+ *		  -------------------------|-----------------------------------
+ *		  `OF_ASN1_DER_VALUE_LAZY` | Parse sequences and sets lazily
+ * @param depthLimit The maximum depth the parser should accept (defaults to 32
+ *		     if not specified, 0 means no limit (insecure!))
+ * @return The ASN.1 DER representation as an object
+ */
+- (id)ASN1DERValueWithOptions: (int)options
+		   depthLimit: (size_t)depthLimit;
 @end
 
 OF_ASSUME_NONNULL_END
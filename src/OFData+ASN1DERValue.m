@@ -17,6 +17,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "OFData+ASN1DERValue.h"
 #import "OFASN1BitString.h"
 #import "OFASN1Boolean.h"
@@ -33,6 +35,10 @@
 #import "OFNull.h"
 #import "OFSet.h"
 
+#ifdef OF_HAVE_ATOMIC_OPS
+# import "atomic.h"
+#endif
+
 #import "OFInvalidArgumentException.h"
 #import "OFInvalidFormatException.h"
 #import "OFOutOfRangeException.h"
@@ -44,26 +50,49 @@ enum {
 
 int _OFData_ASN1DERValue_reference;
 
-static size_t parseObject(OFData *self, id *object, size_t depthLimit);
+@interface OFASN1DERLazySequence: OFArray
+{
+	OFData *_data;
+	of_range_t _range;
+	size_t _depthLimit, _count;
+	OFArray *_array;
+}
+
+- (instancetype)initWithData: (OFData *)data
+		       range: (of_range_t)range
+		  depthLimit: (size_t)depthLimit;
+@end
+
+@interface OFASN1DERLazySet: OFSet
+{
+	OFData *_data;
+	of_range_t _range;
+	size_t _depthLimit, _count;
+	OFSet *_set;
+}
+
+- (instancetype)initWithData: (OFData *)data
+		       range: (of_range_t)range
+		  depthLimit: (size_t)depthLimit;
+@end
+
+static size_t parseObject(OFData *data, size_t offset, size_t end, id *object,
+    size_t depthLimit, int options);
 
 static OFArray *
-parseSequence(OFData *contents, size_t depthLimit)
+parseSequence(OFData *data, of_range_t range, size_t depthLimit, int options)
 {
 	OFMutableArray *ret = [OFMutableArray array];
-	size_t count = contents.count;
+	size_t offset = range.location, end = range.location + range.length;
 
 	if (depthLimit == 0)
 		@throw [OFOutOfRangeException exception];
 
-	while (count > 0) {
+	while (offset < end) {
 		id object;
-		size_t objectLength;
-
-		objectLength = parseObject(contents, &object, depthLimit);
 
-		count -= objectLength;
-		contents = [contents subdataWithRange:
-		    of_range(objectLength, count)];
+		offset += parseObject(data, offset, end, &object, depthLimit,
+		    options);
 
 		[ret addObject: object];
 	}
@@ -74,36 +103,41 @@ parseSequence(OFData *contents, size_t depthLimit)
 }
 
 static OFSet *
-parseSet(OFData *contents, size_t depthLimit)
+parseSet(OFData *data, of_range_t range, size_t depthLimit, int options)
 {
 	OFMutableSet *ret = [OFMutableSet set];
-	size_t count = contents.count;
-	OFData *previousObjectData = nil;
+	const unsigned char *items = data.items;
+	size_t offset = range.location, end = range.location + range.length;
+	const unsigned char *previousObject = NULL;
+	size_t previousObjectLength = 0;
 
 	if (depthLimit == 0)
 		@throw [OFOutOfRangeException exception];
 
-	while (count > 0) {
+	while (offset < end) {
 		id object;
 		size_t objectLength;
-		OFData *objectData;
+		int comparison;
 
-		objectLength = parseObject(contents, &object, depthLimit);
-		objectData = [contents subdataWithRange:
-		    of_range(0, objectLength)];
+		objectLength = parseObject(data, offset, end, &object,
+		    depthLimit, options);
 
-		if (previousObjectData != nil &&
-		    [objectData compare: previousObjectData] !=
-		    OF_ORDERED_DESCENDING)
-			@throw [OFInvalidFormatException exception];
+		/* The encodings need to be in ascending order. */
+		if (previousObject != NULL) {
+			comparison = memcmp(items + offset, previousObject,
+			    (objectLength < previousObjectLength
+			    ? objectLength : previousObjectLength));
 
-		count -= objectLength;
-		contents = [contents subdataWithRange:
-		    of_range(objectLength, count)];
+			if (comparison < 0 || (comparison == 0 &&
+			    objectLength <= previousObjectLength))
+				@throw [OFInvalidFormatException exception];
+		}
 
-		[ret addObject: object];
+		previousObject = items + offset;
+		previousObjectLength = objectLength;
+		offset += objectLength;
 
-		previousObjectData = objectData;
+		[ret addObject: object];
 	}
 
 	[ret makeImmutable];
@@ -111,20 +145,22 @@ parseSet(OFData *contents, size_t depthLimit)
 	return ret;
 }
 
+/*
+ * Parses the tag and the length of the object at offset, which must end before
+ * end, and returns the number of bytes the whole object consumes.
+ */
 static size_t
-parseObject(OFData *self, id *object, size_t depthLimit)
+parseHeader(OFData *data, size_t offset, size_t end, unsigned char *tag,
+    of_range_t *contentsRange)
 {
-	const unsigned char *items = self.items;
-	size_t count = self.count;
-	unsigned char tag;
+	const unsigned char *items = (const unsigned char *)data.items + offset;
+	size_t count = end - offset;
 	size_t contentsLength, bytesConsumed = 0;
-	Class valueClass;
-	OFData *contents;
 
 	if (count < 2)
 		@throw [OFTruncatedDataException exception];
 
-	tag = *items++;
+	*tag = *items++;
 	contentsLength = *items++;
 	bytesConsumed += 2;
 
@@ -156,9 +192,45 @@ parseObject(OFData *self, id *object, size_t depthLimit)
 	if (count - bytesConsumed < contentsLength)
 		@throw [OFTruncatedDataException exception];
 
-	contents = [self subdataWithRange:
-	    of_range(bytesConsumed, contentsLength)];
-	bytesConsumed += contentsLength;
+	*contentsRange = of_range(offset + bytesConsumed, contentsLength);
+
+	return bytesConsumed + contentsLength;
+}
+
+/* Returns the number of objects in range by only looking at their headers. */
+static size_t
+countObjects(OFData *data, of_range_t range)
+{
+	size_t count = 0;
+	size_t offset = range.location, end = range.location + range.length;
+
+	while (offset < end) {
+		unsigned char tag;
+		of_range_t contentsRange;
+
+		offset += parseHeader(data, offset, end, &tag, &contentsRange);
+		count++;
+	}
+
+	return count;
+}
+
+/*
+ * Parses the object at offset, which must end before end, and returns the
+ * number of bytes it consumed. Contents reference the data instead of being
+ * copied.
+ */
+static size_t
+parseObject(OFData *data, size_t offset, size_t end, id *object,
+    size_t depthLimit, int options)
+{
+	unsigned char tag;
+	of_range_t contentsRange;
+	size_t contentsLength, bytesConsumed;
+	Class valueClass;
+
+	bytesConsumed = parseHeader(data, offset, end, &tag, &contentsRange);
+	contentsLength = contentsRange.length;
 
 	switch (tag & ~ASN1_TAG_CONSTRUCTED_MASK) {
 	case OF_ASN1_TAG_NUMBER_BOOLEAN:
@@ -177,7 +249,7 @@ parseObject(OFData *self, id *object, size_t depthLimit)
 		if (tag & ASN1_TAG_CONSTRUCTED_MASK)
 			@throw [OFInvalidFormatException exception];
 
-		if (contents.count != 0)
+		if (contentsLength != 0)
 			@throw [OFInvalidFormatException exception];
 
 		*object = [OFNull null];
@@ -195,13 +267,29 @@ parseObject(OFData *self, id *object, size_t depthLimit)
 		if (!(tag & ASN1_TAG_CONSTRUCTED_MASK))
 			@throw [OFInvalidFormatException exception];
 
-		*object = parseSequence(contents, depthLimit - 1);
+		if (options & OF_ASN1_DER_VALUE_LAZY)
+			*object = [[[OFASN1DERLazySequence alloc]
+			    initWithData: data
+				   range: contentsRange
+			      depthLimit: depthLimit - 1] autorelease];
+		else
+			*object = parseSequence(data, contentsRange,
+			    depthLimit - 1, options);
+
 		return bytesConsumed;
 	case OF_ASN1_TAG_NUMBER_SET:
 		if (!(tag & ASN1_TAG_CONSTRUCTED_MASK))
 			@throw [OFInvalidFormatException exception];
 
-		*object = parseSet(contents, depthLimit - 1);
+		if (options & OF_ASN1_DER_VALUE_LAZY)
+			*object = [[[OFASN1DERLazySet alloc]
+			    initWithData: data
+				   range: contentsRange
+			      depthLimit: depthLimit - 1] autorelease];
+		else
+			*object = parseSet(data, contentsRange, depthLimit - 1,
+			    options);
+
 		return bytesConsumed;
 	case OF_ASN1_TAG_NUMBER_NUMERIC_STRING:
 		valueClass = [OFASN1NumericString class];
@@ -221,10 +309,191 @@ parseObject(OFData *self, id *object, size_t depthLimit)
 	      initWithTagClass: tag >> 6
 		     tagNumber: tag & 0x1F
 		   constructed: tag & ASN1_TAG_CONSTRUCTED_MASK
-	    DEREncodedContents: contents] autorelease];
+	    DEREncodedContents: [data subdataWithRange: contentsRange]]
+	    autorelease];
 	return bytesConsumed;
 }
 
+@implementation OFASN1DERLazySequence
+- (instancetype)initWithData: (OFData *)data
+		       range: (of_range_t)range
+		  depthLimit: (size_t)depthLimit
+{
+	self = [super init];
+
+	@try {
+		/* Checked now so that the depth limit behaves the same. */
+		if (depthLimit == 0)
+			@throw [OFOutOfRangeException exception];
+
+		/*
+		 * Counting only walks the headers, so that -[count] does not
+		 * need to parse all objects.
+		 */
+		_count = countObjects(data, range);
+		_data = [data retain];
+		_range = range;
+		_depthLimit = depthLimit;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+	[_array release];
+
+	[super dealloc];
+}
+
+- (OFArray *)of_array
+{
+	OFArray *array;
+	void *pool;
+
+	if (_array != nil)
+		return _array;
+
+	pool = objc_autoreleasePoolPush();
+	array = [parseSequence(_data, _range, _depthLimit,
+	    OF_ASN1_DER_VALUE_LAZY) retain];
+	objc_autoreleasePoolPop(pool);
+
+#if defined(OF_HAVE_ATOMIC_OPS) && !defined(__clang_analyzer__)
+	if (!of_atomic_ptr_cmpswap((void **)&_array, nil, array))
+		[array release];
+#else
+	@synchronized (self) {
+		if (_array == nil)
+			_array = array;
+		else
+			[array release];
+	}
+#endif
+
+	return _array;
+}
+
+- (size_t)count
+{
+	return _count;
+}
+
+- (id)objectAtIndex: (size_t)idx
+{
+	return [[self of_array] objectAtIndex: idx];
+}
+
+- (void)getObjects: (id *)buffer
+	   inRange: (of_range_t)range
+{
+	[[self of_array] getObjects: buffer
+			    inRange: range];
+}
+
+- (int)countByEnumeratingWithState: (of_fast_enumeration_state_t *)state
+			   objects: (id *)objects
+			     count: (int)count
+{
+	return [[self of_array] countByEnumeratingWithState: state
+						    objects: objects
+						      count: count];
+}
+@end
+
+@implementation OFASN1DERLazySet
+- (instancetype)initWithData: (OFData *)data
+		       range: (of_range_t)range
+		  depthLimit: (size_t)depthLimit
+{
+	self = [super init];
+
+	@try {
+		/* Checked now so that the depth limit behaves the same. */
+		if (depthLimit == 0)
+			@throw [OFOutOfRangeException exception];
+
+		/*
+		 * Counting only walks the headers, so that -[count] does not
+		 * need to parse all objects.
+		 */
+		_count = countObjects(data, range);
+		_data = [data retain];
+		_range = range;
+		_depthLimit = depthLimit;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+	[_set release];
+
+	[super dealloc];
+}
+
+- (OFSet *)of_set
+{
+	OFSet *set;
+	void *pool;
+
+	if (_set != nil)
+		return _set;
+
+	pool = objc_autoreleasePoolPush();
+	set = [parseSet(_data, _range, _depthLimit,
+	    OF_ASN1_DER_VALUE_LAZY) retain];
+	objc_autoreleasePoolPop(pool);
+
+#if defined(OF_HAVE_ATOMIC_OPS) && !defined(__clang_analyzer__)
+	if (!of_atomic_ptr_cmpswap((void **)&_set, nil, set))
+		[set release];
+#else
+	@synchronized (self) {
+		if (_set == nil)
+			_set = set;
+		else
+			[set release];
+	}
+#endif
+
+	return _set;
+}
+
+- (size_t)count
+{
+	return _count;
+}
+
+- (bool)containsObject: (id)object
+{
+	return [[self of_set] containsObject: object];
+}
+
+- (OFEnumerator *)objectEnumerator
+{
+	return [[self of_set] objectEnumerator];
+}
+
+- (int)countByEnumeratingWithState: (of_fast_enumeration_state_t *)state
+			   objects: (id *)objects
+			     count: (int)count
+{
+	return [[self of_set] countByEnumeratingWithState: state
+						  objects: objects
+						    count: count];
+}
+@end
+
 @implementation OFData (ASN1DERValue)
 - (id)ASN1DERValue
 {
@@ -232,14 +501,29 @@ parseObject(OFData *self, id *object, size_t depthLimit)
 }
 
 - (id)ASN1DERValueWithDepthLimit: (size_t)depthLimit
+{
+	return [self ASN1DERValueWithOptions: 0
+				  depthLimit: depthLimit];
+}
+
+- (id)ASN1DERValueWithOptions: (int)options
+		   depthLimit: (size_t)depthLimit
 {
 	void *pool = objc_autoreleasePoolPush();
+	OFData *data;
 	id object;
 
 	if (self.itemSize != 1)
 		@throw [OFInvalidArgumentException exception];
 
-	if (parseObject(self, &object, depthLimit) != self.count)
+	/*
+	 * Values reference the data, so it must not change. For immutable
+	 * data, this is only a retain.
+	 */
+	data = [[self copy] autorelease];
+
+	if (parseObject(data, 0, data.count, &object, depthLimit,
+	    options) != data.count)
 		@throw [OFInvalidFormatException exception];
 
 	[object retain];
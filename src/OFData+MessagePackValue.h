@@ -27,6 +27,17 @@ extern int _OFData_MessagePackValue_reference;
 }
 #endif
 
+/*!
+ * @brief Options for parsing a MessagePack representation.
+ */
+enum {
+	/*!
+	 * Return binary data and the data of extensions as OFData that
+	 * references the parsed data instead of a copy.
+	 */
+	OF_MESSAGE_PACK_VALUE_NO_COPY = 0x01
+};
+
 @interface OFData (MessagePackValue)
 /*!
  * @brief The data interpreted as MessagePack representation and parsed as an
@@ -42,6 +53,22 @@ extern int _OFData_MessagePackValue_reference;
  * @return The MessagePack representation as an object
  */
 - (id)messagePackValueWithDepthLimit: (size_t)depthLimit;
+
+/*!
+ * @brief Parses the MessagePack representation with the specified options and
+ *	  returns it as an object.
+ *
+ * @param options The options to use when parsing.@n
+ *		  Possible values are:
+ *		  Value                           | Description
+ *		  --------------------------------|------------------------
+ *		  `OF_MESSAGE_PACK_VALUE_NO_COPY` | Don't copy binary data
+ * @param depthLimit The maximum depth the parser should accept (defaults to 32
+ *		     if not specified, 0 means no limit (insecure!))
+ * @return The MessagePack representation as an object
+ */
+- (id)messagePackValueWithOptions: (int)options
+		       depthLimit: (size_t)depthLimit;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -0,0 +1,733 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFData+PropertyListValue.h"
+#import "OFArray.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+#import "OFString.h"
+#import "OFString+PropertyListValue.h"
+
+#ifdef OF_HAVE_ATOMIC_OPS
+# import "atomic.h"
+#endif
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+#import "OFUnsupportedVersionException.h"
+
+/* Dates are stored relative to 2001-01-01 00:00:00 UTC. */
+#define DATE_EPOCH 978307200
+#define TRAILER_SIZE 32
+#define DEPTH_LIMIT 32
+
+int _OFData_PropertyListValue_reference;
+
+@interface OFBinaryPropertyList: OFObject
+{
+@public
+	OFData *_data;
+	const unsigned char *_items;
+	size_t _objectsCount, _topObject, _offsetTableOffset;
+	uint8_t _offsetSize, _referenceSize;
+	/* Strings, numbers, data and dates that have been created already */
+	id _Nullable *_objects;
+}
+
+- (instancetype)initWithData: (OFData *)data;
+- (size_t)referenceAtOffset: (size_t)offset;
+- (id)objectForReference: (size_t)reference
+		   depth: (size_t)depth;
+@end
+
+@interface OFBinaryPropertyListArray: OFArray
+{
+	OFBinaryPropertyList *_propertyList;
+	size_t _references, _count, _depth;
+	OFArray *_array;
+}
+
+- (instancetype)initWithPropertyList: (OFBinaryPropertyList *)propertyList
+			  references: (size_t)references
+			       count: (size_t)count
+			       depth: (size_t)depth;
+@end
+
+@interface OFBinaryPropertyListDictionary: OFDictionary
+{
+	OFBinaryPropertyList *_propertyList;
+	size_t _references, _count, _depth;
+	OFDictionary *_dictionary;
+}
+
+- (instancetype)initWithPropertyList: (OFBinaryPropertyList *)propertyList
+			  references: (size_t)references
+			       count: (size_t)count
+			       depth: (size_t)depth;
+@end
+
+static uint64_t
+readBigEndian(const unsigned char *buffer, size_t size)
+{
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < size; i++)
+		value = (value << 8) | buffer[i];
+
+	return value;
+}
+
+static bool
+isValidSize(uint8_t size)
+{
+	return (size == 1 || size == 2 || size == 4 || size == 8);
+}
+
+/*
+ * Replaces the object with the one that is already cached for the reference
+ * or caches it.
+ */
+static id
+cacheObject(OFBinaryPropertyList *propertyList, size_t reference, id object)
+{
+#if defined(OF_HAVE_ATOMIC_OPS) && !defined(__clang_analyzer__)
+	[object retain];
+
+	if (!of_atomic_ptr_cmpswap((void **)&propertyList->_objects[reference],
+	    nil, object)) {
+		[object release];
+		object = propertyList->_objects[reference];
+	}
+#else
+	@synchronized (propertyList) {
+		if (propertyList->_objects[reference] == nil)
+			propertyList->_objects[reference] = [object retain];
+		else
+			object = propertyList->_objects[reference];
+	}
+#endif
+
+	return object;
+}
+
+@implementation OFBinaryPropertyList
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [super init];
+
+	@try {
+		const unsigned char *trailer;
+		size_t length;
+		uint64_t objectsCount, topObject, offsetTableOffset;
+
+		/* Make sure the items can't change while we reference them. */
+		_data = [data copy];
+		_items = _data.items;
+		length = _data.count;
+
+		if (length < 8 + TRAILER_SIZE)
+			@throw [OFInvalidFormatException exception];
+
+		trailer = _items + length - TRAILER_SIZE;
+		_offsetSize = trailer[6];
+		_referenceSize = trailer[7];
+		objectsCount = readBigEndian(trailer + 8, 8);
+		topObject = readBigEndian(trailer + 16, 8);
+		offsetTableOffset = readBigEndian(trailer + 24, 8);
+
+		if (!isValidSize(_offsetSize) || !isValidSize(_referenceSize))
+			@throw [OFInvalidFormatException exception];
+
+		if (objectsCount == 0 || topObject >= objectsCount ||
+		    offsetTableOffset < 8 ||
+		    offsetTableOffset > length - TRAILER_SIZE)
+			@throw [OFInvalidFormatException exception];
+
+		/* The offset table must fit between the objects and trailer. */
+		if ((length - TRAILER_SIZE - offsetTableOffset) / _offsetSize <
+		    objectsCount)
+			@throw [OFInvalidFormatException exception];
+
+		_objectsCount = (size_t)objectsCount;
+		_topObject = (size_t)topObject;
+		_offsetTableOffset = (size_t)offsetTableOffset;
+
+		_objects = [self allocMemoryWithSize: sizeof(id)
+					       count: _objectsCount];
+		memset(_objects, 0, _objectsCount * sizeof(id));
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_objects != NULL)
+		for (size_t i = 0; i < _objectsCount; i++)
+			[_objects[i] release];
+
+	[_data release];
+
+	[super dealloc];
+}
+
+/* Checks that length bytes at offset are part of the object table. */
+- (void)of_checkOffset: (size_t)offset
+		length: (size_t)length
+{
+	if (offset > _offsetTableOffset ||
+	    _offsetTableOffset - offset < length)
+		@throw [OFInvalidFormatException exception];
+}
+
+- (size_t)referenceAtOffset: (size_t)offset
+{
+	uint64_t reference = readBigEndian(_items + offset, _referenceSize);
+
+	if (reference >= _objectsCount)
+		@throw [OFInvalidFormatException exception];
+
+	return (size_t)reference;
+}
+
+/*
+ * Returns the count in the lower nibble of the marker at offset, which is
+ * followed by an integer if it does not fit, and stores the offset of what
+ * follows in start.
+ */
+- (size_t)of_countAtOffset: (size_t)offset
+		     start: (size_t *)start
+{
+	uint8_t marker = _items[offset];
+	size_t size;
+	uint64_t count;
+
+	if ((marker & 0x0F) != 0x0F) {
+		*start = offset + 1;
+		return marker & 0x0F;
+	}
+
+	[self of_checkOffset: offset + 1
+		      length: 1];
+
+	marker = _items[offset + 1];
+	if ((marker & 0xF0) != 0x10 || (marker & 0x0F) > 3)
+		@throw [OFInvalidFormatException exception];
+
+	size = (size_t)1 << (marker & 0x0F);
+	[self of_checkOffset: offset + 2
+		      length: size];
+
+	count = readBigEndian(_items + offset + 2, size);
+	if (count > SIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	*start = offset + 2 + size;
+	return (size_t)count;
+}
+
+- (OFNumber *)of_integerAtOffset: (size_t)offset
+			  marker: (uint8_t)marker
+{
+	size_t size;
+	uint64_t value;
+
+	if ((marker & 0x0F) > 4)
+		@throw [OFInvalidFormatException exception];
+
+	size = (size_t)1 << (marker & 0x0F);
+	[self of_checkOffset: offset + 1
+		      length: size];
+
+	if (size == 16) {
+		uint64_t high = readBigEndian(_items + offset + 1, 8);
+
+		value = readBigEndian(_items + offset + 9, 8);
+
+		if (high == 0)
+			return [OFNumber numberWithUInt64: value];
+
+		if (high == UINT64_MAX && value > INT64_MAX)
+			return [OFNumber numberWithInt64: (int64_t)value];
+
+		@throw [OFOutOfRangeException exception];
+	}
+
+	value = readBigEndian(_items + offset + 1, size);
+
+	/* Integers of 8 bytes are signed, smaller ones unsigned. */
+	if (size == 8)
+		return [OFNumber numberWithInt64: (int64_t)value];
+
+	return [OFNumber numberWithIntMax: (intmax_t)value];
+}
+
+- (OFNumber *)of_realAtOffset: (size_t)offset
+		       marker: (uint8_t)marker
+{
+	if (marker == 0x22) {
+		float value;
+
+		[self of_checkOffset: offset + 1
+			      length: 4];
+		memcpy(&value, _items + offset + 1, 4);
+
+		return [OFNumber numberWithFloat: OF_BSWAP_FLOAT_IF_LE(value)];
+	}
+
+	if (marker == 0x23) {
+		double value;
+
+		[self of_checkOffset: offset + 1
+			      length: 8];
+		memcpy(&value, _items + offset + 1, 8);
+
+		return [OFNumber numberWithDouble:
+		    OF_BSWAP_DOUBLE_IF_LE(value)];
+	}
+
+	@throw [OFInvalidFormatException exception];
+}
+
+- (OFDate *)of_dateAtOffset: (size_t)offset
+		     marker: (uint8_t)marker
+{
+	double value;
+
+	if (marker != 0x33)
+		@throw [OFInvalidFormatException exception];
+
+	[self of_checkOffset: offset + 1
+		      length: 8];
+	memcpy(&value, _items + offset + 1, 8);
+
+	return [OFDate dateWithTimeIntervalSince1970:
+	    OF_BSWAP_DOUBLE_IF_LE(value) + DATE_EPOCH];
+}
+
+- (OFString *)of_UTF16StringAtOffset: (size_t)offset
+{
+	void *pool;
+	size_t start, length;
+	const of_char16_t *characters;
+	OFString *ret;
+
+	length = [self of_countAtOffset: offset
+				  start: &start];
+
+	if (length > SIZE_MAX / 2)
+		@throw [OFOutOfRangeException exception];
+
+	[self of_checkOffset: start
+		      length: length * 2];
+
+	pool = objc_autoreleasePoolPush();
+
+	/* Nothing guarantees that the characters are aligned. */
+	if ((uintptr_t)(_items + start) % sizeof(of_char16_t) == 0)
+		characters = (const of_char16_t *)(void *)(_items + start);
+	else
+		characters = [OFMutableData dataWithItems: _items + start
+						    count: length * 2]
+		    .mutableItems;
+
+	ret = [[OFString alloc] initWithUTF16String: characters
+					     length: length
+					  byteOrder: OF_BYTE_ORDER_BIG_ENDIAN];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+
+- (id)objectForReference: (size_t)reference
+		   depth: (size_t)depth
+{
+	size_t offset, start, count;
+	uint8_t marker;
+	id object;
+
+	if (reference >= _objectsCount)
+		@throw [OFInvalidFormatException exception];
+
+	if ((object = _objects[reference]) != nil)
+		return object;
+
+	offset = (size_t)readBigEndian(
+	    _items + _offsetTableOffset + reference * _offsetSize, _offsetSize);
+	if (offset < 8 || offset >= _offsetTableOffset)
+		@throw [OFInvalidFormatException exception];
+
+	marker = _items[offset];
+
+	switch (marker >> 4) {
+	case 0x0:
+		if (marker == 0x00)
+			object = [OFNull null];
+		else if (marker == 0x08)
+			object = [OFNumber numberWithBool: false];
+		else if (marker == 0x09)
+			object = [OFNumber numberWithBool: true];
+		else
+			@throw [OFInvalidFormatException exception];
+
+		break;
+	case 0x1:
+		object = [self of_integerAtOffset: offset
+					   marker: marker];
+		break;
+	case 0x2:
+		object = [self of_realAtOffset: offset
+					marker: marker];
+		break;
+	case 0x3:
+		object = [self of_dateAtOffset: offset
+					marker: marker];
+		break;
+	case 0x4:
+		count = [self of_countAtOffset: offset
+					 start: &start];
+		[self of_checkOffset: start
+			      length: count];
+
+		object = [_data subdataWithRange: of_range(start, count)];
+		break;
+	case 0x5:
+		count = [self of_countAtOffset: offset
+					 start: &start];
+		[self of_checkOffset: start
+			      length: count];
+
+		object = [OFString
+		    stringWithCString: (const char *)_items + start
+			     encoding: OF_STRING_ENCODING_ASCII
+			       length: count];
+		break;
+	case 0x6:
+		object = [self of_UTF16StringAtOffset: offset];
+		break;
+	case 0xA:
+	case 0xD:
+		count = [self of_countAtOffset: offset
+					 start: &start];
+
+		if (count > SIZE_MAX / 2 / _referenceSize)
+			@throw [OFOutOfRangeException exception];
+
+		[self of_checkOffset: start
+			      length: count * _referenceSize *
+				      (marker >> 4 == 0xD ? 2 : 1)];
+
+		if (depth >= DEPTH_LIMIT)
+			@throw [OFOutOfRangeException exception];
+
+		/*
+		 * Containers are not cached, as they reference the property
+		 * list, which would create a retain cycle.
+		 */
+		if (marker >> 4 == 0xA)
+			return [[[OFBinaryPropertyListArray alloc]
+			    initWithPropertyList: self
+				      references: start
+					   count: count
+					   depth: depth + 1] autorelease];
+		else
+			return [[[OFBinaryPropertyListDictionary alloc]
+			    initWithPropertyList: self
+				      references: start
+					   count: count
+					   depth: depth + 1] autorelease];
+	default:
+		/* UIDs and sets are not supported by property lists. */
+		@throw [OFInvalidFormatException exception];
+	}
+
+	return cacheObject(self, reference, object);
+}
+@end
+
+@implementation OFBinaryPropertyListArray
+- (instancetype)initWithPropertyList: (OFBinaryPropertyList *)propertyList
+			  references: (size_t)references
+			       count: (size_t)count
+			       depth: (size_t)depth
+{
+	self = [super init];
+
+	_propertyList = [propertyList retain];
+	_references = references;
+	_count = count;
+	_depth = depth;
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_propertyList release];
+	[_array release];
+
+	[super dealloc];
+}
+
+- (OFArray *)of_array
+{
+	OFMutableArray *array;
+	void *pool;
+
+	if (_array != nil)
+		return _array;
+
+	array = [[OFMutableArray alloc] initWithCapacity: _count];
+	pool = objc_autoreleasePoolPush();
+
+	@try {
+		size_t offset = _references;
+
+		for (size_t i = 0; i < _count; i++) {
+			size_t reference =
+			    [_propertyList referenceAtOffset: offset];
+
+			[array addObject:
+			    [_propertyList objectForReference: reference
+							depth: _depth]];
+
+			offset += _propertyList->_referenceSize;
+		}
+
+		[array makeImmutable];
+	} @catch (id e) {
+		[array release];
+		@throw e;
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+#if defined(OF_HAVE_ATOMIC_OPS) && !defined(__clang_analyzer__)
+	if (!of_atomic_ptr_cmpswap((void **)&_array, nil, array))
+		[array release];
+#else
+	@synchronized (self) {
+		if (_array == nil)
+			_array = array;
+		else
+			[array release];
+	}
+#endif
+
+	return _array;
+}
+
+- (size_t)count
+{
+	return _count;
+}
+
+- (id)objectAtIndex: (size_t)idx
+{
+	if (idx >= _count)
+		@throw [OFOutOfRangeException exception];
+
+	return [[self of_array] objectAtIndex: idx];
+}
+
+- (void)getObjects: (id *)buffer
+	   inRange: (of_range_t)range
+{
+	[[self of_array] getObjects: buffer
+			    inRange: range];
+}
+
+- (int)countByEnumeratingWithState: (of_fast_enumeration_state_t *)state
+			   objects: (id *)objects
+			     count: (int)count
+{
+	return [[self of_array] countByEnumeratingWithState: state
+						    objects: objects
+						      count: count];
+}
+@end
+
+@implementation OFBinaryPropertyListDictionary
+- (instancetype)initWithPropertyList: (OFBinaryPropertyList *)propertyList
+			  references: (size_t)references
+			       count: (size_t)count
+			       depth: (size_t)depth
+{
+	self = [super init];
+
+	_propertyList = [propertyList retain];
+	_references = references;
+	_count = count;
+	_depth = depth;
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_propertyList release];
+	[_dictionary release];
+
+	[super dealloc];
+}
+
+- (OFDictionary *)of_dictionary
+{
+	OFMutableDictionary *dictionary;
+	void *pool;
+
+	if (_dictionary != nil)
+		return _dictionary;
+
+	dictionary = [[OFMutableDictionary alloc] initWithCapacity: _count];
+	pool = objc_autoreleasePoolPush();
+
+	@try {
+		size_t referenceSize = _propertyList->_referenceSize;
+		size_t keyOffset = _references;
+		size_t objectOffset = _references + _count * referenceSize;
+
+		for (size_t i = 0; i < _count; i++) {
+			size_t keyReference =
+			    [_propertyList referenceAtOffset: keyOffset];
+			size_t objectReference =
+			    [_propertyList referenceAtOffset: objectOffset];
+			id key = [_propertyList objectForReference: keyReference
+							     depth: _depth];
+
+			if (![key isKindOfClass: [OFString class]])
+				@throw [OFInvalidFormatException exception];
+
+			[dictionary setObject: [_propertyList
+						   objectForReference:
+						   objectReference
+						   depth: _depth]
+				       forKey: key];
+
+			keyOffset += referenceSize;
+			objectOffset += referenceSize;
+		}
+
+		/* Duplicate keys would make the count wrong. */
+		if (dictionary.count != _count)
+			@throw [OFInvalidFormatException exception];
+
+		[dictionary makeImmutable];
+	} @catch (id e) {
+		[dictionary release];
+		@throw e;
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+#if defined(OF_HAVE_ATOMIC_OPS) && !defined(__clang_analyzer__)
+	if (!of_atomic_ptr_cmpswap((void **)&_dictionary, nil, dictionary))
+		[dictionary release];
+#else
+	@synchronized (self) {
+		if (_dictionary == nil)
+			_dictionary = dictionary;
+		else
+			[dictionary release];
+	}
+#endif
+
+	return _dictionary;
+}
+
+- (size_t)count
+{
+	return _count;
+}
+
+- (id)objectForKey: (id)key
+{
+	return [[self of_dictionary] objectForKey: key];
+}
+
+- (OFEnumerator *)keyEnumerator
+{
+	return [[self of_dictionary] keyEnumerator];
+}
+
+- (OFEnumerator *)objectEnumerator
+{
+	return [[self of_dictionary] objectEnumerator];
+}
+
+- (int)countByEnumeratingWithState: (of_fast_enumeration_state_t *)state
+			   objects: (id *)objects
+			     count: (int)count
+{
+	return [[self of_dictionary] countByEnumeratingWithState: state
+							 objects: objects
+							   count: count];
+}
+@end
+
+@implementation OFData (PropertyListValue)
+- (id)propertyListValue
+{
+	void *pool = objc_autoreleasePoolPush();
+	const unsigned char *items = self.items;
+	size_t count = self.count;
+	id ret;
+
+	if (self.itemSize != 1)
+		@throw [OFInvalidArgumentException exception];
+
+	if (count >= 8 && memcmp(items, "bplist", 6) == 0) {
+		OFBinaryPropertyList *propertyList;
+
+		if (memcmp(items + 6, "00", 2) != 0)
+			@throw [OFUnsupportedVersionException
+			    exceptionWithVersion: [OFString
+			    stringWithCString: (const char *)items + 6
+				     encoding: OF_STRING_ENCODING_ASCII
+				       length: 2]];
+
+		propertyList = [[OFBinaryPropertyList alloc]
+		    initWithData: self];
+
+		@try {
+			ret = [propertyList
+			    objectForReference: propertyList->_topObject
+					 depth: 0];
+		} @finally {
+			[propertyList release];
+		}
+	} else
+		ret = [[OFString stringWithUTF8String: (const char *)items
+					       length: count]
+		    propertyListValue];
+
+	[ret retain];
+	objc_autoreleasePoolPop(pool);
+	return [ret autorelease];
+}
+@end
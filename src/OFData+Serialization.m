@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFData+Serialization.h"
+#import "OFArray.h"
+#import "OFSerialization+Private.h"
+#import "OFString.h"
+#import "OFString+Serialization.h"
+#import "OFXMLCDATA.h"
+#import "OFXMLCharacters.h"
+#import "OFXMLElement.h"
+#import "OFXMLElement+Serialization.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+#import "OFTruncatedDataException.h"
+#import "OFUnsupportedVersionException.h"
+
+/* Same as the default of OFXMLParser, which limits XML serializations */
+#define DEPTH_LIMIT 32
+#define NUMBER_BITS (sizeof(uintmax_t) * 8)
+
+int _OFData_Serialization_reference;
+
+struct deserializer {
+	const unsigned char *items;
+	size_t length, position;
+	OFMutableArray OF_GENERIC(OFString *) *names, *values;
+};
+
+static uintmax_t
+readNumber(struct deserializer *deserializer)
+{
+	uintmax_t number = 0;
+	unsigned int shift = 0;
+
+	for (;;) {
+		uint8_t byte;
+
+		if (deserializer->position >= deserializer->length)
+			@throw [OFTruncatedDataException exception];
+
+		byte = deserializer->items[deserializer->position++];
+
+		if (shift >= NUMBER_BITS || (shift > NUMBER_BITS - 7 &&
+		    (byte & 0x7F) >> (NUMBER_BITS - shift) != 0))
+			@throw [OFOutOfRangeException exception];
+
+		number |= (uintmax_t)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80))
+			return number;
+
+		shift += 7;
+	}
+}
+
+static size_t
+readCount(struct deserializer *deserializer)
+{
+	uintmax_t count = readNumber(deserializer);
+
+	if (count > SIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	return (size_t)count;
+}
+
+static OFString *
+readString(struct deserializer *deserializer, OFMutableArray *table)
+{
+	uintmax_t reference = readNumber(deserializer);
+	OFString *string;
+	size_t length;
+
+	if (reference == OF_BINARY_SERIALIZATION_NIL)
+		return nil;
+
+	if (reference != OF_BINARY_SERIALIZATION_NEW_STRING) {
+		reference -= OF_BINARY_SERIALIZATION_FIRST_INDEX;
+
+		if (reference >= table.count)
+			@throw [OFInvalidFormatException exception];
+
+		return [table objectAtIndex: (size_t)reference];
+	}
+
+	length = readCount(deserializer);
+
+	if (deserializer->length - deserializer->position < length)
+		@throw [OFTruncatedDataException exception];
+
+	string = [OFString stringWithUTF8String: (const char *)
+	    deserializer->items + deserializer->position
+					 length: length];
+	deserializer->position += length;
+
+	[table addObject: string];
+
+	return string;
+}
+
+static OFString *
+readNonnullString(struct deserializer *deserializer, OFMutableArray *table)
+{
+	OFString *string = readString(deserializer, table);
+
+	if (string == nil)
+		@throw [OFInvalidFormatException exception];
+
+	return string;
+}
+
+static OFXMLNode *
+readNode(struct deserializer *deserializer, size_t depth)
+{
+	uint8_t type;
+
+	if (deserializer->position >= deserializer->length)
+		@throw [OFTruncatedDataException exception];
+
+	type = deserializer->items[deserializer->position++];
+
+	switch (type) {
+	case OF_BINARY_SERIALIZATION_ELEMENT:;
+		OFXMLElement *element;
+		OFString *name, *namespace;
+		size_t count;
+
+		if (depth >= DEPTH_LIMIT)
+			@throw [OFOutOfRangeException exception];
+
+		name = readNonnullString(deserializer, deserializer->names);
+		namespace = readString(deserializer, deserializer->names);
+		element = [OFXMLElement elementWithName: name
+					      namespace: namespace];
+
+		count = readCount(deserializer);
+		for (size_t i = 0; i < count; i++) {
+			OFString *attributeName, *attributeNamespace;
+			OFString *attributeValue;
+
+			attributeName = readNonnullString(deserializer,
+			    deserializer->names);
+			attributeNamespace = readString(deserializer,
+			    deserializer->names);
+
+			attributeValue = readNonnullString(deserializer,
+			    deserializer->values);
+
+			[element addAttributeWithName: attributeName
+					    namespace: attributeNamespace
+					  stringValue: attributeValue];
+		}
+
+		count = readCount(deserializer);
+		for (size_t i = 0; i < count; i++) {
+			void *pool = objc_autoreleasePoolPush();
+
+			[element addChild: readNode(deserializer, depth + 1)];
+
+			objc_autoreleasePoolPop(pool);
+		}
+
+		return element;
+	case OF_BINARY_SERIALIZATION_CHARACTERS:
+		return [OFXMLCharacters charactersWithString:
+		    readNonnullString(deserializer, deserializer->values)];
+	case OF_BINARY_SERIALIZATION_CDATA:
+		return [OFXMLCDATA CDATAWithString:
+		    readNonnullString(deserializer, deserializer->values)];
+	default:
+		@throw [OFInvalidFormatException exception];
+	}
+}
+
+@implementation OFData (Serialization)
+- (id)objectByDeserializing
+{
+	void *pool = objc_autoreleasePoolPush();
+	struct deserializer deserializer;
+	id object;
+
+	if (self.itemSize != 1)
+		@throw [OFInvalidArgumentException exception];
+
+	deserializer.items = self.items;
+	deserializer.length = self.count;
+
+	if (deserializer.length >= OF_BINARY_SERIALIZATION_MAGIC_LENGTH &&
+	    memcmp(deserializer.items, OF_BINARY_SERIALIZATION_MAGIC,
+	    OF_BINARY_SERIALIZATION_MAGIC_LENGTH) == 0) {
+		OFXMLNode *root;
+		uint8_t version;
+
+		if (deserializer.length == OF_BINARY_SERIALIZATION_MAGIC_LENGTH)
+			@throw [OFTruncatedDataException exception];
+
+		version =
+		    deserializer.items[OF_BINARY_SERIALIZATION_MAGIC_LENGTH];
+		if (version != OF_BINARY_SERIALIZATION_VERSION)
+			@throw [OFUnsupportedVersionException
+			    exceptionWithVersion: [OFString
+			    stringWithFormat: @"%u", version]];
+
+		deserializer.position =
+		    OF_BINARY_SERIALIZATION_MAGIC_LENGTH + 1;
+		deserializer.names = [OFMutableArray array];
+		deserializer.values = [OFMutableArray array];
+
+		root = readNode(&deserializer, 0);
+
+		if (![root isKindOfClass: [OFXMLElement class]] ||
+		    deserializer.position != deserializer.length)
+			@throw [OFInvalidFormatException exception];
+
+		object = ((OFXMLElement *)root).objectByDeserializing;
+	} else
+		object = [OFString
+		    stringWithUTF8String: (const char *)deserializer.items
+				  length: deserializer.length]
+		    .objectByDeserializing;
+
+	[object retain];
+	objc_autoreleasePoolPop(pool);
+	return [object autorelease];
+}
+@end
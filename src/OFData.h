@@ -18,6 +18,7 @@
 #import "OFObject.h"
 #import "OFSerialization.h"
 #import "OFMessagePackRepresentation.h"
+#import "OFBinaryPropertyListRepresentation.h"
 
 OF_ASSUME_NONNULL_BEGIN
 
@@ -37,7 +38,8 @@ enum {
  * for OFData with item size 1.
  */
 @interface OFData: OFObject <OFCopying, OFMutableCopying, OFComparing,
-    OFSerialization, OFMessagePackRepresentation>
+    OFSerialization, OFMessagePackRepresentation,
+    OFBinaryPropertyListRepresentation>
 {
 	unsigned char *_items;
 	size_t _count, _itemSize;
@@ -149,6 +151,22 @@ enum {
  * @return A new autoreleased OFData
  */
 + (instancetype)dataWithContentsOfFile: (OFString *)path;
+
+/*!
+ * @brief Creates a new OFData with an item size of 1, containing the data of
+ *	  the specified file, which is mapped into memory instead of being read
+ *	  if the operating system supports it.
+ *
+ * The file is only read as the data is accessed, and data returned by
+ * @ref subdataWithRange: references the mapping instead of copying it. If the
+ * file cannot be mapped, it is read instead.
+ *
+ * @warning The file must not be truncated while the OFData is used!
+ *
+ * @param path The path of the file
+ * @return A new autoreleased OFData
+ */
++ (instancetype)dataWithContentsOfMappedFile: (OFString *)path;
 #endif
 
 /*!
@@ -283,6 +301,11 @@ enum {
 /*!
  * @brief Returns the data in the specified range as a new OFData.
  *
+ * If the OFData is immutable, the returned OFData references it instead of
+ * copying the items, which keeps the whole OFData alive as long as the
+ * returned OFData is used. Use @ref mutableCopy on the result to get an
+ * independent copy of only the items in the range.
+ *
  * @param range The range of the data for the new OFData
  * @return The data in the specified range as a new OFData
  */
@@ -328,3 +351,5 @@ OF_ASSUME_NONNULL_END
 #import "OFData+ASN1DERValue.h"
 #import "OFData+CryptoHashing.h"
 #import "OFData+MessagePackValue.h"
+#import "OFData+PropertyListValue.h"
+#import "OFData+Serialization.h"
@@ -22,7 +22,9 @@
 #include <limits.h>
 
 #import "OFData.h"
+#import "OFBinaryPropertyListWriter.h"
 #import "OFDictionary.h"
+#import "OFMessagePackWriter.h"
 #ifdef OF_HAVE_FILES
 # import "OFFile.h"
 # import "OFFileManager.h"
@@ -51,6 +53,8 @@ _references_to_categories_of_OFData(void)
 	_OFData_ASN1DERValue_reference = 1;
 	_OFData_CryptoHashing_reference = 1;
 	_OFData_MessagePackValue_reference = 1;
+	_OFData_PropertyListValue_reference = 1;
+	_OFData_Serialization_reference = 1;
 }
 
 @implementation OFData
@@ -97,6 +101,17 @@ _references_to_categories_of_OFData(void)
 {
 	return [[[self alloc] initWithContentsOfFile: path] autorelease];
 }
+
++ (instancetype)dataWithContentsOfMappedFile: (OFString *)path
+{
+	/* Mutable data needs to be read, as the mapping is read-only. */
+	if (self != [OFData class])
+		return [self dataWithContentsOfFile: path];
+
+	return [[OFFileManager defaultManager]
+	    contentsOfFileAtPath: path
+			 options: OF_FILE_MANAGER_CONTENTS_MAPPED];
+}
 #endif
 
 + (instancetype)dataWithContentsOfURL: (OFURL *)URL
@@ -331,30 +346,41 @@ _references_to_categories_of_OFData(void)
 
 - (instancetype)initWithBase64EncodedString: (OFString *)string
 {
-	bool mutable = [self isKindOfClass: [OFMutableData class]];
+	void *pool = objc_autoreleasePoolPush();
+	void *items = NULL;
+	size_t count;
 
-	if (!mutable) {
-		[self release];
-		self = [OFMutableData alloc];
-	}
+	@try {
+		const char *cString = [string
+		    cStringWithEncoding: OF_STRING_ENCODING_ASCII];
+		size_t length = [string
+		    cStringLengthWithEncoding: OF_STRING_ENCODING_ASCII];
 
-	self = [(OFMutableData *)self initWithCapacity: string.length / 3];
+		/*
+		 * The exact size is known in advance, so decode directly into
+		 * the final buffer.
+		 */
+		if ((count = of_base64_decoded_length(cString, length)) ==
+		    SIZE_MAX)
+			@throw [OFInvalidFormatException exception];
 
-	@try {
-		if (!of_base64_decode((OFMutableData *)self,
-		    [string cStringWithEncoding: OF_STRING_ENCODING_ASCII],
-		    [string cStringLengthWithEncoding:
-		    OF_STRING_ENCODING_ASCII]))
+		if ((items = malloc(count > 0 ? count : 1)) == NULL)
+			@throw [OFOutOfMemoryException
+			    exceptionWithRequestedSize: count];
+
+		if (!of_base64_decode_buffer(items, cString, length))
 			@throw [OFInvalidFormatException exception];
 	} @catch (id e) {
+		free(items);
 		[self release];
 		@throw e;
 	}
 
-	if (!mutable)
-		[(OFMutableData *)self makeImmutable];
+	objc_autoreleasePoolPop(pool);
 
-	return self;
+	return [self initWithItemsNoCopy: items
+				   count: count
+			    freeWhenDone: true];
 }
 
 - (instancetype)initWithSerialization: (OFXMLElement *)element
@@ -505,17 +531,34 @@ _references_to_categories_of_OFData(void)
 
 - (OFData *)subdataWithRange: (of_range_t)range
 {
-	OFData *ret;
+	OFData *source, *parent, *ret;
+	size_t offset;
 
 	if (range.length > SIZE_MAX - range.location ||
 	    range.location + range.length > _count)
 		@throw [OFOutOfRangeException exception];
 
-	ret = [OFData dataWithItemsNoCopy: _items + (range.location * _itemSize)
-				 itemSize: _itemSize
-				    count: range.length
-			     freeWhenDone: false];
-	ret->_parentData = [(_parentData != nil ? _parentData : self) copy];
+	/*
+	 * The returned data references the data that owns the items. For
+	 * immutable data, copying only retains it, so nothing is copied. For
+	 * subclasses that do copy, the returned data needs to point into the
+	 * copy, as the original might change or go away.
+	 */
+	source = (_parentData != nil ? _parentData : self);
+	offset = (_items - source->_items) + range.location * _itemSize;
+	parent = [source copy];
+
+	@try {
+		ret = [OFData dataWithItemsNoCopy: parent->_items + offset
+					 itemSize: _itemSize
+					    count: range.length
+				     freeWhenDone: false];
+	} @catch (id e) {
+		[parent release];
+		@throw e;
+	}
+
+	ret->_parentData = parent;
 
 	return ret;
 }
@@ -652,48 +695,12 @@ _references_to_categories_of_OFData(void)
 
 - (OFData *)messagePackRepresentation
 {
-	OFMutableData *data;
-
-	if (_itemSize != 1)
-		@throw [OFInvalidArgumentException exception];
-
-	if (_count <= UINT8_MAX) {
-		uint8_t type = 0xC4;
-		uint8_t tmp = (uint8_t)_count;
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: _count + 2];
-
-		[data addItem: &type];
-		[data addItem: &tmp];
-	} else if (_count <= UINT16_MAX) {
-		uint8_t type = 0xC5;
-		uint16_t tmp = OF_BSWAP16_IF_LE((uint16_t)_count);
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: _count + 3];
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else if (_count <= UINT32_MAX) {
-		uint8_t type = 0xC6;
-		uint32_t tmp = OF_BSWAP32_IF_LE((uint32_t)_count);
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: _count + 5];
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else
-		@throw [OFOutOfRangeException exception];
-
-	[data addItems: _items
-		 count: _count];
-
-	[data makeImmutable];
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
+}
 
-	return data;
+- (OFData *)binaryPropertyListRepresentation
+{
+	return [OFBinaryPropertyListWriter
+	    binaryPropertyListRepresentationOfObject: self];
 }
 @end
@@ -16,6 +16,7 @@
  */
 
 #import "OFObject.h"
+#import "OFBinaryPropertyListRepresentation.h"
 #import "OFMessagePackRepresentation.h"
 #import "OFSerialization.h"
 
@@ -28,11 +29,20 @@ OF_ASSUME_NONNULL_BEGIN
  * @class OFDate OFDate.h ObjFW/OFDate.h
  *
  * @brief A class for storing, accessing and comparing dates.
+ *
+ * The offset of local time to UTC is cached per thread and looked up again
+ * when the TZ environment variable changes. Other changes of the time zone of
+ * the system only affect the local time of dates whose offset has not been
+ * cached yet.
  */
 @interface OFDate: OFObject <OFCopying, OFComparing, OFSerialization,
-    OFMessagePackRepresentation>
+    OFMessagePackRepresentation, OFBinaryPropertyListRepresentation>
 {
 	of_time_interval_t _seconds;
+	int64_t _year;
+	uint16_t _dayOfYear;
+	uint8_t _monthOfYear, _dayOfMonth, _hour, _minute, _second, _dayOfWeek;
+	volatile bool _componentsCached;
 }
 
 #ifdef OF_HAVE_CLASS_PROPERTIES
@@ -120,6 +130,24 @@ OF_ASSUME_NONNULL_BEGIN
  */
 @property (readonly, nonatomic) uint16_t localDayOfYear;
 
+/*!
+ * @brief The date as an HTTP date in the preferred format of RFC 7231, e.g.
+ *	  `Sun, 06 Nov 1994 08:49:37 GMT`.
+ *
+ * This does not depend on the locale and is considerably faster than
+ * @ref dateStringWithFormat:.
+ *
+ * @throw OFOutOfRangeException The year is not between 0 and 9999
+ */
+@property (readonly, nonatomic) OFString *HTTPDateString;
+
+/*!
+ * @brief The date as an ISO 8601 date in UTC, e.g. `1994-11-06T08:49:37Z`.
+ *
+ * @throw OFOutOfRangeException The year is not between 0 and 9999
+ */
+@property (readonly, nonatomic) OFString *ISO8601DateString;
+
 /*!
  * @brief The seconds since 1970-01-01T00:00:00Z.
  */
@@ -191,6 +219,32 @@ OF_ASSUME_NONNULL_BEGIN
 + (instancetype)dateWithLocalDateString: (OFString *)string
 				 format: (OFString *)format;
 
+/*!
+ * @brief Creates a new OFDate with the specified HTTP date.
+ *
+ * All three formats that RFC 7231 requires to be accepted are supported:
+ * `Sun, 06 Nov 1994 08:49:37 GMT`, `Sunday, 06-Nov-94 08:49:37 GMT` and
+ * `Sun Nov  6 08:49:37 1994`.
+ *
+ * @param string The HTTP date
+ * @return A new, autoreleased OFDate with the specified date and time
+ * @throw OFInvalidFormatException The string is not a valid HTTP date
+ */
++ (instancetype)dateWithHTTPDateString: (OFString *)string;
+
+/*!
+ * @brief Creates a new OFDate with the specified ISO 8601 date.
+ *
+ * The date needs to be of the form `2000-06-20T12:34:56`, optionally followed
+ * by fractions of a second, and a time zone of either `Z`, `+02:00` or
+ * `+0200`.
+ *
+ * @param string The ISO 8601 date
+ * @return A new, autoreleased OFDate with the specified date and time
+ * @throw OFInvalidFormatException The string is not a valid ISO 8601 date
+ */
++ (instancetype)dateWithISO8601DateString: (OFString *)string;
+
 /*!
  * @brief Returns a date in the distant future.
  *
@@ -227,6 +281,29 @@ OF_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)initWithTimeIntervalSinceNow: (of_time_interval_t)seconds;
 
+/*!
+ * @brief Initializes an already allocated OFDate with the specified HTTP date.
+ *
+ * See @ref dateWithHTTPDateString: for the supported formats.
+ *
+ * @param string The HTTP date
+ * @return An initialized OFDate with the specified date and time
+ * @throw OFInvalidFormatException The string is not a valid HTTP date
+ */
+- (instancetype)initWithHTTPDateString: (OFString *)string;
+
+/*!
+ * @brief Initializes an already allocated OFDate with the specified ISO 8601
+ *	  date.
+ *
+ * See @ref dateWithISO8601DateString: for the supported format.
+ *
+ * @param string The ISO 8601 date
+ * @return An initialized OFDate with the specified date and time
+ * @throw OFInvalidFormatException The string is not a valid ISO 8601 date
+ */
+- (instancetype)initWithISO8601DateString: (OFString *)string;
+
 /*!
  * @brief Initializes an already allocated OFDate with the specified string in
  *	  the specified format.
@@ -18,15 +18,18 @@
 #include "config.h"
 
 #include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
 
 #include <sys/time.h>
 
 #import "OFDate.h"
+#import "OFBinaryPropertyListWriter.h"
 #import "OFData.h"
 #import "OFDictionary.h"
-#import "OFMessagePackExtension.h"
+#import "OFMessagePackWriter.h"
 #ifdef OF_HAVE_THREADS
 # import "OFMutex.h"
 #endif
@@ -39,6 +42,9 @@
 #import "OFInvalidFormatException.h"
 #import "OFOutOfRangeException.h"
 
+#ifdef OF_HAVE_ATOMIC_OPS
+# import "atomic.h"
+#endif
 #import "of_strptime.h"
 
 #ifdef OF_AMIGAOS_M68K
@@ -51,90 +57,25 @@
 static OFMutex *mutex;
 #endif
 
-#ifdef HAVE_GMTIME_R
-# define GMTIME_RET(field)						\
-	time_t seconds = (time_t)_seconds;				\
-	struct tm tm;							\
-									\
-	if (seconds != trunc(_seconds))					\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	if (gmtime_r(&seconds, &tm) == NULL)				\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	return tm.field;
-# define LOCALTIME_RET(field)						\
-	time_t seconds = (time_t)_seconds;				\
-	struct tm tm;							\
-									\
-	if (seconds != trunc(_seconds))					\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	if (localtime_r(&seconds, &tm) == NULL)				\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	return tm.field;
-#else
-# ifdef OF_HAVE_THREADS
-#  define GMTIME_RET(field)						\
-	time_t seconds = (time_t)_seconds;				\
-	struct tm *tm;							\
-									\
-	if (seconds != trunc(_seconds))					\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	[mutex lock];							\
-									\
-	@try {								\
-		if ((tm = gmtime(&seconds)) == NULL)			\
-			@throw [OFOutOfRangeException exception];	\
-									\
-		return tm->field;					\
-	} @finally {							\
-		[mutex unlock];						\
-	}
-#  define LOCALTIME_RET(field)						\
-	time_t seconds = (time_t)_seconds;				\
-	struct tm *tm;							\
-									\
-	if (seconds != trunc(_seconds))					\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	[mutex lock];							\
-									\
-	@try {								\
-		if ((tm = localtime(&seconds)) == NULL)			\
-			@throw [OFOutOfRangeException exception];	\
-									\
-		return tm->field;					\
-	} @finally {							\
-		[mutex unlock];						\
-	}
-# else
-#  define GMTIME_RET(field)						\
-	time_t seconds = (time_t)_seconds;				\
-	struct tm *tm;							\
-									\
-	if (seconds != trunc(_seconds))					\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	if ((tm = gmtime(&seconds)) == NULL)				\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	return tm->field;
-#  define LOCALTIME_RET(field)						\
-	time_t seconds = (time_t)_seconds;				\
-	struct tm *tm;							\
-									\
-	if (seconds != trunc(_seconds))					\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	if ((tm = localtime(&seconds)) == NULL)				\
-		@throw [OFOutOfRangeException exception];		\
-									\
-	return tm->field;
-# endif
-#endif
+/*
+ * The offset of local time is looked up for windows of this many seconds,
+ * which is the granularity of all time zone transitions in practice.
+ */
+#define LOCAL_TIME_OFFSET_WINDOW 900
+#define LOCAL_TIME_OFFSETS_SIZE 16
+
+struct localTimeOffset {
+	int64_t window;
+	int32_t offset;
+	bool valid;
+};
+
+struct localTimeOffsetCache {
+	/* The value of TZ the offsets have been looked up with. */
+	char TZ[64];
+	bool hasTZ;
+	struct localTimeOffset offsets[LOCAL_TIME_OFFSETS_SIZE];
+};
 
 static int monthToDayOfYear[12] = {
 	0,
@@ -151,6 +92,319 @@ static int monthToDayOfYear[12] = {
 	31 + 28 + 31 + 30 + 31 + 30 + 31 + 31 + 30 + 31 + 30,
 };
 
+static const char weekdayNames[7][10] = {
+	"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday",
+	"Saturday"
+};
+static const char monthNames[12][4] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct",
+	"Nov", "Dec"
+};
+
+struct components {
+	int64_t year;
+	uint16_t dayOfYear;
+	uint8_t month, day, hour, minute, second, dayOfWeek;
+};
+
+/*
+ * Converts between days since 1970-01-01 and dates in the proleptic Gregorian
+ * calendar using only integer arithmetic. This is the algorithm described in
+ * http://howardhinnant.github.io/date_algorithms.html, which works in eras of
+ * 400 years that start on March 1st.
+ */
+static int64_t
+daysFromCivil(int64_t year, uint8_t month, uint8_t day)
+{
+	int64_t era;
+	uint32_t yearOfEra, dayOfYear, dayOfEra;
+
+	year -= (month <= 2);
+	era = (year >= 0 ? year : year - 399) / 400;
+	yearOfEra = (uint32_t)(year - era * 400);
+	dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 +
+	    day - 1;
+	dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 +
+	    dayOfYear;
+
+	return era * 146097 + (int64_t)dayOfEra - 719468;
+}
+
+static void
+civilFromDays(int64_t days, int64_t *year, uint8_t *month, uint8_t *day)
+{
+	int64_t era;
+	uint32_t dayOfEra, yearOfEra, dayOfYear, monthIndex;
+
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	dayOfEra = (uint32_t)(days - era * 146097);
+	yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 -
+	    dayOfEra / 146096) / 365;
+	dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 -
+	    yearOfEra / 100);
+	monthIndex = (5 * dayOfYear + 2) / 153;
+
+	*day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+	*month = (monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+	*year = (int64_t)yearOfEra + era * 400 + (*month <= 2);
+}
+
+static uint8_t
+daysInMonth(int64_t year, uint8_t month)
+{
+	static const uint8_t days[12] = {
+		31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+	};
+
+	if (month == 2 && ((year % 4 == 0 && year % 100 != 0) ||
+	    year % 400 == 0))
+		return 29;
+
+	return days[month - 1];
+}
+
+static void
+decomposeSeconds(int64_t seconds, struct components *components)
+{
+	int64_t days = seconds / 86400, secondOfDay = seconds % 86400;
+
+	if (secondOfDay < 0) {
+		secondOfDay += 86400;
+		days--;
+	}
+
+	civilFromDays(days, &components->year, &components->month,
+	    &components->day);
+
+	components->dayOfYear =
+	    (uint16_t)(days - daysFromCivil(components->year, 1, 1) + 1);
+	components->hour = (uint8_t)(secondOfDay / 3600);
+	components->minute = (uint8_t)(secondOfDay / 60 % 60);
+	components->second = (uint8_t)(secondOfDay % 60);
+	/* 1970-01-01 was a Thursday. */
+	components->dayOfWeek = (uint8_t)((days % 7 + 11) % 7);
+}
+
+static int64_t
+integralSeconds(of_time_interval_t seconds)
+{
+	/* Same range as the conversion to time_t for gmtime(), but wider. */
+	if (!(seconds > -9.2e18 && seconds < 9.2e18))
+		@throw [OFOutOfRangeException exception];
+
+	return (int64_t)seconds;
+}
+
+static void
+decomposeTime(of_time_interval_t seconds, struct components *components)
+{
+	decomposeSeconds(integralSeconds(seconds), components);
+}
+
+static int32_t
+lookUpLocalTimeOffset(int64_t seconds)
+{
+	time_t timeSeconds = (time_t)seconds;
+	struct tm tm;
+	int64_t localSeconds;
+
+	if (timeSeconds != seconds)
+		@throw [OFOutOfRangeException exception];
+
+#ifdef HAVE_LOCALTIME_R
+	if (localtime_r(&timeSeconds, &tm) == NULL)
+		@throw [OFOutOfRangeException exception];
+#else
+# ifdef OF_HAVE_THREADS
+	[mutex lock];
+
+	@try {
+# endif
+		struct tm *tmp;
+
+		if ((tmp = localtime(&timeSeconds)) == NULL)
+			@throw [OFOutOfRangeException exception];
+
+		tm = *tmp;
+# ifdef OF_HAVE_THREADS
+	} @finally {
+		[mutex unlock];
+	}
+# endif
+#endif
+
+	/* tm_gmtoff is not portable, so compute the offset from the fields. */
+	localSeconds = daysFromCivil((int64_t)tm.tm_year + 1900,
+	    tm.tm_mon + 1, tm.tm_mday) * 86400 + tm.tm_hour * 3600 +
+	    tm.tm_min * 60 + tm.tm_sec;
+
+	return (int32_t)(localSeconds - seconds);
+}
+
+#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
+/*
+ * Discards the cached offsets if TZ changed since they have been looked up.
+ * Returns false if the cache cannot be used because TZ is too long to be
+ * remembered.
+ */
+static bool
+validateLocalTimeOffsetCache(struct localTimeOffsetCache *cache)
+{
+	const char *TZ = getenv("TZ");
+	size_t length;
+
+	if (TZ == NULL) {
+		if (cache->hasTZ) {
+			memset(cache->offsets, 0, sizeof(cache->offsets));
+			cache->hasTZ = false;
+		}
+
+		return true;
+	}
+
+	if ((length = strlen(TZ)) >= sizeof(cache->TZ))
+		return false;
+
+	if (!cache->hasTZ || strcmp(cache->TZ, TZ) != 0) {
+		memset(cache->offsets, 0, sizeof(cache->offsets));
+		memcpy(cache->TZ, TZ, length + 1);
+		cache->hasTZ = true;
+	}
+
+	return true;
+}
+#endif
+
+/*
+ * Returns the offset of local time to UTC at the specified time.
+ *
+ * Looking it up requires localtime(), which might be slow and, without
+ * localtime_r(), needs a global lock. As the offset only changes on time zone
+ * transitions, it is cached for the windows of time in which it was found to
+ * be constant. The cache is per thread, so that it can be used without any
+ * locking, and is discarded whenever the TZ environment variable changes.
+ */
+static int32_t
+localTimeOffset(int64_t seconds)
+{
+#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
+# ifdef OF_HAVE_COMPILER_TLS
+	static thread_local struct localTimeOffsetCache cache;
+# else
+	static struct localTimeOffsetCache cache;
+# endif
+	int64_t window = seconds / LOCAL_TIME_OFFSET_WINDOW;
+	struct localTimeOffset *entry;
+	int32_t offset;
+
+	if (!validateLocalTimeOffsetCache(&cache))
+		return lookUpLocalTimeOffset(seconds);
+
+	if (seconds % LOCAL_TIME_OFFSET_WINDOW < 0)
+		window--;
+
+	entry = &cache.offsets[(uint64_t)window % LOCAL_TIME_OFFSETS_SIZE];
+
+	if (entry->valid && entry->window == window)
+		return entry->offset;
+
+	offset = lookUpLocalTimeOffset(seconds);
+
+	/*
+	 * Only cache the offset if it is the same at the start and the end of
+	 * the window, as otherwise there is a transition inside it.
+	 */
+	@try {
+		int64_t start = window * LOCAL_TIME_OFFSET_WINDOW;
+
+		if (lookUpLocalTimeOffset(start) == offset &&
+		    lookUpLocalTimeOffset(start + LOCAL_TIME_OFFSET_WINDOW - 1)
+		    == offset) {
+			entry->window = window;
+			entry->offset = offset;
+			entry->valid = true;
+		}
+	} @catch (OFOutOfRangeException *e) {
+		/* The window exceeds time_t, don't cache. */
+	}
+
+	return offset;
+#else
+	return lookUpLocalTimeOffset(seconds);
+#endif
+}
+
+static void
+writeDigits(char *buffer, uint32_t value, size_t count)
+{
+	while (count-- > 0) {
+		buffer[count] = '0' + value % 10;
+		value /= 10;
+	}
+}
+
+static bool
+readDigits(const char *buffer, size_t count, uint32_t *value)
+{
+	*value = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!of_ascii_isdigit(buffer[i]))
+			return false;
+
+		*value = *value * 10 + (buffer[i] - '0');
+	}
+
+	return true;
+}
+
+static bool
+readTime(const char *buffer, uint32_t *hour, uint32_t *minute,
+    uint32_t *second)
+{
+	return (readDigits(buffer, 2, hour) && buffer[2] == ':' &&
+	    readDigits(buffer + 3, 2, minute) && buffer[5] == ':' &&
+	    readDigits(buffer + 6, 2, second));
+}
+
+static uint32_t
+readMonth(const char *buffer)
+{
+	for (uint32_t i = 0; i < 12; i++)
+		if (memcmp(buffer, monthNames[i], 3) == 0)
+			return i + 1;
+
+	return 0;
+}
+
+static bool
+isWeekday(const char *buffer, size_t length)
+{
+	for (size_t i = 0; i < 7; i++) {
+		if (length == 3 && memcmp(buffer, weekdayNames[i], 3) == 0)
+			return true;
+		if (length == strlen(weekdayNames[i]) &&
+		    memcmp(buffer, weekdayNames[i], length) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static of_time_interval_t
+componentsToTime(int64_t year, uint32_t month, uint32_t day, uint32_t hour,
+    uint32_t minute, uint32_t second)
+{
+	if (month < 1 || month > 12 || day < 1 ||
+	    day > daysInMonth(year, month) || hour > 23 || minute > 59 ||
+	    second > 60)
+		@throw [OFInvalidFormatException exception];
+
+	return (of_time_interval_t)daysFromCivil(year, month, day) * 86400 +
+	    hour * 3600 + minute * 60 + second;
+}
+
 static double
 tmAndTzToTime(struct tm *tm, int16_t *tz)
 {
@@ -185,6 +439,11 @@ tmAndTzToTime(struct tm *tm, int16_t *tz)
 	return seconds;
 }
 
+@interface OFDate ()
+- (void)of_getComponents: (struct components *)components;
+- (void)of_getLocalComponents: (struct components *)components;
+@end
+
 @implementation OFDate
 #if (!defined(HAVE_GMTIME_R) || !defined(HAVE_LOCALTIME_R)) && \
     defined(OF_HAVE_THREADS)
@@ -226,6 +485,16 @@ tmAndTzToTime(struct tm *tm, int16_t *tz)
 					       format: format] autorelease];
 }
 
++ (instancetype)dateWithHTTPDateString: (OFString *)string
+{
+	return [[[self alloc] initWithHTTPDateString: string] autorelease];
+}
+
++ (instancetype)dateWithISO8601DateString: (OFString *)string
+{
+	return [[[self alloc] initWithISO8601DateString: string] autorelease];
+}
+
 + (instancetype)distantFuture
 {
 	return [[[self alloc]
@@ -334,6 +603,139 @@ tmAndTzToTime(struct tm *tm, int16_t *tz)
 	return self;
 }
 
+- (instancetype)initWithHTTPDateString: (OFString *)string
+{
+	self = [super init];
+
+	@try {
+		const char *UTF8String = string.UTF8String;
+		size_t length = string.UTF8StringLength;
+		uint32_t year, month, day, hour, minute, second;
+		const char *tmp;
+
+		if (length == 29 && UTF8String[3] == ',') {
+			/* IMF-fixdate: Sun, 06 Nov 1994 08:49:37 GMT */
+			if (!isWeekday(UTF8String, 3) ||
+			    UTF8String[4] != ' ' ||
+			    !readDigits(UTF8String + 5, 2, &day) ||
+			    UTF8String[7] != ' ' ||
+			    (month = readMonth(UTF8String + 8)) == 0 ||
+			    UTF8String[11] != ' ' ||
+			    !readDigits(UTF8String + 12, 4, &year) ||
+			    UTF8String[16] != ' ' ||
+			    !readTime(UTF8String + 17, &hour, &minute,
+			    &second) ||
+			    memcmp(UTF8String + 25, " GMT", 4) != 0)
+				@throw [OFInvalidFormatException exception];
+		} else if (length == 24 && UTF8String[3] == ' ') {
+			/* asctime(): Sun Nov  6 08:49:37 1994 */
+			if (!isWeekday(UTF8String, 3) ||
+			    (month = readMonth(UTF8String + 4)) == 0 ||
+			    UTF8String[7] != ' ' ||
+			    !(UTF8String[8] == ' '
+			    ? readDigits(UTF8String + 9, 1, &day)
+			    : readDigits(UTF8String + 8, 2, &day)) ||
+			    UTF8String[10] != ' ' ||
+			    !readTime(UTF8String + 11, &hour, &minute,
+			    &second) ||
+			    UTF8String[19] != ' ' ||
+			    !readDigits(UTF8String + 20, 4, &year))
+				@throw [OFInvalidFormatException exception];
+		} else if ((tmp = memchr(UTF8String, ',', length)) != NULL &&
+		    UTF8String + length - tmp == 24) {
+			/* RFC 850: Sunday, 06-Nov-94 08:49:37 GMT */
+			if (!isWeekday(UTF8String, tmp - UTF8String) ||
+			    tmp[1] != ' ' || !readDigits(tmp + 2, 2, &day) ||
+			    tmp[4] != '-' ||
+			    (month = readMonth(tmp + 5)) == 0 ||
+			    tmp[8] != '-' || !readDigits(tmp + 9, 2, &year) ||
+			    tmp[11] != ' ' ||
+			    !readTime(tmp + 12, &hour, &minute, &second) ||
+			    memcmp(tmp + 20, " GMT", 4) != 0)
+				@throw [OFInvalidFormatException exception];
+
+			year += (year < 70 ? 2000 : 1900);
+		} else
+			@throw [OFInvalidFormatException exception];
+
+		_seconds = componentsToTime(year, month, day, hour, minute,
+		    second);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithISO8601DateString: (OFString *)string
+{
+	self = [super init];
+
+	@try {
+		const char *UTF8String = string.UTF8String;
+		size_t length = string.UTF8StringLength, i;
+		uint32_t year, month, day, hour, minute, second;
+		of_time_interval_t fraction = 0;
+
+		/* 2000-06-20T12:34:56 */
+		if (length < 20 || !readDigits(UTF8String, 4, &year) ||
+		    UTF8String[4] != '-' ||
+		    !readDigits(UTF8String + 5, 2, &month) ||
+		    UTF8String[7] != '-' ||
+		    !readDigits(UTF8String + 8, 2, &day) ||
+		    (UTF8String[10] != 'T' && UTF8String[10] != 't') ||
+		    !readTime(UTF8String + 11, &hour, &minute, &second))
+			@throw [OFInvalidFormatException exception];
+
+		i = 19;
+
+		/* Optional fraction of a second, e.g. .25 */
+		if (UTF8String[i] == '.') {
+			of_time_interval_t factor = 0.1;
+
+			if (!of_ascii_isdigit(UTF8String[++i]))
+				@throw [OFInvalidFormatException exception];
+
+			for (; of_ascii_isdigit(UTF8String[i]); i++) {
+				fraction += (UTF8String[i] - '0') * factor;
+				factor /= 10;
+			}
+		}
+
+		_seconds = componentsToTime(year, month, day, hour, minute,
+		    second) + fraction;
+
+		/* Time zone: Z, +02:00 or +0200 */
+		if (UTF8String[i] == 'Z' || UTF8String[i] == 'z') {
+			if (i + 1 != length)
+				@throw [OFInvalidFormatException exception];
+		} else if ((UTF8String[i] == '+' || UTF8String[i] == '-') &&
+		    (i + 6 == length || i + 5 == length)) {
+			uint32_t TZHour, TZMinute;
+			int32_t offset;
+
+			if (!readDigits(UTF8String + i + 1, 2, &TZHour) ||
+			    !readDigits(UTF8String + length - 2, 2,
+			    &TZMinute) || TZHour > 23 || TZMinute > 59 ||
+			    (i + 6 == length && UTF8String[i + 3] != ':'))
+				@throw [OFInvalidFormatException exception];
+
+			offset = TZHour * 3600 + TZMinute * 60;
+			if (UTF8String[i] == '-')
+				offset = -offset;
+
+			_seconds -= offset;
+		} else
+			@throw [OFInvalidFormatException exception];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
 - (instancetype)initWithSerialization: (OFXMLElement *)element
 {
 	self = [super init];
@@ -452,137 +854,259 @@ tmAndTzToTime(struct tm *tm, int16_t *tz)
 
 - (OFData *)messagePackRepresentation
 {
-	void *pool = objc_autoreleasePoolPush();
-	int64_t seconds = (int64_t)_seconds;
-	uint32_t nanoseconds = (_seconds - trunc(_seconds)) * 1000000000;
-	OFData *ret;
-
-	if (seconds >= 0 && seconds < 0x400000000) {
-		if (seconds <= UINT32_MAX && nanoseconds == 0) {
-			uint32_t seconds32 = (uint32_t)seconds;
-			OFData *data;
-
-			seconds32 = OF_BSWAP32_IF_LE(seconds32);
-			data = [OFData dataWithItems: &seconds32
-					       count: sizeof(seconds32)];
-
-			ret = [[OFMessagePackExtension
-			    extensionWithType: -1
-					 data: data] messagePackRepresentation];
-		} else {
-			uint64_t combined = ((uint64_t)nanoseconds << 34) |
-			    (uint64_t)seconds;
-			OFData *data;
-
-			combined = OF_BSWAP64_IF_LE(combined);
-			data = [OFData dataWithItems: &combined
-					       count: sizeof(combined)];
-
-			ret = [[OFMessagePackExtension
-			    extensionWithType: -1
-					 data: data] messagePackRepresentation];
-		}
-	} else {
-		OFMutableData *data = [OFMutableData dataWithCapacity: 12];
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
+}
 
-		seconds = OF_BSWAP64_IF_LE(seconds);
-		nanoseconds = OF_BSWAP32_IF_LE(nanoseconds);
+- (OFData *)binaryPropertyListRepresentation
+{
+	return [OFBinaryPropertyListWriter
+	    binaryPropertyListRepresentationOfObject: self];
+}
 
-		[data addItems: &nanoseconds
-			 count: sizeof(nanoseconds)];
-		[data addItems: &seconds
-			 count: sizeof(seconds)];
+- (uint32_t)microsecond
+{
+	return (uint32_t)((_seconds - trunc(_seconds)) * 1000000);
+}
 
-		ret = [[OFMessagePackExtension
-		    extensionWithType: -1
-				 data: data] messagePackRepresentation];
+- (void)of_getComponents: (struct components *)components
+{
+#ifdef OF_HAVE_ATOMIC_OPS
+	if (_componentsCached) {
+		of_memory_barrier_acquire();
+
+		components->year = _year;
+		components->dayOfYear = _dayOfYear;
+		components->month = _monthOfYear;
+		components->day = _dayOfMonth;
+		components->hour = _hour;
+		components->minute = _minute;
+		components->second = _second;
+		components->dayOfWeek = _dayOfWeek;
+
+		return;
 	}
+#endif
 
-	[ret retain];
-
-	objc_autoreleasePoolPop(pool);
-
-	return [ret autorelease];
+	decomposeTime(_seconds, components);
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	/*
+	 * Dates are immutable, so if several threads race here, they all
+	 * store the same values.
+	 */
+	_year = components->year;
+	_dayOfYear = components->dayOfYear;
+	_monthOfYear = components->month;
+	_dayOfMonth = components->day;
+	_hour = components->hour;
+	_minute = components->minute;
+	_second = components->second;
+	_dayOfWeek = components->dayOfWeek;
+
+	of_memory_barrier_release();
+
+	_componentsCached = true;
+#endif
 }
 
-- (uint32_t)microsecond
+- (void)of_getLocalComponents: (struct components *)components
 {
-	return (uint32_t)((_seconds - trunc(_seconds)) * 1000000);
+	int64_t seconds = integralSeconds(_seconds);
+
+	decomposeSeconds(seconds + localTimeOffset(seconds), components);
 }
 
 - (uint8_t)second
 {
-	GMTIME_RET(tm_sec)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.second;
 }
 
 - (uint8_t)minute
 {
-	GMTIME_RET(tm_min)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.minute;
 }
 
 - (uint8_t)localMinute
 {
-	LOCALTIME_RET(tm_min)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return components.minute;
 }
 
 - (uint8_t)hour
 {
-	GMTIME_RET(tm_hour)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.hour;
 }
 
 - (uint8_t)localHour
 {
-	LOCALTIME_RET(tm_hour)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return components.hour;
 }
 
 - (uint8_t)dayOfMonth
 {
-	GMTIME_RET(tm_mday)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.day;
 }
 
 - (uint8_t)localDayOfMonth
 {
-	LOCALTIME_RET(tm_mday)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return components.day;
 }
 
 - (uint8_t)monthOfYear
 {
-	GMTIME_RET(tm_mon + 1)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.month;
 }
 
 - (uint8_t)localMonthOfYear
 {
-	LOCALTIME_RET(tm_mon + 1)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return components.month;
 }
 
 - (uint16_t)year
 {
-	GMTIME_RET(tm_year + 1900)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return (uint16_t)components.year;
 }
 
 - (uint16_t)localYear
 {
-	LOCALTIME_RET(tm_year + 1900)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return (uint16_t)components.year;
 }
 
 - (uint8_t)dayOfWeek
 {
-	GMTIME_RET(tm_wday)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.dayOfWeek;
 }
 
 - (uint8_t)localDayOfWeek
 {
-	LOCALTIME_RET(tm_wday)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return components.dayOfWeek;
 }
 
 - (uint16_t)dayOfYear
 {
-	GMTIME_RET(tm_yday + 1)
+	struct components components;
+
+	[self of_getComponents: &components];
+
+	return components.dayOfYear;
 }
 
 - (uint16_t)localDayOfYear
 {
-	LOCALTIME_RET(tm_yday + 1)
+	struct components components;
+
+	[self of_getLocalComponents: &components];
+
+	return components.dayOfYear;
+}
+
+- (OFString *)HTTPDateString
+{
+	struct components components;
+	char buffer[29];
+
+	decomposeTime(_seconds, &components);
+
+	if (components.year < 0 || components.year > 9999)
+		@throw [OFOutOfRangeException exception];
+
+	/* Sun, 06 Nov 1994 08:49:37 GMT */
+	memcpy(buffer, weekdayNames[components.dayOfWeek], 3);
+	memcpy(buffer + 3, ", ", 2);
+	writeDigits(buffer + 5, components.day, 2);
+	buffer[7] = ' ';
+	memcpy(buffer + 8, monthNames[components.month - 1], 3);
+	buffer[11] = ' ';
+	writeDigits(buffer + 12, (uint32_t)components.year, 4);
+	buffer[16] = ' ';
+	writeDigits(buffer + 17, components.hour, 2);
+	buffer[19] = ':';
+	writeDigits(buffer + 20, components.minute, 2);
+	buffer[22] = ':';
+	writeDigits(buffer + 23, components.second, 2);
+	memcpy(buffer + 25, " GMT", 4);
+
+	return [OFString stringWithUTF8String: buffer
+				       length: sizeof(buffer)];
+}
+
+- (OFString *)ISO8601DateString
+{
+	struct components components;
+	char buffer[20];
+
+	decomposeTime(_seconds, &components);
+
+	if (components.year < 0 || components.year > 9999)
+		@throw [OFOutOfRangeException exception];
+
+	/* 1994-11-06T08:49:37Z */
+	writeDigits(buffer, (uint32_t)components.year, 4);
+	buffer[4] = '-';
+	writeDigits(buffer + 5, components.month, 2);
+	buffer[7] = '-';
+	writeDigits(buffer + 8, components.day, 2);
+	buffer[10] = 'T';
+	writeDigits(buffer + 11, components.hour, 2);
+	buffer[13] = ':';
+	writeDigits(buffer + 14, components.minute, 2);
+	buffer[16] = ':';
+	writeDigits(buffer + 17, components.second, 2);
+	buffer[19] = 'Z';
+
+	return [OFString stringWithUTF8String: buffer
+				       length: sizeof(buffer)];
 }
 
 - (OFString *)dateStringWithFormat: (OFConstantString *)format
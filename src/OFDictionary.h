@@ -30,6 +30,7 @@
 #import "OFSerialization.h"
 #import "OFJSONRepresentation.h"
 #import "OFMessagePackRepresentation.h"
+#import "OFBinaryPropertyListRepresentation.h"
 
 OF_ASSUME_NONNULL_BEGIN
 
@@ -57,7 +58,7 @@ typedef id _Nonnull (^of_dictionary_map_block_t)(id key, id object);
  */
 @interface OFDictionary OF_GENERIC(KeyType, ObjectType): OFObject <OFCopying,
     OFMutableCopying, OFCollection, OFSerialization, OFJSONRepresentation,
-    OFMessagePackRepresentation>
+    OFMessagePackRepresentation, OFBinaryPropertyListRepresentation>
 #if !defined(OF_HAVE_GENERICS) && !defined(DOXYGEN)
 # define KeyType id
 # define ObjectType id
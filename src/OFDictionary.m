@@ -19,14 +19,14 @@
 
 #include <stdlib.h>
 
-#include <assert.h>
-
 #import "OFDictionary.h"
 #import "OFArray.h"
+#import "OFBinaryPropertyListWriter.h"
 #import "OFCharacterSet.h"
 #import "OFData.h"
 #import "OFEnumerator.h"
 #import "OFMapTableDictionary.h"
+#import "OFMessagePackWriter.h"
 #import "OFString.h"
 #import "OFXMLElement.h"
 
@@ -825,65 +825,13 @@ static OFCharacterSet *URLQueryPartAllowedCharacterSet = nil;
 
 - (OFData *)messagePackRepresentation
 {
-	OFMutableData *data;
-	size_t i, count;
-	void *pool;
-	OFEnumerator *keyEnumerator, *objectEnumerator;
-	id <OFMessagePackRepresentation> key, object;
-
-	data = [OFMutableData data];
-	count = self.count;
-
-	if (count <= 15) {
-		uint8_t tmp = 0x80 | ((uint8_t)count & 0xF);
-		[data addItem: &tmp];
-	} else if (count <= UINT16_MAX) {
-		uint8_t type = 0xDE;
-		uint16_t tmp = OF_BSWAP16_IF_LE((uint16_t)count);
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else if (count <= UINT32_MAX) {
-		uint8_t type = 0xDF;
-		uint32_t tmp = OF_BSWAP32_IF_LE((uint32_t)count);
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else
-		@throw [OFOutOfRangeException exception];
-
-	pool = objc_autoreleasePoolPush();
-
-	i = 0;
-	keyEnumerator = [self keyEnumerator];
-	objectEnumerator = [self objectEnumerator];
-	while ((key = [keyEnumerator nextObject]) != nil &&
-	    (object = [objectEnumerator nextObject]) != nil) {
-		void *pool2 = objc_autoreleasePoolPush();
-		OFData *child;
-
-		i++;
-
-		child = key.messagePackRepresentation;
-		[data addItems: child.items
-			 count: child.count];
-
-		child = object.messagePackRepresentation;
-		[data addItems: child.items
-			 count: child.count];
-
-		objc_autoreleasePoolPop(pool2);
-	}
-
-	assert(i == count);
-
-	[data makeImmutable];
-
-	objc_autoreleasePoolPop(pool);
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
+}
 
-	return data;
+- (OFData *)binaryPropertyListRepresentation
+{
+	return [OFBinaryPropertyListWriter
+	    binaryPropertyListRepresentationOfObject: self];
 }
 @end
 
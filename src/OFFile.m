@@ -28,8 +28,12 @@
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 
 #import "OFFile.h"
+#import "OFStream+Private.h"
 #import "OFLocale.h"
 #import "OFString.h"
 #import "OFURL.h"
@@ -75,6 +79,11 @@
 # define O_EXLOCK 0
 #endif
 
+#if defined(HAVE_WRITEV) && defined(HAVE_SYS_UIO_H) && \
+    !defined(OF_WINDOWS) && !defined(OF_AMIGAOS)
+# define USE_WRITEV
+#endif
+
 #ifndef OF_AMIGAOS
 # define closeHandle(h) close(h)
 #else
@@ -455,6 +464,46 @@ parseMode(const char *mode, bool *append)
 	return (size_t)bytesWritten;
 }
 
+#ifdef USE_WRITEV
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
+{
+	size_t ret = 0;
+
+	if (_handle == OF_INVALID_FILE_HANDLE)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if ([self of_overridesLowlevelWriteBufferOfClass: [OFFile class]])
+		return [super lowlevelWriteBuffers: buffers
+					     count: count];
+
+	while (count > 0) {
+		struct iovec iov[OF_MAX_IO_VECTORS];
+		size_t length;
+		size_t iovCount = of_stream_fill_io_vectors(iov, buffers,
+		    count, &length);
+		ssize_t bytesWritten;
+
+		if ((bytesWritten = writev(_handle, iov, (int)iovCount)) < 0)
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: ret + length
+				   bytesWritten: ret
+					  errNo: errno];
+
+		ret += bytesWritten;
+
+		if ((size_t)bytesWritten < length)
+			break;
+
+		buffers += iovCount;
+		count -= iovCount;
+	}
+
+	return ret;
+}
+#endif
+
 - (of_offset_t)lowlevelSeekToOffset: (of_offset_t)offset
 			     whence: (int)whence
 {
@@ -39,10 +39,28 @@ OF_ASSUME_NONNULL_BEGIN
 
 @class OFArray OF_GENERIC(ObjectType);
 @class OFConstantString;
+@class OFData;
 @class OFDate;
 @class OFString;
 @class OFURL;
 
+#ifdef OF_HAVE_FILES
+/*!
+ * @brief Options for @ref OFFileManager::contentsOfFileAtPath:options:.
+ */
+enum {
+	/*!
+	 * Map the file into memory instead of reading it, if supported.
+	 * The file must not be truncated while the returned data is used.
+	 */
+	OF_FILE_MANAGER_CONTENTS_MAPPED = 1,
+	/*! The mapped contents are going to be accessed sequentially */
+	OF_FILE_MANAGER_CONTENTS_SEQUENTIAL = 2,
+	/*! The mapped contents are going to be accessed in random order */
+	OF_FILE_MANAGER_CONTENTS_RANDOM = 4
+};
+#endif
+
 /*!
  * @brief A key for a file attribute in the file attributes dictionary.
  *
@@ -401,6 +419,22 @@ extern const of_file_type_t of_file_type_socket;
 - (OFArray OF_GENERIC(OFString *) *)contentsOfDirectoryAtURL: (OFURL *)URL;
 
 #ifdef OF_HAVE_FILES
+/*!
+ * @brief Returns the contents of the file at the specified path.
+ *
+ * @param path The path of the file whose contents should be returned
+ * @param options Options for reading the file.@n
+ *		  Possible values are a combination of:
+ *		  Value                                 | Description
+ *		  --------------------------------------|------------------
+ *		  `OF_FILE_MANAGER_CONTENTS_MAPPED`     | Map the file
+ *		  `OF_FILE_MANAGER_CONTENTS_SEQUENTIAL` | Sequential access
+ *		  `OF_FILE_MANAGER_CONTENTS_RANDOM`     | Random access
+ * @return An OFData with the contents of the file
+ */
+- (OFData *)contentsOfFileAtPath: (OFString *)path
+			 options: (int)options;
+
 /*!
  * @brief Changes the current working directory.
  *
@@ -28,10 +28,12 @@
 #endif
 
 #import "OFArray.h"
+#import "OFData.h"
 #import "OFDate.h"
 #import "OFDictionary.h"
 #ifdef OF_HAVE_FILES
 # import "OFFile.h"
+# import "OFMappedData.h"
 #endif
 #import "OFFileManager.h"
 #import "OFLocale.h"
@@ -444,6 +446,17 @@ attributeForKeyOrException(of_file_attributes_t attributes,
 	return [ret autorelease];
 }
 
+- (OFData *)contentsOfFileAtPath: (OFString *)path
+			 options: (int)options
+{
+	if (options & OF_FILE_MANAGER_CONTENTS_MAPPED)
+		return [[[OFMappedData alloc] initWithPath: path
+						   options: options]
+		    autorelease];
+
+	return [OFData dataWithContentsOfFile: path];
+}
+
 - (void)changeCurrentDirectoryPath: (OFString *)path
 {
 	if (path == nil)
@@ -18,6 +18,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <stdlib.h>
 
 #ifdef HAVE_DIRENT_H
 # include <dirent.h>
@@ -27,6 +28,13 @@
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+#endif
 
 #ifdef HAVE_PWD_H
 # include <pwd.h>
@@ -48,6 +56,7 @@
 # import "OFMutex.h"
 #endif
 
+#import "OFCopyItemFailedException.h"
 #import "OFCreateDirectoryFailedException.h"
 #import "OFCreateSymbolicLinkFailedException.h"
 #import "OFInitializationFailedException.h"
@@ -56,11 +65,13 @@
 #import "OFMoveItemFailedException.h"
 #import "OFNotImplementedException.h"
 #import "OFOpenItemFailedException.h"
+#import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
 #import "OFReadFailedException.h"
 #import "OFRemoveItemFailedException.h"
 #import "OFRetrieveItemAttributesFailedException.h"
 #import "OFSetItemAttributesFailedException.h"
+#import "OFWriteFailedException.h"
 
 #ifdef OF_WINDOWS
 # include <windows.h>
@@ -95,6 +106,9 @@ typedef struct stat64 of_stat_t;
 typedef struct stat of_stat_t;
 #endif
 
+#define COPY_BUFFER_SIZE (1024 * 1024)
+#define KERNEL_COPY_SIZE 0x40000000
+
 #ifdef OF_WINDOWS
 # define S_IFLNK 0x10000
 # define S_ISLNK(mode) (mode & S_IFLNK)
@@ -480,6 +494,89 @@ setSymbolicLinkDestinationAttribute(of_mutable_file_attributes_t attributes,
 }
 #endif
 
+#ifdef OF_FILE_HANDLE_IS_FD
+static ssize_t
+kernelCopyChunk(int sourceFD, int destinationFD, bool useSendfile)
+{
+# ifdef HAVE_COPY_FILE_RANGE
+	if (!useSendfile)
+		return copy_file_range(sourceFD, NULL, destinationFD, NULL,
+		    KERNEL_COPY_SIZE, 0);
+# endif
+# if defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE)
+	if (useSendfile)
+		return sendfile(destinationFD, sourceFD, NULL,
+		    KERNEL_COPY_SIZE);
+# endif
+
+	errno = ENOSYS;
+	return -1;
+}
+
+/*
+ * Lets the kernel copy a regular file, first by sharing the data between both
+ * files if the file system supports it, then with copy_file_range() and
+ * finally with sendfile(). Returns false if none of them can copy between the
+ * two files, in which case nothing has been written yet.
+ */
+static bool
+copyFileInKernel(OFFile *sourceFile, OFFile *destinationFile)
+{
+	int sourceFD = sourceFile.fileDescriptorForReading;
+	int destinationFD = destinationFile.fileDescriptorForWriting;
+
+# if defined(HAVE_LINUX_FS_H) && defined(FICLONE)
+	if (ioctl(destinationFD, FICLONE, sourceFD) == 0)
+		return true;
+# endif
+
+	for (int i = 0; i < 2; i++) {
+		of_offset_t copied = 0;
+
+		for (;;) {
+			ssize_t ret = kernelCopyChunk(sourceFD, destinationFD,
+			    (i == 1));
+
+			if (ret < 0) {
+				int errNo = errno;
+
+				if (errNo == EINTR)
+					continue;
+
+				if (copied == 0 && (errNo == EXDEV ||
+# ifdef EOPNOTSUPP
+				    errNo == EOPNOTSUPP ||
+# endif
+				    errNo == EINVAL || errNo == ENOSYS))
+					break;
+
+				@throw [OFWriteFailedException
+				    exceptionWithObject: destinationFile
+					requestedLength: KERNEL_COPY_SIZE
+					   bytesWritten: 0
+						  errNo: errNo];
+			}
+
+			if (ret == 0) {
+				/*
+				 * Files on some file systems, e.g. procfs,
+				 * appear empty to the kernel copy, so if
+				 * nothing was copied, try the next way.
+				 */
+				if (copied == 0)
+					break;
+
+				return true;
+			}
+
+			copied += ret;
+		}
+	}
+
+	return false;
+}
+#endif
+
 @implementation OFFileURLHandler
 + (void)initialize
 {
@@ -1218,6 +1315,112 @@ setSymbolicLinkDestinationAttribute(of_mutable_file_attributes_t attributes,
 }
 #endif
 
+- (bool)copyItemAtURL: (OFURL *)source
+		toURL: (OFURL *)destination
+{
+	void *pool;
+	of_file_attributes_t attributes;
+	OFFile *sourceFile = nil, *destinationFile = nil;
+	char *buffer = NULL;
+
+	if (![source.scheme isEqual: _scheme] ||
+	    ![destination.scheme isEqual: _scheme])
+		return false;
+
+	pool = objc_autoreleasePoolPush();
+
+	@try {
+		attributes = [self attributesOfItemAtURL: source];
+	} @catch (OFRetrieveItemAttributesFailedException *e) {
+		@throw [OFCopyItemFailedException
+		    exceptionWithSourceURL: source
+			    destinationURL: destination
+				     errNo: e.errNo];
+	}
+
+	/* Everything but regular files is left to OFFileManager. */
+	if (![attributes.fileType isEqual: of_file_type_regular]) {
+		objc_autoreleasePoolPop(pool);
+		return false;
+	}
+
+	if ([self fileExistsAtURL: destination])
+		@throw [OFCopyItemFailedException
+		    exceptionWithSourceURL: source
+			    destinationURL: destination
+				     errNo: EEXIST];
+
+	@try {
+		bool copied = false;
+
+		sourceFile = [[OFFile alloc]
+		    initWithPath: source.fileSystemRepresentation
+			    mode: @"r"];
+		destinationFile = [[OFFile alloc]
+		    initWithPath: destination.fileSystemRepresentation
+			    mode: @"w"];
+
+#ifdef OF_FILE_HANDLE_IS_FD
+		copied = copyFileInKernel(sourceFile, destinationFile);
+#endif
+
+		if (!copied) {
+			if ((buffer = malloc(COPY_BUFFER_SIZE)) == NULL)
+				@throw [OFOutOfMemoryException
+				    exceptionWithRequestedSize:
+				    COPY_BUFFER_SIZE];
+
+			while (!sourceFile.atEndOfStream) {
+				size_t length;
+
+				length = [sourceFile
+				    readIntoBuffer: buffer
+					    length: COPY_BUFFER_SIZE];
+				[destinationFile writeBuffer: buffer
+						      length: length];
+			}
+		}
+
+		@try {
+			of_file_attribute_key_t key =
+			    of_file_attribute_key_posix_permissions;
+			OFNumber *permissions = [attributes objectForKey: key];
+			of_file_attributes_t destinationAttributes;
+
+			if (permissions != nil) {
+				destinationAttributes = [OFDictionary
+				    dictionaryWithObject: permissions
+						  forKey: key];
+				[self setAttributes: destinationAttributes
+					ofItemAtURL: destination];
+			}
+		} @catch (OFNotImplementedException *e) {
+		}
+	} @catch (id e) {
+		/*
+		 * Only convert exceptions to OFCopyItemFailedException that
+		 * have an errNo property. This covers all I/O related
+		 * exceptions from the operations used to copy an item, all
+		 * others should be left as is.
+		 */
+		if ([e respondsToSelector: @selector(errNo)])
+			@throw [OFCopyItemFailedException
+			    exceptionWithSourceURL: source
+				    destinationURL: destination
+					     errNo: [e errNo]];
+
+		@throw e;
+	} @finally {
+		[sourceFile release];
+		[destinationFile release];
+		free(buffer);
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return true;
+}
+
 - (bool)moveItemAtURL: (OFURL *)source
 		toURL: (OFURL *)destination
 {
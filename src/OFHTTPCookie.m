@@ -32,9 +32,18 @@ handleAttribute(OFHTTPCookie *cookie, OFString *name, OFString *value)
 
 	if (value != nil) {
 		if ([lowercaseName isEqual: @"expires"]) {
-			OFDate *date = [OFDate
-			    dateWithDateString: value
-					format: @"%a, %d %b %Y %H:%M:%S %z"];
+			OFDate *date;
+
+			@try {
+				date = [OFDate dateWithHTTPDateString: value];
+			} @catch (OFInvalidFormatException *e) {
+				/* Not an HTTP date, but some servers send it */
+				date = [OFDate
+				    dateWithDateString: value
+						format: @"%a, %d %b %Y "
+							@"%H:%M:%S %z"];
+			}
+
 			cookie.expires = date;
 		} else if ([lowercaseName isEqual: @"max-age"]) {
 			OFDate *date = [OFDate dateWithTimeIntervalSinceNow:
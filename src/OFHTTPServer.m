@@ -19,6 +19,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #import "OFHTTPServer.h"
 #import "OFArray.h"
@@ -113,6 +114,37 @@
 @end
 #endif
 
+static OFString *
+currentDate(void)
+{
+#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
+	/*
+	 * HTTP dates only have a resolution of seconds, so the date only needs
+	 * to be created once per second and thread.
+	 */
+# ifdef OF_HAVE_COMPILER_TLS
+	static thread_local OFString *date = nil;
+	static thread_local time_t dateSeconds = 0;
+# else
+	static OFString *date = nil;
+	static time_t dateSeconds = 0;
+# endif
+	time_t now = time(NULL);
+
+	if (date == nil || now != dateSeconds) {
+		OFString *old = date;
+		date = [[OFDate dateWithTimeIntervalSince1970: now]
+		    .HTTPDateString copy];
+		dateSeconds = now;
+		[old release];
+	}
+
+	return [[date retain] autorelease];
+#else
+	return [OFDate date].HTTPDateString;
+#endif
+}
+
 static const char *
 statusCodeToString(short code)
 {
@@ -272,10 +304,7 @@ normalizedKey(OFString *key)
 	headers = [[_headers mutableCopy] autorelease];
 
 	if ([headers objectForKey: @"Date"] == nil) {
-		OFString *date = [[OFDate date]
-		    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
-
-		[headers setObject: date
+		[headers setObject: currentDate()
 			    forKey: @"Date"];
 	}
 
@@ -307,7 +336,9 @@ normalizedKey(OFString *key)
 {
 	/* TODO: Use non-blocking writes */
 
-	void *pool;
+	char chunkLine[sizeof(size_t) * 2 + 2];
+	size_t chunkLineLength = 0;
+	of_stream_buffer_t buffers[3];
 
 	if (_socket == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
@@ -319,14 +350,26 @@ normalizedKey(OFString *key)
 		return [_socket writeBuffer: buffer
 				     length: length];
 
-	pool = objc_autoreleasePoolPush();
-	[_socket writeString: [OFString stringWithFormat: @"%zx\r\n", length]];
-	objc_autoreleasePoolPop(pool);
+	/* Write the chunk with its framing in a single write. */
+	for (int i = sizeof(size_t) * 8 - 4; i >= 0; i -= 4) {
+		uint8_t digit = (length >> i) & 0xF;
+
+		if (digit != 0 || chunkLineLength > 0 || i == 0)
+			chunkLine[chunkLineLength++] =
+			    "0123456789abcdef"[digit];
+	}
+	chunkLine[chunkLineLength++] = '\r';
+	chunkLine[chunkLineLength++] = '\n';
+
+	buffers[0].buffer = chunkLine;
+	buffers[0].length = chunkLineLength;
+	buffers[1].buffer = buffer;
+	buffers[1].length = length;
+	buffers[2].buffer = "\r\n";
+	buffers[2].length = 2;
 
-	[_socket writeBuffer: buffer
-		      length: length];
-	[_socket writeBuffer: "\r\n"
-		      length: 2];
+	[_socket writeBuffers: buffers
+			count: 3];
 
 	return length;
 }
@@ -581,15 +624,12 @@ normalizedKey(OFString *key)
 
 - (bool)sendErrorAndClose: (short)statusCode
 {
-	OFString *date = [[OFDate date]
-	    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
-
 	[_socket writeFormat: @"HTTP/1.1 %d %s\r\n"
 			      @"Date: %@\r\n"
 			      @"Server: %@\r\n"
 			      @"\r\n",
 			      statusCode, statusCodeToString(statusCode),
-			      date, _server.name];
+			      currentDate(), _server.name];
 
 	return false;
 }
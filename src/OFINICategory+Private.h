@@ -20,14 +20,26 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFData;
 @class OFStream;
 
 @interface OFINICategory ()
 - (instancetype)of_initWithName: (OFString *)name OF_METHOD_FAMILY(init);
+- (void)of_setUnparsedLines: (OFData *)lines
+		   encoding: (of_string_encoding_t)encoding;
+- (void)of_parseUnparsedLines;
 - (void)of_parseLine: (OFString *)line;
 - (bool)of_writeToStream: (OFStream *)stream
 		encoding: (of_string_encoding_t)encoding
 		   first: (bool)first;
 @end
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern size_t of_ini_scan_line(const char *, size_t, size_t *, bool *);
+#ifdef __cplusplus
+}
+#endif
+
 OF_ASSUME_NONNULL_END
@@ -16,12 +16,13 @@
  */
 
 #import "OFObject.h"
+#import "OFString.h"
 
 OF_ASSUME_NONNULL_BEGIN
 
 @class OFArray OF_GENERIC(ObjectType);
+@class OFData;
 @class OFMutableArray OF_GENERIC(ObjectType);
-@class OFString;
 
 /*!
  * @class OFINICategory OFINICategory.h ObjFW/OFINICategory.h
@@ -32,6 +33,8 @@ OF_ASSUME_NONNULL_BEGIN
 {
 	OFString *_name;
 	OFMutableArray *_lines;
+	OFData *_Nullable _unparsedLines;
+	of_string_encoding_t _unparsedLinesEncoding;
 }
 
 /*!
@@ -17,9 +17,12 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "OFINICategory.h"
 #import "OFINICategory+Private.h"
 #import "OFArray.h"
+#import "OFData.h"
 #import "OFString.h"
 #import "OFStream.h"
 
@@ -100,6 +103,39 @@ unescapeString(OFString *string)
 	return mutableString;
 }
 
+size_t
+of_ini_scan_line(const char *buffer, size_t length, size_t *lineLength,
+    bool *isWhitespace)
+{
+	const char *end;
+	size_t ret = length;
+
+	/* Same as with -[OFStream readLine], a line ends with \n or \0. */
+	if ((end = memchr(buffer, '\n', length)) != NULL) {
+		length = end - buffer;
+		ret = length + 1;
+	}
+	if ((end = memchr(buffer, '\0', length)) != NULL) {
+		length = end - buffer;
+		ret = length + 1;
+	}
+
+	if (length > 0 && buffer[length - 1] == '\r')
+		length--;
+
+	*lineLength = length;
+	*isWhitespace = true;
+
+	for (size_t i = 0; i < length; i++) {
+		if (!of_ascii_isspace(buffer[i])) {
+			*isWhitespace = false;
+			break;
+		}
+	}
+
+	return ret;
+}
+
 @implementation OFINICategoryPair
 - (void)dealloc
 {
@@ -146,10 +182,62 @@ unescapeString(OFString *string)
 {
 	[_name release];
 	[_lines release];
+	[_unparsedLines release];
 
 	[super dealloc];
 }
 
+- (void)of_setUnparsedLines: (OFData *)lines
+		   encoding: (of_string_encoding_t)encoding
+{
+	OFData *old = _unparsedLines;
+	_unparsedLines = [lines copy];
+	_unparsedLinesEncoding = encoding;
+	[old release];
+}
+
+- (void)of_parseUnparsedLines
+{
+	void *pool;
+	const char *items;
+	size_t count;
+
+	if (_unparsedLines == nil)
+		return;
+
+	pool = objc_autoreleasePoolPush();
+	items = _unparsedLines.items;
+	count = _unparsedLines.count;
+
+	@try {
+		for (size_t i = 0; i < count;) {
+			size_t lineLength;
+			bool isWhitespace;
+			size_t lineStart = i;
+
+			i += of_ini_scan_line(items + i, count - i,
+			    &lineLength, &isWhitespace);
+
+			if (isWhitespace)
+				continue;
+
+			[self of_parseLine: [OFString
+			    stringWithCString: items + lineStart
+				     encoding: _unparsedLinesEncoding
+				       length: lineLength]];
+		}
+	} @catch (id e) {
+		/* Leave it unparsed so that the next access fails again. */
+		[_lines removeAllObjects];
+		@throw e;
+	}
+
+	[_unparsedLines release];
+	_unparsedLines = nil;
+
+	objc_autoreleasePoolPop(pool);
+}
+
 - (void)of_parseLine: (OFString *)line
 {
 	if (![line hasPrefix: @";"]) {
@@ -495,6 +583,8 @@ unescapeString(OFString *string)
 		encoding: (of_string_encoding_t)encoding
 		   first: (bool)first
 {
+	[self of_parseUnparsedLines];
+
 	if (_lines.count == 0)
 		return false;
 
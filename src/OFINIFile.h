@@ -23,6 +23,19 @@ OF_ASSUME_NONNULL_BEGIN
 
 @class OFMutableArray OF_GENERIC(ObjectType);
 
+/*!
+ * @brief Options for loading an INI file.
+ */
+enum {
+	/*!
+	 * Only parse the key/value pairs of a category when it is requested
+	 * for the first time. The file is still scanned for categories
+	 * immediately, but lines that are not valid are only reported once
+	 * their category is requested.
+	 */
+	OF_INI_FILE_LAZY = 0x01
+};
+
 /*!
  * @class OFINIFile OFINIFile.h ObjFW/OFINIFile.h
  *
@@ -54,6 +67,23 @@ OF_ASSUME_NONNULL_BEGIN
 + (instancetype)fileWithPath: (OFString *)path
 		    encoding: (of_string_encoding_t)encoding;
 
+/*!
+ * @brief Creates a new OFINIFile with the contents of the specified file in
+ *	  the specified encoding, using the specified options.
+ *
+ * @param path The path to the file whose contents the OFINIFile should contain
+ * @param encoding The encoding of the specified file
+ * @param options The options to use for loading. Possible values are:
+ *		  Value              | Description
+ *		  -------------------|------------------------------------------
+ *		  `OF_INI_FILE_LAZY` | Parse categories when they are requested
+ *
+ * @return A new, autoreleased OFINIFile with the contents of the specified file
+ */
++ (instancetype)fileWithPath: (OFString *)path
+		    encoding: (of_string_encoding_t)encoding
+		     options: (int)options;
+
 - (instancetype)init OF_UNAVAILABLE;
 
 /*!
@@ -75,14 +105,34 @@ OF_ASSUME_NONNULL_BEGIN
  *
  * @return An initialized OFINIFile with the contents of the specified file
  */
+- (instancetype)initWithPath: (OFString *)path
+		    encoding: (of_string_encoding_t)encoding;
+
+/*!
+ * @brief Initializes an already allocated OFINIFile with the contents of the
+ *	  specified file in the specified encoding, using the specified
+ *	  options.
+ *
+ * @param path The path to the file whose contents the OFINIFile should contain
+ * @param encoding The encoding of the specified file
+ * @param options The options to use for loading. Possible values are:
+ *		  Value              | Description
+ *		  -------------------|------------------------------------------
+ *		  `OF_INI_FILE_LAZY` | Parse categories when they are requested
+ *
+ * @return An initialized OFINIFile with the contents of the specified file
+ */
 - (instancetype)initWithPath: (OFString *)path
 		    encoding: (of_string_encoding_t)encoding
-    OF_DESIGNATED_INITIALIZER;
+		     options: (int)options OF_DESIGNATED_INITIALIZER;
 
 /*!
  * @brief Returns an @ref OFINICategory for the category with the specified
  *	  name.
  *
+ * If the file was loaded with `OF_INI_FILE_LAZY`, this is where the category
+ * is parsed.
+ *
  * @param name The name of the category for which an @ref OFINICategory should
  *	       be returned
  *
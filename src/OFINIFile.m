@@ -21,6 +21,7 @@
 
 #import "OFINIFile.h"
 #import "OFArray.h"
+#import "OFData.h"
 #import "OFString.h"
 #import "OFFile.h"
 #import "OFINICategory.h"
@@ -28,25 +29,14 @@
 
 #import "OFInvalidFormatException.h"
 #import "OFOpenItemFailedException.h"
+#import "OFRetrieveItemAttributesFailedException.h"
 
 @interface OFINIFile ()
 - (void)of_parseFile: (OFString *)path
-	    encoding: (of_string_encoding_t)encoding;
+	    encoding: (of_string_encoding_t)encoding
+	     options: (int)options;
 @end
 
-static bool
-isWhitespaceLine(OFString *line)
-{
-	const char *cString = line.UTF8String;
-	size_t length = line.UTF8StringLength;
-
-	for (size_t i = 0; i < length; i++)
-		if (!of_ascii_isspace(cString[i]))
-			return false;
-
-	return true;
-}
-
 @implementation OFINIFile
 + (instancetype)fileWithPath: (OFString *)path
 {
@@ -60,6 +50,15 @@ isWhitespaceLine(OFString *line)
 				  encoding: encoding] autorelease];
 }
 
++ (instancetype)fileWithPath: (OFString *)path
+		    encoding: (of_string_encoding_t)encoding
+		     options: (int)options
+{
+	return [[[self alloc] initWithPath: path
+				  encoding: encoding
+				   options: options] autorelease];
+}
+
 - (instancetype)init
 {
 	OF_INVALID_INIT_METHOD
@@ -73,6 +72,15 @@ isWhitespaceLine(OFString *line)
 
 - (instancetype)initWithPath: (OFString *)path
 		    encoding: (of_string_encoding_t)encoding
+{
+	return [self initWithPath: path
+			 encoding: encoding
+			  options: 0];
+}
+
+- (instancetype)initWithPath: (OFString *)path
+		    encoding: (of_string_encoding_t)encoding
+		     options: (int)options
 {
 	self = [super init];
 
@@ -80,7 +88,8 @@ isWhitespaceLine(OFString *line)
 		_categories = [[OFMutableArray alloc] init];
 
 		[self of_parseFile: path
-			  encoding: encoding];
+			  encoding: encoding
+			   options: options];
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -101,9 +110,14 @@ isWhitespaceLine(OFString *line)
 	void *pool = objc_autoreleasePoolPush();
 	OFINICategory *category;
 
-	for (category in _categories)
-		if ([category.name isEqual: name])
+	for (category in _categories) {
+		if ([category.name isEqual: name]) {
+			[category of_parseUnparsedLines];
+
+			objc_autoreleasePoolPop(pool);
 			return category;
+		}
+	}
 
 	category = [[[OFINICategory alloc] of_initWithName: name] autorelease];
 	[_categories addObject: category];
@@ -115,47 +129,89 @@ isWhitespaceLine(OFString *line)
 
 - (void)of_parseFile: (OFString *)path
 	    encoding: (of_string_encoding_t)encoding
+	     options: (int)options
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFFile *file;
+	OFData *data;
+	const char *items;
+	size_t count, categoryStart = 0;
 	OFINICategory *category = nil;
-	OFString *line;
 
 	@try {
-		file = [OFFile fileWithPath: path
-				       mode: @"r"];
+		/*
+		 * The lines of the categories reference the mapped file
+		 * instead of a copy of it.
+		 */
+		data = [OFData dataWithContentsOfMappedFile: path];
 	} @catch (OFOpenItemFailedException *e) {
 		/* Handle missing file like an empty file */
-		if (e.errNo == ENOENT)
+		if (e.errNo == ENOENT) {
+			objc_autoreleasePoolPop(pool);
 			return;
+		}
+
+		@throw e;
+	} @catch (OFRetrieveItemAttributesFailedException *e) {
+		/* Reading instead of mapping looks up the size first. */
+		if (e.errNo == ENOENT) {
+			objc_autoreleasePoolPop(pool);
+			return;
+		}
 
 		@throw e;
 	}
 
-	while ((line = [file readLineWithEncoding: encoding]) != nil) {
-		if (isWhitespaceLine(line))
+	items = data.items;
+	count = data.count;
+
+	/*
+	 * Only the category headers are looked at here. The lines in between
+	 * are handed to the category as they are and only turned into pairs
+	 * once the category is needed.
+	 */
+	for (size_t i = 0; i < count;) {
+		const char *line = items + i;
+		size_t lineLength, lineStart = i;
+		bool isWhitespace;
+
+		i += of_ini_scan_line(line, count - i, &lineLength,
+		    &isWhitespace);
+
+		if (isWhitespace)
 			continue;
 
-		if ([line hasPrefix: @"["]) {
+		if (line[0] == '[') {
 			OFString *categoryName;
 
-			if (![line hasSuffix: @"]"])
+			if (line[lineLength - 1] != ']')
 				@throw [OFInvalidFormatException exception];
 
-			categoryName = [line substringWithRange:
-			    of_range(1, line.length - 2)];
+			[category of_setUnparsedLines: [data subdataWithRange:
+			    of_range(categoryStart, lineStart - categoryStart)]
+					     encoding: encoding];
+
+			categoryName = [OFString
+			    stringWithCString: line + 1
+				     encoding: encoding
+				       length: lineLength - 2];
 
 			category = [[[OFINICategory alloc]
 			    of_initWithName: categoryName] autorelease];
 			[_categories addObject: category];
-		} else {
-			if (category == nil)
-				@throw [OFInvalidFormatException exception];
 
-			[category of_parseLine: line];
-		}
+			categoryStart = i;
+		} else if (category == nil)
+			@throw [OFInvalidFormatException exception];
 	}
 
+	[category of_setUnparsedLines: [data subdataWithRange:
+	    of_range(categoryStart, count - categoryStart)]
+			     encoding: encoding];
+
+	if (!(options & OF_INI_FILE_LAZY))
+		for (category in _categories)
+			[category of_parseUnparsedLines];
+
 	objc_autoreleasePoolPop(pool);
 }
 
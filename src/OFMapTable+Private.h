@@ -29,4 +29,20 @@ OF_ASSUME_NONNULL_BEGIN
 			    object: (id)object;
 @end
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Functions for map tables of objects, which are retained and compared using
+ * -[isEqual:].
+ */
+extern void *of_map_table_object_retain(void *object);
+extern void of_map_table_object_release(void *object);
+extern uint32_t of_map_table_object_hash(void *object);
+extern bool of_map_table_object_equal(void *object1, void *object2);
+extern const of_map_table_functions_t of_map_table_object_functions;
+#ifdef __cplusplus
+}
+#endif
+
 OF_ASSUME_NONNULL_END
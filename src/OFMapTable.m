@@ -61,6 +61,37 @@ defaultEqual(void *object1, void *object2)
 	return (object1 == object2);
 }
 
+void *
+of_map_table_object_retain(void *object)
+{
+	return [(id)object retain];
+}
+
+void
+of_map_table_object_release(void *object)
+{
+	[(id)object release];
+}
+
+uint32_t
+of_map_table_object_hash(void *object)
+{
+	return [(id)object hash];
+}
+
+bool
+of_map_table_object_equal(void *object1, void *object2)
+{
+	return [(id)object1 isEqual: (id)object2];
+}
+
+const of_map_table_functions_t of_map_table_object_functions = {
+	.retain = of_map_table_object_retain,
+	.release = of_map_table_object_release,
+	.hash = of_map_table_object_hash,
+	.equal = of_map_table_object_equal
+};
+
 @interface OFMapTable ()
 - (void)of_setObject: (void *)object
 	      forKey: (void *)key
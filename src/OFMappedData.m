@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+#import "OFMappedData.h"
+#import "OFFile.h"
+#import "OFFileManager.h"
+
+#import "OFOutOfRangeException.h"
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && \
+    defined(HAVE_SYS_STAT_H) && defined(OF_FILE_HANDLE_IS_FD)
+# define USE_MMAP
+#endif
+
+@implementation OFMappedData
+- (instancetype)initWithPath: (OFString *)path
+		     options: (int)options
+{
+#ifdef USE_MMAP
+	void *items;
+	size_t size = 0;
+
+	@try {
+		OFFile *file = [[OFFile alloc] initWithPath: path
+						       mode: @"r"];
+
+		@try {
+			int fd = file.fileDescriptorForReading;
+			struct stat st;
+
+			/*
+			 * The size is taken from the opened file, as the file
+			 * at the path might be replaced in the meantime.
+			 */
+			if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+				items = MAP_FAILED;
+			else if (st.st_size == 0)
+				/* Empty files cannot be mapped. */
+				items = (void *)"";
+			else {
+				if ((uintmax_t)st.st_size > SIZE_MAX)
+					@throw [OFOutOfRangeException
+					    exception];
+
+				size = (size_t)st.st_size;
+
+				/*
+				 * The mapping stays valid after closing the
+				 * file.
+				 */
+				items = mmap(NULL, size, PROT_READ,
+				    MAP_PRIVATE, fd, 0);
+			}
+		} @finally {
+			[file release];
+		}
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	/*
+	 * Not all files can be mapped, e.g. those on some network file
+	 * systems or those that are not regular files, so fall back to reading
+	 * them.
+	 */
+	if (items == MAP_FAILED) {
+		[self release];
+		return [[OFData alloc] initWithContentsOfFile: path];
+	}
+
+# ifdef HAVE_MADVISE
+	if (size > 0) {
+		if (options & OF_FILE_MANAGER_CONTENTS_SEQUENTIAL)
+			madvise(items, size, MADV_SEQUENTIAL);
+		else if (options & OF_FILE_MANAGER_CONTENTS_RANDOM)
+			madvise(items, size, MADV_RANDOM);
+	}
+# endif
+
+	@try {
+		self = [super initWithItemsNoCopy: items
+					    count: size
+				     freeWhenDone: false];
+	} @catch (id e) {
+		if (size > 0)
+			munmap(items, size);
+
+		@throw e;
+	}
+
+	_mappedLength = size;
+
+	return self;
+#else
+	[self release];
+	return [[OFData alloc] initWithContentsOfFile: path];
+#endif
+}
+
+- (void)dealloc
+{
+#ifdef USE_MMAP
+	if (_mappedLength > 0)
+		munmap(_items, _mappedLength);
+#endif
+
+	[super dealloc];
+}
+@end
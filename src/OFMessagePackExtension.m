@@ -19,6 +19,7 @@
 
 #import "OFMessagePackExtension.h"
 #import "OFData.h"
+#import "OFMessagePackWriter.h"
 #import "OFString.h"
 
 #import "OFInvalidArgumentException.h"
@@ -66,91 +67,7 @@
 
 - (OFData *)messagePackRepresentation
 {
-	OFMutableData *ret;
-	uint8_t prefix;
-	size_t count = _data.count;
-
-	if (count == 1) {
-		ret = [OFMutableData dataWithCapacity: 3];
-
-		prefix = 0xD4;
-		[ret addItem: &prefix];
-
-		[ret addItem: &_type];
-	} else if (count == 2) {
-		ret = [OFMutableData dataWithCapacity: 4];
-
-		prefix = 0xD5;
-		[ret addItem: &prefix];
-
-		[ret addItem: &_type];
-	} else if (count == 4) {
-		ret = [OFMutableData dataWithCapacity: 6];
-
-		prefix = 0xD6;
-		[ret addItem: &prefix];
-
-		[ret addItem: &_type];
-	} else if (count == 8) {
-		ret = [OFMutableData dataWithCapacity: 10];
-
-		prefix = 0xD7;
-		[ret addItem: &prefix];
-
-		[ret addItem: &_type];
-	} else if (count == 16) {
-		ret = [OFMutableData dataWithCapacity: 18];
-
-		prefix = 0xD8;
-		[ret addItem: &prefix];
-
-		[ret addItem: &_type];
-	} else if (count < 0x100) {
-		uint8_t length;
-
-		ret = [OFMutableData dataWithCapacity: count + 3];
-
-		prefix = 0xC7;
-		[ret addItem: &prefix];
-
-		length = (uint8_t)count;
-		[ret addItem: &length];
-
-		[ret addItem: &_type];
-	} else if (count < 0x10000) {
-		uint16_t length;
-
-		ret = [OFMutableData dataWithCapacity: count + 4];
-
-		prefix = 0xC8;
-		[ret addItem: &prefix];
-
-		length = OF_BSWAP16_IF_LE((uint16_t)count);
-		[ret addItems: &length
-			count: 2];
-
-		[ret addItem: &_type];
-	} else {
-		uint32_t length;
-
-		ret = [OFMutableData dataWithCapacity: count + 6];
-
-		prefix = 0xC9;
-		[ret addItem: &prefix];
-
-		length = OF_BSWAP32_IF_LE((uint32_t)count);
-		[ret addItems: &length
-			count: 4];
-
-		[ret addItem: &_type];
-	}
-
-	[ret addItems: _data.items
-		count: _data.count];
-
-	[ret makeImmutable];
-
-	return ret;
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
 }
 
 - (OFString *)description
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFStream;
+
+/*!
+ * @class OFMessagePackReader OFMessagePackReader.h ObjFW/OFMessagePackReader.h
+ *
+ * @brief A class for incrementally parsing a sequence of MessagePack objects
+ *	  that arrive in chunks, e.g. from a socket.
+ *
+ * Data can be added in chunks of arbitrary size. Only the bytes added since
+ * the last call are examined to find out whether an object is complete, so
+ * objects split into many small chunks can be parsed in linear time.
+ */
+@interface OFMessagePackReader: OFObject
+{
+	int _options;
+	size_t _depthLimit;
+	unsigned char *_Nullable _items;
+	size_t _count, _capacity, _offset, _scanPosition;
+	size_t *_Nullable _pending;
+	size_t _pendingCount, _pendingCapacity;
+}
+
+/*!
+ * @brief The options used for parsing.
+ *
+ * See @ref OFData::messagePackValueWithOptions:depthLimit: for possible
+ * values.
+ *
+ * If `OF_MESSAGE_PACK_VALUE_NO_COPY` is specified, the OFData returned for
+ * binary data reference the storage of the complete object, which is handed
+ * over from the reader without copying if possible.
+ */
+@property (readonly, nonatomic) int options;
+
+/*!
+ * @brief The maximum depth the parser should accept (defaults to 32, 0 means
+ *	  no limit (insecure!))
+ */
+@property (nonatomic) size_t depthLimit;
+
+/*!
+ * @brief Whether the reader has data that is not part of an object that was
+ *	  returned yet.
+ */
+@property (readonly, nonatomic) bool hasDataInBuffer;
+
+/*!
+ * @brief Creates a new OFMessagePackReader.
+ *
+ * @return A new, autoreleased OFMessagePackReader
+ */
++ (instancetype)reader;
+
+/*!
+ * @brief Creates a new OFMessagePackReader with the specified options.
+ *
+ * @param options The options to use for parsing
+ * @return A new, autoreleased OFMessagePackReader
+ */
++ (instancetype)readerWithOptions: (int)options;
+
+/*!
+ * @brief Initializes an already allocated OFMessagePackReader with the
+ *	  specified options.
+ *
+ * @param options The options to use for parsing
+ * @return An initialized OFMessagePackReader
+ */
+- (instancetype)initWithOptions: (int)options OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Adds the specified bytes to the data to parse.
+ *
+ * @param items The bytes to add
+ * @param count The number of bytes to add
+ */
+- (void)addItems: (const void *)items
+	   count: (size_t)count;
+
+/*!
+ * @brief Returns the next complete object or `nil` if more data is needed.
+ *
+ * @return The next complete object or `nil` if more data is needed
+ */
+- (nullable id)nextObject;
+
+/*!
+ * @brief Reads from the specified stream until an object is complete and
+ *	  returns it.
+ *
+ * Data that was read beyond the end of the object is kept in the reader and
+ * used for the next object.
+ *
+ * @param stream The stream to read from
+ * @return The next object or `nil` if the end of the stream was reached
+ *	   before the start of an object
+ * @throw OFTruncatedDataException The end of the stream was reached inside an
+ *				   object
+ */
+- (nullable id)readObjectFromStream: (OFStream *)stream;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFMessagePackReader.h"
+#import "OFData.h"
+#import "OFData+MessagePackValue.h"
+#import "OFStream.h"
+
+#import "OFInvalidFormatException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+#import "OFTruncatedDataException.h"
+
+#define MIN_READ_SIZE 512
+#define MAX_READ_SIZE 65536
+
+static uint16_t
+readUInt16(const unsigned char *buffer)
+{
+	return ((uint16_t)buffer[0] << 8) | buffer[1];
+}
+
+static uint32_t
+readUInt32(const unsigned char *buffer)
+{
+	return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) |
+	    ((uint32_t)buffer[2] << 8) | buffer[3];
+}
+
+/*
+ * Returns the length of the header of the object at buffer and stores the
+ * length of the payload that follows it as well as the number of children that
+ * follow it. Returns 0 if more bytes are needed to know that.
+ */
+static size_t
+scanHeader(const unsigned char *buffer, size_t length, size_t *payloadLength,
+    size_t *childrenCount)
+{
+	uint8_t prefix = buffer[0];
+	uint32_t count;
+
+	*payloadLength = 0;
+	*childrenCount = 0;
+
+	/* positive and negative fixint */
+	if (prefix <= 0x7F || prefix >= 0xE0)
+		return 1;
+	/* fixmap */
+	if (prefix <= 0x8F) {
+		*childrenCount = 2 * (prefix & 0xF);
+		return 1;
+	}
+	/* fixarray */
+	if (prefix <= 0x9F) {
+		*childrenCount = prefix & 0xF;
+		return 1;
+	}
+	/* fixstr */
+	if (prefix <= 0xBF) {
+		*payloadLength = prefix & 0x1F;
+		return 1;
+	}
+
+	switch (prefix) {
+	/* Types that only consist of a header */
+	case 0xC0: /* nil */
+	case 0xC2: /* false */
+	case 0xC3: /* true */
+		return 1;
+	case 0xCC: /* uint 8 */
+	case 0xD0: /* int 8 */
+		return 2;
+	case 0xCD: /* uint 16 */
+	case 0xD1: /* int 16 */
+		return 3;
+	case 0xCA: /* float 32 */
+	case 0xCE: /* uint 32 */
+	case 0xD2: /* int 32 */
+		return 5;
+	case 0xCB: /* float 64 */
+	case 0xCF: /* uint 64 */
+	case 0xD3: /* int 64 */
+		return 9;
+	case 0xD4: /* fixext 1 */
+		return 3;
+	case 0xD5: /* fixext 2 */
+		return 4;
+	case 0xD6: /* fixext 4 */
+		return 6;
+	case 0xD7: /* fixext 8 */
+		return 10;
+	case 0xD8: /* fixext 16 */
+		return 18;
+	/* Types with a length or count */
+	case 0xC4: /* bin 8 */
+	case 0xD9: /* str 8 */
+		if (length < 2)
+			return 0;
+
+		*payloadLength = buffer[1];
+		return 2;
+	case 0xC5: /* bin 16 */
+	case 0xDA: /* str 16 */
+		if (length < 3)
+			return 0;
+
+		*payloadLength = readUInt16(buffer + 1);
+		return 3;
+	case 0xC6: /* bin 32 */
+	case 0xDB: /* str 32 */
+		if (length < 5)
+			return 0;
+
+		*payloadLength = readUInt32(buffer + 1);
+		return 5;
+	case 0xC7: /* ext 8 */
+		if (length < 3)
+			return 0;
+
+		*payloadLength = buffer[1];
+		return 3;
+	case 0xC8: /* ext 16 */
+		if (length < 4)
+			return 0;
+
+		*payloadLength = readUInt16(buffer + 1);
+		return 4;
+	case 0xC9: /* ext 32 */
+		if (length < 6)
+			return 0;
+
+		*payloadLength = readUInt32(buffer + 1);
+		return 6;
+	case 0xDC: /* array 16 */
+		if (length < 3)
+			return 0;
+
+		*childrenCount = readUInt16(buffer + 1);
+		return 3;
+	case 0xDD: /* array 32 */
+		if (length < 5)
+			return 0;
+
+		*childrenCount = readUInt32(buffer + 1);
+		return 5;
+	case 0xDE: /* map 16 */
+		if (length < 3)
+			return 0;
+
+		*childrenCount = 2 * (size_t)readUInt16(buffer + 1);
+		return 3;
+	case 0xDF: /* map 32 */
+		if (length < 5)
+			return 0;
+
+		count = readUInt32(buffer + 1);
+
+#if UINT32_MAX > SIZE_MAX / 2
+		if (count > SIZE_MAX / 2)
+			@throw [OFOutOfRangeException exception];
+#endif
+
+		*childrenCount = 2 * (size_t)count;
+		return 5;
+	default:
+		@throw [OFInvalidFormatException exception];
+	}
+}
+
+@interface OFMessagePackReader ()
+- (void)of_makeRoomForCount: (size_t)count;
+- (void)of_pushPending: (size_t)count;
+@end
+
+@implementation OFMessagePackReader
+@synthesize options = _options, depthLimit = _depthLimit;
+
++ (instancetype)reader
+{
+	return [[[self alloc] init] autorelease];
+}
+
++ (instancetype)readerWithOptions: (int)options
+{
+	return [[[self alloc] initWithOptions: options] autorelease];
+}
+
+- (instancetype)init
+{
+	return [self initWithOptions: 0];
+}
+
+- (instancetype)initWithOptions: (int)options
+{
+	self = [super init];
+
+	_options = options;
+	_depthLimit = 32;
+
+	return self;
+}
+
+- (void)dealloc
+{
+	free(_items);
+
+	[super dealloc];
+}
+
+- (bool)hasDataInBuffer
+{
+	return (_offset < _count);
+}
+
+- (void)of_makeRoomForCount: (size_t)count
+{
+	size_t capacity;
+	unsigned char *items;
+
+	if (_capacity - _count >= count)
+		return;
+
+	/* Move the data that has not been consumed yet to the front first. */
+	if (_offset > 0) {
+		memmove(_items, _items + _offset, _count - _offset);
+
+		if (_pendingCount > 0)
+			_scanPosition -= _offset;
+
+		_count -= _offset;
+		_offset = 0;
+
+		if (_capacity - _count >= count)
+			return;
+	}
+
+	if (SIZE_MAX - _count < count)
+		@throw [OFOutOfRangeException exception];
+
+	capacity = _count + count;
+	if (capacity < MIN_READ_SIZE)
+		capacity = MIN_READ_SIZE;
+	if (capacity < _capacity * 2 && _capacity <= SIZE_MAX / 2)
+		capacity = _capacity * 2;
+
+	if ((items = realloc(_items, capacity)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: capacity];
+
+	_items = items;
+	_capacity = capacity;
+}
+
+- (void)addItems: (const void *)items
+	   count: (size_t)count
+{
+	[self of_makeRoomForCount: count];
+
+	memcpy(_items + _count, items, count);
+	_count += count;
+}
+
+- (void)of_pushPending: (size_t)count
+{
+	if (_depthLimit != 0 && _pendingCount > _depthLimit)
+		@throw [OFOutOfRangeException exception];
+
+	if (_pendingCount == _pendingCapacity) {
+		_pending = [self resizeMemory: _pending
+					 size: sizeof(*_pending)
+					count: _pendingCapacity + 8];
+		_pendingCapacity += 8;
+	}
+
+	_pending[_pendingCount++] = count;
+}
+
+- (id)nextObject
+{
+	void *pool;
+	size_t length;
+	OFData *data;
+	id object;
+
+	/* Start a new object. */
+	if (_pendingCount == 0) {
+		if (_offset == _count)
+			return nil;
+
+		_scanPosition = _offset;
+		[self of_pushPending: 1];
+	}
+
+	/*
+	 * Continue scanning where we stopped last time. Only the headers are
+	 * looked at, payloads are skipped, even if they have not been
+	 * received completely yet.
+	 */
+	for (;;) {
+		size_t headerLength, payloadLength, childrenCount;
+
+		while (_pendingCount > 1 && _pending[_pendingCount - 1] == 0)
+			_pendingCount--;
+
+		if (_pending[_pendingCount - 1] == 0 || _scanPosition >= _count)
+			break;
+
+		headerLength = scanHeader(_items + _scanPosition,
+		    _count - _scanPosition, &payloadLength, &childrenCount);
+		if (headerLength == 0)
+			return nil;
+
+		if (SIZE_MAX - _scanPosition - headerLength < payloadLength)
+			@throw [OFOutOfRangeException exception];
+
+		_pending[_pendingCount - 1]--;
+		_scanPosition += headerLength + payloadLength;
+
+		if (childrenCount > 0)
+			[self of_pushPending: childrenCount];
+	}
+
+	if (_pending[_pendingCount - 1] > 0 || _scanPosition > _count)
+		return nil;
+
+	length = _scanPosition - _offset;
+
+	pool = objc_autoreleasePoolPush();
+
+	@try {
+		if (!(_options & OF_MESSAGE_PACK_VALUE_NO_COPY))
+			data = [OFData dataWithItemsNoCopy: _items + _offset
+						     count: length
+					      freeWhenDone: false];
+		else if (_scanPosition == _count) {
+			/*
+			 * Nothing follows the object, so we can hand the buffer
+			 * over instead of copying the object.
+			 */
+			OFData *buffer = [OFData
+			    dataWithItemsNoCopy: _items
+					  count: _count
+				   freeWhenDone: true];
+
+			_items = NULL;
+			_capacity = 0;
+
+			data = [buffer subdataWithRange:
+			    of_range(_offset, length)];
+		} else
+			data = [OFData dataWithItems: _items + _offset
+					       count: length];
+
+		object = [[data messagePackValueWithOptions: _options
+						 depthLimit: _depthLimit]
+		    retain];
+	} @finally {
+		_pendingCount = 0;
+		_offset = _scanPosition;
+
+		if (_offset == _count || _items == NULL)
+			_offset = _count = 0;
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return [object autorelease];
+}
+
+- (id)readObjectFromStream: (OFStream *)stream
+{
+	for (;;) {
+		id object = [self nextObject];
+		size_t length;
+
+		if (object != nil)
+			return object;
+
+		if (stream.atEndOfStream) {
+			if (_offset < _count)
+				@throw [OFTruncatedDataException exception];
+
+			return nil;
+		}
+
+		/*
+		 * If we know that a large payload is still missing, read it
+		 * directly into our buffer in large chunks.
+		 */
+		length = MIN_READ_SIZE;
+		if (_pendingCount > 0 && _scanPosition > _count &&
+		    _scanPosition - _count > length) {
+			length = _scanPosition - _count;
+
+			if (length > MAX_READ_SIZE)
+				length = MAX_READ_SIZE;
+		}
+
+		[self of_makeRoomForCount: length];
+
+		_count += [stream readIntoBuffer: _items + _count
+					  length: length];
+	}
+}
+@end
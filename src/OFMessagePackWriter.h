@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFMessagePackRepresentation.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+@class OFStream;
+
+/*!
+ * @class OFMessagePackWriter OFMessagePackWriter.h ObjFW/OFMessagePackWriter.h
+ *
+ * @brief A class for encoding object graphs to MessagePack without creating
+ *	  intermediate representations for every object.
+ *
+ * Objects of the classes shipped with ObjFW are encoded directly into the
+ * destination, be it a single buffer that is sized exactly in advance or a
+ * stream. Any other object conforming to @ref OFMessagePackRepresentation is
+ * encoded by asking it for its MessagePack representation.
+ */
+@interface OFMessagePackWriter: OFObject
+{
+	OFStream *_stream;
+	unsigned char *_buffer;
+	size_t _bufferLength;
+}
+
+/*!
+ * @brief The stream the writer writes to.
+ */
+@property (readonly, nonatomic) OFStream *stream;
+
+/*!
+ * @brief Returns the length the MessagePack representation of the specified
+ *	  object would have.
+ *
+ * @param object The object whose MessagePack representation length should be
+ *		 calculated
+ * @return The length of the MessagePack representation of the object
+ */
++ (size_t)messagePackLengthOfObject: (id <OFMessagePackRepresentation>)object;
+
+/*!
+ * @brief Returns the MessagePack representation of the specified object as
+ *	  OFData.
+ *
+ * The length of the representation is calculated first, so that the whole
+ * object graph can be encoded into a single allocation.
+ *
+ * @param object The object to encode
+ * @return The MessagePack representation of the object
+ */
++ (OFData *)messagePackRepresentationOfObject:
+    (id <OFMessagePackRepresentation>)object;
+
+/*!
+ * @brief Creates a new OFMessagePackWriter that writes to the specified
+ *	  stream.
+ *
+ * @param stream The stream to write to
+ * @return A new, autoreleased OFMessagePackWriter
+ */
++ (instancetype)writerWithStream: (OFStream *)stream;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated OFMessagePackWriter to write to the
+ *	  specified stream.
+ *
+ * @param stream The stream to write to
+ * @return An initialized OFMessagePackWriter
+ */
+- (instancetype)initWithStream: (OFStream *)stream OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Writes the MessagePack representation of the specified object.
+ *
+ * Small items are collected in an internal buffer, which is written to the
+ * stream when it is full, when @ref flush is called or when the writer is
+ * deallocated.
+ *
+ * @param object The object to write
+ */
+- (void)writeObject: (id <OFMessagePackRepresentation>)object;
+
+/*!
+ * @brief Writes all data that is still in the internal buffer to the stream.
+ */
+- (void)flush;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,657 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#import "OFMessagePackWriter.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFEnumerator.h"
+#import "OFMessagePackExtension.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+
+#define BUFFER_SIZE 4096
+
+enum kind {
+	KIND_OTHER,
+	KIND_STRING,
+	KIND_NUMBER,
+	KIND_NULL,
+	KIND_DATA,
+	KIND_DATE,
+	KIND_EXTENSION,
+	KIND_ARRAY,
+	KIND_DICTIONARY
+};
+
+struct writer {
+	unsigned char *buffer;
+	size_t length, size;
+	/* nil if writing into a buffer of exactly the right size */
+	OFStream *stream;
+	/*
+	 * The representations of other objects created while calculating the
+	 * length, in the order they are written, or nil if they are created
+	 * while writing.
+	 */
+	OFArray *representations;
+	size_t representationsIndex;
+};
+
+static IMP stringIMP, numberIMP, nullIMP, dataIMP, dateIMP, extensionIMP;
+static IMP arrayIMP, dictionaryIMP;
+
+static void writeObject(struct writer *writer, id object);
+
+/*
+ * Objects are only encoded directly if they use the implementation of
+ * -[messagePackRepresentation] of the class we know, so that subclasses
+ * overriding it (e.g. OFSecureData) still get to decide.
+ */
+static enum kind
+kindOfObject(id object)
+{
+	IMP imp = [object methodForSelector:
+	    @selector(messagePackRepresentation)];
+
+	if (imp == stringIMP)
+		return KIND_STRING;
+	if (imp == numberIMP)
+		return KIND_NUMBER;
+	if (imp == nullIMP)
+		return KIND_NULL;
+	if (imp == dataIMP)
+		return KIND_DATA;
+	if (imp == dateIMP)
+		return KIND_DATE;
+	if (imp == extensionIMP)
+		return KIND_EXTENSION;
+	if (imp == arrayIMP)
+		return KIND_ARRAY;
+	if (imp == dictionaryIMP)
+		return KIND_DICTIONARY;
+
+	return KIND_OTHER;
+}
+
+static size_t
+encodeHeader(unsigned char *buffer, size_t count, uint8_t type8,
+    uint8_t type16, uint8_t type32)
+{
+	if (count <= UINT8_MAX && type8 != 0) {
+		buffer[0] = type8;
+		buffer[1] = (uint8_t)count;
+		return 2;
+	} else if (count <= UINT16_MAX) {
+		uint16_t tmp = OF_BSWAP16_IF_LE((uint16_t)count);
+
+		buffer[0] = type16;
+		memcpy(buffer + 1, &tmp, sizeof(tmp));
+		return 3;
+	} else if (count <= UINT32_MAX) {
+		uint32_t tmp = OF_BSWAP32_IF_LE((uint32_t)count);
+
+		buffer[0] = type32;
+		memcpy(buffer + 1, &tmp, sizeof(tmp));
+		return 5;
+	} else
+		@throw [OFOutOfRangeException exception];
+}
+
+static size_t
+encodeStringHeader(unsigned char *buffer, size_t length)
+{
+	if (length <= 31) {
+		buffer[0] = 0xA0 | ((uint8_t)length & 0x1F);
+		return 1;
+	}
+
+	return encodeHeader(buffer, length, 0xD9, 0xDA, 0xDB);
+}
+
+static size_t
+encodeDataHeader(unsigned char *buffer, size_t count)
+{
+	return encodeHeader(buffer, count, 0xC4, 0xC5, 0xC6);
+}
+
+static size_t
+encodeArrayHeader(unsigned char *buffer, size_t count)
+{
+	if (count <= 15) {
+		buffer[0] = 0x90 | ((uint8_t)count & 0xF);
+		return 1;
+	}
+
+	return encodeHeader(buffer, count, 0, 0xDC, 0xDD);
+}
+
+static size_t
+encodeMapHeader(unsigned char *buffer, size_t count)
+{
+	if (count <= 15) {
+		buffer[0] = 0x80 | ((uint8_t)count & 0xF);
+		return 1;
+	}
+
+	return encodeHeader(buffer, count, 0, 0xDE, 0xDF);
+}
+
+static size_t
+encodeExtensionHeader(unsigned char *buffer, int8_t type, size_t count)
+{
+	size_t length;
+
+	switch (count) {
+	case 1:
+		buffer[0] = 0xD4;
+		length = 1;
+		break;
+	case 2:
+		buffer[0] = 0xD5;
+		length = 1;
+		break;
+	case 4:
+		buffer[0] = 0xD6;
+		length = 1;
+		break;
+	case 8:
+		buffer[0] = 0xD7;
+		length = 1;
+		break;
+	case 16:
+		buffer[0] = 0xD8;
+		length = 1;
+		break;
+	default:
+		length = encodeHeader(buffer, count, 0xC7, 0xC8, 0xC9);
+		break;
+	}
+
+	buffer[length] = (uint8_t)type;
+
+	return length + 1;
+}
+
+static size_t
+encodeNumber(unsigned char *buffer, OFNumber *number)
+{
+	of_number_type_t type = number.type;
+
+	if (type == OF_NUMBER_TYPE_BOOL) {
+		buffer[0] = (number.boolValue ? 0xC3 : 0xC2);
+		return 1;
+	} else if (type == OF_NUMBER_TYPE_FLOAT) {
+		float tmp = OF_BSWAP_FLOAT_IF_LE(number.floatValue);
+
+		buffer[0] = 0xCA;
+		memcpy(buffer + 1, &tmp, sizeof(tmp));
+		return 5;
+	} else if (type == OF_NUMBER_TYPE_DOUBLE) {
+		double tmp = OF_BSWAP_DOUBLE_IF_LE(number.doubleValue);
+
+		buffer[0] = 0xCB;
+		memcpy(buffer + 1, &tmp, sizeof(tmp));
+		return 9;
+	} else if (type & OF_NUMBER_TYPE_SIGNED) {
+		intmax_t value = number.intMaxValue;
+
+		if (value >= -32 && value < 0) {
+			buffer[0] = 0xE0 | ((uint8_t)(value - 32) & 0x1F);
+			return 1;
+		} else if (value >= INT8_MIN && value <= INT8_MAX) {
+			buffer[0] = 0xD0;
+			buffer[1] = (uint8_t)(int8_t)value;
+			return 2;
+		} else if (value >= INT16_MIN && value <= INT16_MAX) {
+			int16_t tmp = OF_BSWAP16_IF_LE((int16_t)value);
+
+			buffer[0] = 0xD1;
+			memcpy(buffer + 1, &tmp, sizeof(tmp));
+			return 3;
+		} else if (value >= INT32_MIN && value <= INT32_MAX) {
+			int32_t tmp = OF_BSWAP32_IF_LE((int32_t)value);
+
+			buffer[0] = 0xD2;
+			memcpy(buffer + 1, &tmp, sizeof(tmp));
+			return 5;
+		} else if (value >= INT64_MIN && value <= INT64_MAX) {
+			int64_t tmp = OF_BSWAP64_IF_LE((int64_t)value);
+
+			buffer[0] = 0xD3;
+			memcpy(buffer + 1, &tmp, sizeof(tmp));
+			return 9;
+		} else
+			@throw [OFOutOfRangeException exception];
+	} else {
+		uintmax_t value = number.uIntMaxValue;
+
+		if (value <= 127) {
+			buffer[0] = ((uint8_t)value & 0x7F);
+			return 1;
+		} else if (value <= UINT8_MAX) {
+			buffer[0] = 0xCC;
+			buffer[1] = (uint8_t)value;
+			return 2;
+		} else if (value <= UINT16_MAX) {
+			uint16_t tmp = OF_BSWAP16_IF_LE((uint16_t)value);
+
+			buffer[0] = 0xCD;
+			memcpy(buffer + 1, &tmp, sizeof(tmp));
+			return 3;
+		} else if (value <= UINT32_MAX) {
+			uint32_t tmp = OF_BSWAP32_IF_LE((uint32_t)value);
+
+			buffer[0] = 0xCE;
+			memcpy(buffer + 1, &tmp, sizeof(tmp));
+			return 5;
+		} else if (value <= UINT64_MAX) {
+			uint64_t tmp = OF_BSWAP64_IF_LE((uint64_t)value);
+
+			buffer[0] = 0xCF;
+			memcpy(buffer + 1, &tmp, sizeof(tmp));
+			return 9;
+		} else
+			@throw [OFOutOfRangeException exception];
+	}
+}
+
+static size_t
+encodeDate(unsigned char *buffer, OFDate *date)
+{
+	of_time_interval_t timeInterval = date.timeIntervalSince1970;
+	int64_t seconds = (int64_t)timeInterval;
+	uint32_t nanoseconds =
+	    (timeInterval - trunc(timeInterval)) * 1000000000;
+	size_t length;
+
+	if (seconds >= 0 && seconds < 0x400000000) {
+		if (seconds <= UINT32_MAX && nanoseconds == 0) {
+			uint32_t seconds32 =
+			    OF_BSWAP32_IF_LE((uint32_t)seconds);
+
+			length = encodeExtensionHeader(buffer, -1, 4);
+			memcpy(buffer + length, &seconds32, 4);
+
+			return length + 4;
+		} else {
+			uint64_t combined = ((uint64_t)nanoseconds << 34) |
+			    (uint64_t)seconds;
+
+			combined = OF_BSWAP64_IF_LE(combined);
+
+			length = encodeExtensionHeader(buffer, -1, 8);
+			memcpy(buffer + length, &combined, 8);
+
+			return length + 8;
+		}
+	} else {
+		seconds = OF_BSWAP64_IF_LE(seconds);
+		nanoseconds = OF_BSWAP32_IF_LE(nanoseconds);
+
+		length = encodeExtensionHeader(buffer, -1, 12);
+		memcpy(buffer + length, &nanoseconds, 4);
+		memcpy(buffer + length + 4, &seconds, 8);
+
+		return length + 12;
+	}
+}
+
+static size_t
+addLength(size_t length, size_t add)
+{
+	if (SIZE_MAX - length < add)
+		@throw [OFOutOfRangeException exception];
+
+	return length + add;
+}
+
+/*
+ * If representations is not nil, the representations of objects that are not
+ * encoded directly are added to it, so that they only need to be created
+ * once.
+ */
+static size_t
+lengthOfObject(id object, OFMutableArray *representations)
+{
+	unsigned char header[16];
+	size_t length, count;
+
+	switch (kindOfObject(object)) {
+	case KIND_STRING:
+		count = [object UTF8StringLength];
+		return addLength(encodeStringHeader(header, count), count);
+	case KIND_NUMBER:
+		return encodeNumber(header, object);
+	case KIND_NULL:
+		return 1;
+	case KIND_DATA:
+		if ([object itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		count = [object count];
+		return addLength(encodeDataHeader(header, count), count);
+	case KIND_DATE:
+		return encodeDate(header, object);
+	case KIND_EXTENSION:
+		count = [[object data] count];
+		return addLength(encodeExtensionHeader(header,
+		    [object type], count), count);
+	case KIND_ARRAY:
+		length = encodeArrayHeader(header, [object count]);
+
+		for (id child in object)
+			length = addLength(length,
+			    lengthOfObject(child, representations));
+
+		return length;
+	case KIND_DICTIONARY:;
+		OFEnumerator *keyEnumerator = [object keyEnumerator];
+		OFEnumerator *objectEnumerator = [object objectEnumerator];
+		id key, value;
+
+		length = encodeMapHeader(header, [object count]);
+
+		while ((key = [keyEnumerator nextObject]) != nil &&
+		    (value = [objectEnumerator nextObject]) != nil) {
+			length = addLength(length,
+			    lengthOfObject(key, representations));
+			length = addLength(length,
+			    lengthOfObject(value, representations));
+		}
+
+		return length;
+	default:;
+		OFData *data = [object messagePackRepresentation];
+
+		[representations addObject: data];
+
+		return data.count;
+	}
+}
+
+static void
+flushWriter(struct writer *writer)
+{
+	if (writer->length == 0)
+		return;
+
+	[writer->stream writeBuffer: writer->buffer
+			     length: writer->length];
+	writer->length = 0;
+}
+
+static void
+appendBytes(struct writer *writer, const void *bytes, size_t length)
+{
+	if (length > writer->size - writer->length) {
+		/*
+		 * If we are writing into a buffer of a precalculated size,
+		 * this means an object changed its representation between
+		 * calculating the length and writing it.
+		 */
+		if (writer->stream == nil)
+			@throw [OFOutOfRangeException exception];
+
+		flushWriter(writer);
+
+		/* Large items are written to the stream without copying */
+		if (length >= writer->size) {
+			[writer->stream writeBuffer: bytes
+					     length: length];
+			return;
+		}
+	}
+
+	memcpy(writer->buffer + writer->length, bytes, length);
+	writer->length += length;
+}
+
+static void
+writeObject(struct writer *writer, id object)
+{
+	unsigned char header[16];
+	size_t count;
+	OFData *data;
+
+	switch (kindOfObject(object)) {
+	case KIND_STRING:
+		count = [object UTF8StringLength];
+		appendBytes(writer, header, encodeStringHeader(header, count));
+		appendBytes(writer, [object UTF8String], count);
+		break;
+	case KIND_NUMBER:
+		appendBytes(writer, header, encodeNumber(header, object));
+		break;
+	case KIND_NULL:
+		header[0] = 0xC0;
+		appendBytes(writer, header, 1);
+		break;
+	case KIND_DATA:
+		if ([object itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		count = [object count];
+		appendBytes(writer, header, encodeDataHeader(header, count));
+		appendBytes(writer, [object items], count);
+		break;
+	case KIND_DATE:
+		appendBytes(writer, header, encodeDate(header, object));
+		break;
+	case KIND_EXTENSION:
+		data = [object data];
+
+		count = data.count;
+		appendBytes(writer, header, encodeExtensionHeader(header,
+		    [object type], count));
+		appendBytes(writer, data.items, count);
+		break;
+	case KIND_ARRAY:
+		appendBytes(writer, header,
+		    encodeArrayHeader(header, [object count]));
+
+		for (id child in object)
+			writeObject(writer, child);
+
+		break;
+	case KIND_DICTIONARY:;
+		OFEnumerator *keyEnumerator = [object keyEnumerator];
+		OFEnumerator *objectEnumerator = [object objectEnumerator];
+		id key, value;
+
+		appendBytes(writer, header,
+		    encodeMapHeader(header, [object count]));
+
+		while ((key = [keyEnumerator nextObject]) != nil &&
+		    (value = [objectEnumerator nextObject]) != nil) {
+			writeObject(writer, key);
+			writeObject(writer, value);
+		}
+
+		break;
+	default:;
+		void *pool;
+
+		if (writer->representations != nil) {
+			data = [writer->representations
+			    objectAtIndex: writer->representationsIndex++];
+			appendBytes(writer, data.items, data.count);
+			break;
+		}
+
+		pool = objc_autoreleasePoolPush();
+
+		data = [object messagePackRepresentation];
+		appendBytes(writer, data.items, data.count);
+
+		objc_autoreleasePoolPop(pool);
+		break;
+	}
+}
+
+@implementation OFMessagePackWriter
+@synthesize stream = _stream;
+
++ (void)initialize
+{
+	SEL selector = @selector(messagePackRepresentation);
+
+	if (self != [OFMessagePackWriter class])
+		return;
+
+	stringIMP = [OFString instanceMethodForSelector: selector];
+	numberIMP = [OFNumber instanceMethodForSelector: selector];
+	nullIMP = [OFNull instanceMethodForSelector: selector];
+	dataIMP = [OFData instanceMethodForSelector: selector];
+	dateIMP = [OFDate instanceMethodForSelector: selector];
+	extensionIMP = [OFMessagePackExtension
+	    instanceMethodForSelector: selector];
+	arrayIMP = [OFArray instanceMethodForSelector: selector];
+	dictionaryIMP = [OFDictionary instanceMethodForSelector: selector];
+}
+
++ (size_t)messagePackLengthOfObject: (id <OFMessagePackRepresentation>)object
+{
+	void *pool = objc_autoreleasePoolPush();
+	size_t length = lengthOfObject(object, nil);
+
+	objc_autoreleasePoolPop(pool);
+
+	return length;
+}
+
++ (OFData *)messagePackRepresentationOfObject:
+    (id <OFMessagePackRepresentation>)object
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableArray *representations = [OFMutableArray array];
+	struct writer writer;
+	OFData *ret;
+
+	writer.length = 0;
+	writer.representations = representations;
+	writer.representationsIndex = 0;
+	writer.size = lengthOfObject(object, representations);
+	writer.stream = nil;
+
+	if ((writer.buffer = malloc(writer.size)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: writer.size];
+
+	@try {
+		writeObject(&writer, object);
+
+		if (writer.length != writer.size)
+			@throw [OFOutOfRangeException exception];
+
+		ret = [[OFData alloc] initWithItemsNoCopy: writer.buffer
+						    count: writer.size
+					     freeWhenDone: true];
+	} @catch (id e) {
+		free(writer.buffer);
+		@throw e;
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+
++ (instancetype)writerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [super init];
+
+	@try {
+		_stream = [stream retain];
+		_buffer = [self allocMemoryWithSize: BUFFER_SIZE];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self flush];
+
+	[_stream release];
+
+	[super dealloc];
+}
+
+- (void)writeObject: (id <OFMessagePackRepresentation>)object
+{
+	void *pool = objc_autoreleasePoolPush();
+	struct writer writer;
+
+	writer.buffer = _buffer;
+	writer.length = _bufferLength;
+	writer.size = BUFFER_SIZE;
+	writer.stream = _stream;
+	writer.representations = nil;
+
+	@try {
+		writeObject(&writer, object);
+	} @finally {
+		_bufferLength = writer.length;
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)flush
+{
+	struct writer writer;
+
+	writer.buffer = _buffer;
+	writer.length = _bufferLength;
+	writer.size = BUFFER_SIZE;
+	writer.stream = _stream;
+	writer.representations = nil;
+
+	@try {
+		flushWriter(&writer);
+	} @finally {
+		_bufferLength = writer.length;
+	}
+}
+@end
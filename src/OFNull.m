@@ -21,6 +21,7 @@
 #import "OFString.h"
 #import "OFXMLElement.h"
 #import "OFData.h"
+#import "OFMessagePackWriter.h"
 
 #import "OFInvalidArgumentException.h"
 
@@ -104,10 +105,7 @@ static OFNull *null = nil;
 
 - (OFData *)messagePackRepresentation
 {
-	uint8_t type = 0xC0;
-
-	return [OFData dataWithItems: &type
-			       count: 1];
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
 }
 
 - (OFData *)ASN1DERRepresentation
@@ -28,6 +28,7 @@
 # include <sys/types.h>
 #endif
 
+#import "OFBinaryPropertyListRepresentation.h"
 #import "OFJSONRepresentation.h"
 #import "OFMessagePackRepresentation.h"
 #import "OFSerialization.h"
@@ -117,7 +118,8 @@ typedef enum {
  * @brief Provides a way to store a number in an object.
  */
 @interface OFNumber: OFValue <OFComparing, OFSerialization,
-    OFJSONRepresentation, OFMessagePackRepresentation>
+    OFJSONRepresentation, OFMessagePackRepresentation,
+    OFBinaryPropertyListRepresentation>
 {
 	union of_number_value {
 		bool		   bool_;
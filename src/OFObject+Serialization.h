@@ -19,6 +19,7 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFData;
 @class OFString;
 
 #ifdef __cplusplus
@@ -34,6 +35,16 @@ extern int _OFObject_Serialization_reference;
  * @brief The object serialized as a string.
  */
 @property (readonly, nonatomic) OFString *stringBySerializing;
+
+/*!
+ * @brief The object serialized in a compact binary format.
+ *
+ * This uses the same @ref OFSerialization conformance as
+ * @ref stringBySerializing, but instead of generating and later parsing XML,
+ * the serialization is stored in a binary format which stores every string
+ * only once. Use @ref OFData::objectByDeserializing to get the object back.
+ */
+@property (readonly, nonatomic) OFData *dataBySerializing;
 @end
 
 OF_ASSUME_NONNULL_END
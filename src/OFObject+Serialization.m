@@ -21,12 +21,125 @@
 
 #import "OFObject.h"
 #import "OFObject+Serialization.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFMapTable.h"
+#import "OFMapTable+Private.h"
 #import "OFSerialization.h"
+#import "OFSerialization+Private.h"
 #import "OFString.h"
+#import "OFXMLAttribute.h"
+#import "OFXMLCDATA.h"
+#import "OFXMLCharacters.h"
 #import "OFXMLElement.h"
 
+#import "OFInvalidArgumentException.h"
+
 int _OFObject_Serialization_reference;
 
+struct serializer {
+	OFMutableData *data;
+	/* Map strings to their index + 1 */
+	OFMapTable *names, *values;
+};
+
+static const of_map_table_functions_t indexFunctions = { NULL };
+
+static void
+writeNumber(OFMutableData *data, uintmax_t number)
+{
+	unsigned char buffer[(sizeof(uintmax_t) * 8 + 6) / 7];
+	size_t length = 0;
+
+	do {
+		buffer[length] = number & 0x7F;
+		number >>= 7;
+
+		if (number > 0)
+			buffer[length] |= 0x80;
+
+		length++;
+	} while (number > 0);
+
+	[data addItems: buffer
+		 count: length];
+}
+
+static void
+writeString(OFMutableData *data, OFMapTable *table, OFString *string)
+{
+	void *idx;
+	size_t length;
+
+	if (string == nil) {
+		writeNumber(data, OF_BINARY_SERIALIZATION_NIL);
+		return;
+	}
+
+	if ((idx = [table objectForKey: string]) != NULL) {
+		writeNumber(data,
+		    (uintptr_t)idx - 1 + OF_BINARY_SERIALIZATION_FIRST_INDEX);
+		return;
+	}
+
+	[table setObject: (void *)(uintptr_t)(table.count + 1)
+		  forKey: string];
+
+	length = string.UTF8StringLength;
+
+	writeNumber(data, OF_BINARY_SERIALIZATION_NEW_STRING);
+	writeNumber(data, length);
+	[data addItems: string.UTF8String
+		 count: length];
+}
+
+static void
+writeNode(struct serializer *serializer, OFXMLNode *node)
+{
+	OFMutableData *data = serializer->data;
+	uint8_t type;
+
+	if ([node isKindOfClass: [OFXMLElement class]]) {
+		void *pool = objc_autoreleasePoolPush();
+		OFXMLElement *element = (OFXMLElement *)node;
+		OFArray OF_GENERIC(OFXMLAttribute *) *attributes =
+		    element.attributes;
+		OFArray OF_GENERIC(OFXMLNode *) *children = element.children;
+
+		type = OF_BINARY_SERIALIZATION_ELEMENT;
+		[data addItem: &type];
+
+		writeString(data, serializer->names, element.name);
+		writeString(data, serializer->names, element.namespace);
+
+		writeNumber(data, attributes.count);
+		for (OFXMLAttribute *attribute in attributes) {
+			writeString(data, serializer->names, attribute.name);
+			writeString(data, serializer->names,
+			    attribute.namespace);
+			writeString(data, serializer->values,
+			    attribute.stringValue);
+		}
+
+		writeNumber(data, children.count);
+		for (OFXMLNode *child in children)
+			writeNode(serializer, child);
+
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	if ([node isKindOfClass: [OFXMLCharacters class]])
+		type = OF_BINARY_SERIALIZATION_CHARACTERS;
+	else if ([node isKindOfClass: [OFXMLCDATA class]])
+		type = OF_BINARY_SERIALIZATION_CDATA;
+	else
+		@throw [OFInvalidArgumentException exception];
+
+	[data addItem: &type];
+	writeString(data, serializer->values, node.stringValue);
+}
+
 @implementation OFObject (Serialization)
 - (OFString *)stringBySerializing
 {
@@ -58,4 +171,41 @@ int _OFObject_Serialization_reference;
 
 	return [ret autorelease];
 }
+
+- (OFData *)dataBySerializing
+{
+	void *pool;
+	struct serializer serializer;
+	uint8_t version = OF_BINARY_SERIALIZATION_VERSION;
+	OFMutableData *ret;
+
+	if (![self conformsToProtocol: @protocol(OFSerialization)]) {
+		[self doesNotRecognizeSelector: _cmd];
+		abort();
+	}
+
+	ret = [OFMutableData data];
+	pool = objc_autoreleasePoolPush();
+
+	serializer.data = ret;
+	serializer.names = [OFMapTable
+	    mapTableWithKeyFunctions: of_map_table_object_functions
+		     objectFunctions: indexFunctions];
+	serializer.values = [OFMapTable
+	    mapTableWithKeyFunctions: of_map_table_object_functions
+		     objectFunctions: indexFunctions];
+
+	[ret addItems: OF_BINARY_SERIALIZATION_MAGIC
+		count: OF_BINARY_SERIALIZATION_MAGIC_LENGTH];
+	[ret addItem: &version];
+
+	writeNode(&serializer,
+	    ((id <OFSerialization>)self).XMLElementBySerializing);
+
+	objc_autoreleasePoolPop(pool);
+
+	[ret makeImmutable];
+
+	return ret;
+}
 @end
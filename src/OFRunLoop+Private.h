@@ -82,6 +82,19 @@ OF_ASSUME_NONNULL_BEGIN
 				       block
 # endif
 			 delegate: (nullable id <OFStreamDelegate>)delegate;
+# ifdef OF_HAVE_FILES
++ (void)of_addAsyncWriteForSocket: (OFStreamSocket *)socket
+			     file: (OFFile *)file
+			   offset: (of_offset_t)offset
+			   length: (size_t)length
+			     mode: (of_run_loop_mode_t)mode
+#  ifdef OF_HAVE_BLOCKS
+			    block: (nullable
+				of_stream_socket_async_write_file_block_t)
+				       block
+#  endif
+			 delegate: (nullable id <OFStreamDelegate>)delegate;
+# endif
 # if !defined(OF_WII) && !defined(OF_NINTENDO_3DS)
 + (void)of_addAsyncConnectForTCPSocket: (OFTCPSocket *)socket
 				  mode: (of_run_loop_mode_t)mode
@@ -24,10 +24,14 @@
 #import "OFRunLoop+Private.h"
 #import "OFData.h"
 #import "OFDictionary.h"
+#ifdef OF_HAVE_FILES
+# import "OFFile.h"
+#endif
 #ifdef OF_HAVE_SOCKETS
 # import "OFKernelEventObserver.h"
 # import "OFTCPSocket.h"
 # import "OFTCPSocket+Private.h"
+# import "OFStreamSocket+Private.h"
 #endif
 #import "OFThread.h"
 #ifdef OF_HAVE_THREADS
@@ -40,10 +44,19 @@
 #import "OFDate.h"
 
 #import "OFObserveFailedException.h"
+#import "OFWriteFailedException.h"
 #ifdef OF_HAVE_SOCKETS
 # import "OFConnectionFailedException.h"
 #endif
 
+#ifdef OF_HAVE_SOCKETS
+/*
+ * The maximum number of queued writes of data that are handed to the stream
+ * at once.
+ */
+# define MAX_COALESCED_WRITES 16
+#endif
+
 of_run_loop_mode_t of_run_loop_mode_default = @"of_run_loop_mode_default";
 static OFRunLoop *mainRunLoop = nil;
 
@@ -64,6 +77,14 @@ static OFRunLoop *mainRunLoop = nil;
 	OFCondition *_condition;
 #endif
 }
+
+#ifdef OF_HAVE_SOCKETS
+- (bool)writeCoalescedDataInQueue: (OFList *)queue
+			 toObject: (id)object;
+- (void)removeItem: (id)item
+    fromWriteQueue: (OFList *)queue
+	 forObject: (id)object;
+#endif
 @end
 
 @interface OFRunLoop ()
@@ -122,6 +143,10 @@ static OFRunLoop *mainRunLoop = nil;
 	OFData *_data;
 	size_t _writtenLength;
 }
+
+- (bool)handleObject: (id)object
+       writtenLength: (size_t)length
+	   exception: (id)exception;
 @end
 
 @interface OFRunLoopWriteStringQueueItem: OFRunLoopQueueItem
@@ -136,6 +161,20 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+# ifdef OF_HAVE_FILES
+@interface OFRunLoopWriteFileQueueItem: OFRunLoopQueueItem
+{
+@public
+#  ifdef OF_HAVE_BLOCKS
+	of_stream_socket_async_write_file_block_t _block;
+#  endif
+	OFFile *_file;
+	of_offset_t _offset;
+	size_t _length, _writtenLength;
+}
+@end
+# endif
+
 # if !defined(OF_WII) && !defined(OF_NINTENDO_3DS)
 @interface OFRunLoopConnectQueueItem: OFRunLoopQueueItem
 @end
@@ -173,6 +212,19 @@ static OFRunLoop *mainRunLoop = nil;
 @end
 #endif
 
+#ifdef OF_HAVE_SOCKETS
+static of_list_object_t *
+findListObject(OFList *queue, id item)
+{
+	for (of_list_object_t *iter = queue.firstListObject;
+	    iter != NULL; iter = iter->next)
+		if (iter->object == item)
+			return iter;
+
+	return NULL;
+}
+#endif
+
 @implementation OFRunLoopState
 - (instancetype)init
 {
@@ -268,6 +320,10 @@ static OFRunLoop *mainRunLoop = nil;
 	assert(queue != nil);
 
 	@try {
+		if ([self writeCoalescedDataInQueue: queue
+					   toObject: object])
+			return;
+
 		if (![queue.firstObject handleObject: object]) {
 			of_list_object_t *listObject = queue.firstListObject;
 
@@ -299,6 +355,145 @@ static OFRunLoop *mainRunLoop = nil;
 		[queue release];
 	}
 }
+
+- (bool)writeCoalescedDataInQueue: (OFList *)queue
+			 toObject: (id)object
+{
+	OFRunLoopWriteDataQueueItem *items[MAX_COALESCED_WRITES];
+	of_stream_buffer_t buffers[MAX_COALESCED_WRITES];
+	OFRunLoopWriteDataQueueItem *failed = nil;
+	size_t count = 0, length, completed;
+	id insertAfter = nil, exception = nil;
+
+	for (of_list_object_t *iter = queue.firstListObject;
+	    iter != NULL && count < MAX_COALESCED_WRITES; iter = iter->next) {
+		OFRunLoopWriteDataQueueItem *item = iter->object;
+		OFData *data;
+
+		if (![item isKindOfClass: [OFRunLoopWriteDataQueueItem class]])
+			break;
+
+		data = item->_data;
+
+		items[count] = item;
+		buffers[count].buffer =
+		    (const char *)data.items + item->_writtenLength;
+		buffers[count].length =
+		    data.count * data.itemSize - item->_writtenLength;
+		count++;
+	}
+
+	/* A single write is handled by the item itself. */
+	if (count < 2)
+		return false;
+
+	@try {
+		length = [object writeBuffers: buffers
+					count: count];
+	} @catch (id e) {
+		/* What was written before still belongs to the items. */
+		length = ([e isKindOfClass: [OFWriteFailedException class]]
+		    ? [e bytesWritten] : 0);
+		exception = e;
+	}
+
+	for (completed = 0; completed < count &&
+	    length >= buffers[completed].length; completed++)
+		length -= buffers[completed].length;
+
+	/*
+	 * If an item was only written partially, its remaining data needs to
+	 * be written next, so that the data of the items is not interleaved.
+	 * Items that were completed before and want to write more data need to
+	 * go after it.
+	 */
+	if (completed < count && length > 0) {
+		if (exception == nil)
+			items[completed]->_writtenLength += length;
+
+		insertAfter = items[completed];
+	}
+
+	/*
+	 * An exception is reported to the first item that was not written
+	 * completely, just as if it had been written on its own.
+	 */
+	if (exception != nil && completed < count)
+		failed = items[completed];
+
+	for (size_t i = 0; i < completed; i++)
+		[items[i] retain];
+	[failed retain];
+
+	@try {
+		for (size_t i = 0; i < completed; i++) {
+			/*
+			 * The handler of a previous item might have called
+			 * -[cancelAsyncRequests], in which case the remaining
+			 * items must not be handled anymore.
+			 */
+			if (findListObject(queue, items[i]) == NULL)
+				break;
+
+			if (![items[i] handleObject: object
+				      writtenLength: buffers[i].length
+					  exception: nil]) {
+				[self removeItem: items[i]
+				  fromWriteQueue: queue
+				       forObject: object];
+				continue;
+			}
+
+			if (insertAfter == nil)
+				continue;
+
+			[queue removeListObject:
+			    findListObject(queue, items[i])];
+			[queue insertObject: items[i]
+			    afterListObject:
+			    findListObject(queue, insertAfter)];
+			insertAfter = items[i];
+		}
+
+		if (failed != nil && findListObject(queue, failed) != NULL &&
+		    ![failed handleObject: object
+			    writtenLength: length
+				exception: exception])
+			[self removeItem: failed
+			  fromWriteQueue: queue
+			       forObject: object];
+	} @finally {
+		for (size_t i = 0; i < completed; i++)
+			[items[i] release];
+		[failed release];
+	}
+
+	return true;
+}
+
+- (void)removeItem: (id)item
+    fromWriteQueue: (OFList *)queue
+	 forObject: (id)object
+{
+	of_list_object_t *listObject = findListObject(queue, item);
+
+	if (listObject == NULL)
+		return;
+
+	/*
+	 * Make sure we keep the target until after we are done removing the
+	 * object. The reason for this is that the target might call
+	 * -[cancelAsyncRequests] in its dealloc.
+	 */
+	[[listObject->object retain] autorelease];
+
+	[queue removeListObject: listObject];
+
+	if (queue.count == 0) {
+		[_kernelEventObserver removeObjectForWriting: object];
+		[_writeQueues removeObjectForKey: object];
+	}
+}
 #endif
 @end
 
@@ -463,19 +658,30 @@ static OFRunLoop *mainRunLoop = nil;
 {
 	size_t length;
 	id exception = nil;
-	size_t dataLength = _data.count * _data.itemSize;
-	OFData *newData, *oldData;
 
 	@try {
 		const char *dataItems = _data.items;
 
 		length = [object writeBuffer: dataItems + _writtenLength
-				      length: dataLength - _writtenLength];
+				      length: _data.count * _data.itemSize -
+					      _writtenLength];
 	} @catch (id e) {
 		length = 0;
 		exception = e;
 	}
 
+	return [self handleObject: object
+		    writtenLength: length
+			exception: exception];
+}
+
+- (bool)handleObject: (id)object
+       writtenLength: (size_t)length
+	   exception: (id)exception
+{
+	size_t dataLength = _data.count * _data.itemSize;
+	OFData *newData, *oldData;
+
 	_writtenLength += length;
 
 	if (_writtenLength != dataLength && exception == nil)
@@ -604,6 +810,64 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+# ifdef OF_HAVE_FILES
+@implementation OFRunLoopWriteFileQueueItem
+- (bool)handleObject: (id)object
+{
+	size_t length;
+	bool endOfFile = false;
+	id exception = nil;
+
+	/*
+	 * Only write as much as can be written at once, so that other sockets
+	 * get their turn in between.
+	 */
+	@try {
+		length = [object of_writeFromFile: _file
+					   offset: _offset + _writtenLength
+					   length: _length - _writtenLength
+					     once: true
+					endOfFile: &endOfFile];
+	} @catch (id e) {
+		length = 0;
+		exception = e;
+	}
+
+	_writtenLength += length;
+
+	if (_writtenLength != _length && !endOfFile && exception == nil)
+		return true;
+
+#  ifdef OF_HAVE_BLOCKS
+	if (_block != NULL)
+		_block(object, _file, _writtenLength, exception);
+	else {
+#  endif
+		if ([_delegate respondsToSelector:
+		    @selector(stream:didWriteFromFile:bytesWritten:exception:)])
+			[_delegate stream: object
+			 didWriteFromFile: _file
+			     bytesWritten: _writtenLength
+				exception: exception];
+#  ifdef OF_HAVE_BLOCKS
+	}
+#  endif
+
+	return false;
+}
+
+- (void)dealloc
+{
+	[_file release];
+#  ifdef OF_HAVE_BLOCKS
+	[_block release];
+#  endif
+
+	[super dealloc];
+}
+@end
+# endif
+
 # if !defined(OF_WII) && !defined(OF_NINTENDO_3DS)
 @implementation OFRunLoopConnectQueueItem
 - (bool)handleObject: (id)object
@@ -947,6 +1211,32 @@ static OFRunLoop *mainRunLoop = nil;
 	QUEUE_ITEM
 }
 
+# ifdef OF_HAVE_FILES
++ (void)of_addAsyncWriteForSocket: (OFStreamSocket *)socket
+			     file: (OFFile *)file
+			   offset: (of_offset_t)offset
+			   length: (size_t)length
+			     mode: (of_run_loop_mode_t)mode
+#  ifdef OF_HAVE_BLOCKS
+			    block: (of_stream_socket_async_write_file_block_t)
+				       block
+#  endif
+			 delegate: (id <OFStreamDelegate>)delegate
+{
+	NEW_WRITE(OFRunLoopWriteFileQueueItem, socket, mode)
+
+	queueItem->_delegate = [delegate retain];
+#  ifdef OF_HAVE_BLOCKS
+	queueItem->_block = [block copy];
+#  endif
+	queueItem->_file = [file retain];
+	queueItem->_offset = offset;
+	queueItem->_length = length;
+
+	QUEUE_ITEM
+}
+# endif
+
 # if !defined(OF_WII) && !defined(OF_NINTENDO_3DS)
 + (void)of_addAsyncConnectForTCPSocket: (OFTCPSocket *)stream
 				  mode: (of_run_loop_mode_t)mode
@@ -55,9 +55,10 @@
 	offset = [self lowlevelSeekToOffset: offset
 				     whence: whence];
 
-	[self freeMemory: _readBufferMemory];
-	_readBuffer = _readBufferMemory = NULL;
+	/* Discard the buffered data, but keep the memory for reuse. */
+	_readBuffer = _readBufferMemory;
 	_readBufferLength = 0;
+	_readBufferScanned = 0;
 
 	return offset;
 }
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFSerialization.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/*
+ * The binary serialization format, as used by -[OFObject dataBySerializing]
+ * and -[OFData objectByDeserializing], is the magic, followed by the version
+ * and the root element of the XML serialization.
+ *
+ * Every node starts with its type. Elements continue with their name and
+ * namespace, the number of attributes followed by name, namespace and value of
+ * each attribute and finally the number of children followed by the children.
+ * Characters and CDATA only consist of their string value. Serializations
+ * never contain other nodes.
+ *
+ * Numbers are stored as unsigned LEB128. Strings are stored as a number that
+ * is 0 for nil, 1 for a new string, which is followed by its length and its
+ * UTF-8 representation, or the index of a previous string + 2. Names and
+ * namespaces of elements and attributes, which includes all class names, use
+ * a different table than values, so that both stay small.
+ */
+#define OF_BINARY_SERIALIZATION_MAGIC "\x89OFS"
+#define OF_BINARY_SERIALIZATION_MAGIC_LENGTH 4
+#define OF_BINARY_SERIALIZATION_VERSION 1
+
+enum {
+	OF_BINARY_SERIALIZATION_ELEMENT = 1,
+	OF_BINARY_SERIALIZATION_CHARACTERS,
+	OF_BINARY_SERIALIZATION_CDATA
+};
+
+enum {
+	OF_BINARY_SERIALIZATION_NIL = 0,
+	OF_BINARY_SERIALIZATION_NEW_STRING,
+	OF_BINARY_SERIALIZATION_FIRST_INDEX
+};
+
+OF_ASSUME_NONNULL_END
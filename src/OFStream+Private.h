@@ -15,13 +15,44 @@
  * file.
  */
 
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
+
 #import "OFStream.h"
 
+#ifdef HAVE_SYS_UIO_H
+/* POSIX requires IOV_MAX to be at least 16. */
+# define OF_MAX_IO_VECTORS 16
+#endif
+
 OF_ASSUME_NONNULL_BEGIN
 
 @interface OFStream ()
 @property (readonly, nonatomic, getter=of_isWaitingForDelimiter)
     bool of_waitingForDelimiter;
+
+/*
+ * Returns whether the receiver overrides -[lowlevelWriteBuffer:length:] of
+ * the specified class, e.g. to encrypt the data. If so, data must not be
+ * written to the underlying handle directly, but needs to be passed to it.
+ */
+- (bool)of_overridesLowlevelWriteBufferOfClass: (Class)class_;
 @end
 
+#ifdef HAVE_SYS_UIO_H
+# ifdef __cplusplus
+extern "C" {
+# endif
+/*
+ * Fills iov with the first of the buffers, but at most OF_MAX_IO_VECTORS, and
+ * returns how many it filled. The sum of their lengths is returned in length.
+ */
+extern size_t of_stream_fill_io_vectors(struct iovec *iov,
+    const of_stream_buffer_t *buffers, size_t count, size_t *length);
+# ifdef __cplusplus
+}
+# endif
+#endif
+
 OF_ASSUME_NONNULL_END
@@ -36,7 +36,23 @@ OF_ASSUME_NONNULL_BEGIN
 /*! @file */
 
 @class OFStream;
+@class OFArray OF_GENERIC(ObjectType);
 @class OFData;
+#ifdef OF_HAVE_FILES
+@class OFFile;
+#endif
+
+/*!
+ * @struct of_stream_buffer_t OFStream.h ObjFW/OFStream.h
+ *
+ * @brief A buffer to write as part of a gather write.
+ */
+typedef struct {
+	/*! The data to write */
+	const void *_Nullable buffer;
+	/*! The length of the data to write */
+	size_t length;
+} of_stream_buffer_t;
 
 #if defined(OF_HAVE_SOCKETS) && defined(OF_HAVE_BLOCKS)
 /*!
@@ -172,6 +188,25 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 		     encoding: (of_string_encoding_t)encoding
 		 bytesWritten: (size_t)bytesWritten
 		    exception: (nullable id)exception;
+
+#ifdef OF_HAVE_FILES
+/*!
+ * @brief This method is called when the contents of a file were written
+ *	  asynchronously to a stream socket.
+ *
+ * @param stream The stream socket to which the contents of the file were
+ *		 written
+ * @param file The file whose contents were written
+ * @param bytesWritten The number of bytes which have been written. This
+ *		       matches the requested length if no exception was
+ *		       encountered and the file was not shorter.
+ * @param exception An exception that occurred while writing, or nil on success
+ */
+-     (void)stream: (OFStream *)stream
+  didWriteFromFile: (OFFile *)file
+      bytesWritten: (size_t)bytesWritten
+	 exception: (nullable id)exception;
+#endif
 @end
 
 /*!
@@ -201,7 +236,8 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 #endif
 	char *_Nullable _readBuffer, *_Nullable _readBufferMemory;
 	char *_Nullable _writeBuffer;
-	size_t _readBufferLength, _writeBufferLength;
+	size_t _readBufferLength, _readBufferCapacity, _readBufferScanned;
+	size_t _writeBufferLength, _writeBufferSize;
 	bool _writeBuffered, _waitingForDelimiter;
 @protected
 	bool _blocking;
@@ -218,6 +254,22 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
  */
 @property (nonatomic, nonatomic, getter=isWriteBuffered) bool writeBuffered;
 
+/*!
+ * @brief The size of the buffer used if writes are buffered, which is the
+ *	  high-water mark at which the buffered data is written to the stream.
+ *
+ * Writes that do not fit into the buffer anymore cause the buffered data to
+ * be written first. Writes that do not fit into an empty buffer are written
+ * to the stream directly.
+ *
+ * Defaults to 64 KiB.
+ *
+ * @throw OFInvalidArgumentException The specified size is 0
+ * @throw OFOutOfRangeException The stream is in non-blocking mode and more
+ *				than the specified size is still buffered
+ */
+@property (nonatomic) size_t writeBufferSize;
+
 /*!
  * @brief Whether data is present in the internal read buffer.
  */
@@ -987,6 +1039,20 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 - (size_t)writeBuffer: (const void *)buffer
 	       length: (size_t)length;
 
+/*!
+ * @brief Writes from several buffers into the stream, as if they were one.
+ *
+ * This allows writing e.g. a header and a payload with a single system call
+ * instead of copying them into one buffer first.
+ *
+ * @param buffers The buffers from which the data is written into the stream
+ * @param count The number of buffers
+ * @return The number of bytes written. This can only differ from the sum of
+ *	   the lengths of the buffers in non-blocking mode.
+ */
+- (size_t)writeBuffers: (const of_stream_buffer_t *)buffers
+		 count: (size_t)count;
+
 #ifdef OF_HAVE_SOCKETS
 /*!
  * @brief Asynchronously writes data into the stream.
@@ -1010,6 +1076,40 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 - (void)asyncWriteData: (OFData *)data
 	   runLoopMode: (of_run_loop_mode_t)runLoopMode;
 
+/*!
+ * @brief Asynchronously writes several data into the stream.
+ *
+ * This is the same as calling @ref asyncWriteData: for each data in the array,
+ * which means the delegate is informed about each data separately. Like all
+ * data that is queued for writing one after another, the data is written
+ * using a gather write once the stream is ready for writing, so that up to
+ * 16 of them only need a single system call.
+ *
+ * @note The stream must conform to @ref OFReadyForWritingObserving in order
+ *	 for this to work!
+ *
+ * @param dataArray An array of data which is written into the stream
+ */
+- (void)asyncWriteDataArray: (OFArray OF_GENERIC(OFData *) *)dataArray;
+
+/*!
+ * @brief Asynchronously writes several data into the stream.
+ *
+ * This is the same as calling @ref asyncWriteData:runLoopMode: for each data
+ * in the array, which means the delegate is informed about each data
+ * separately. Like all data that is queued for writing one after another, the
+ * data is written using a gather write once the stream is ready for writing,
+ * so that up to 16 of them only need a single system call.
+ *
+ * @note The stream must conform to @ref OFReadyForWritingObserving in order
+ *	 for this to work!
+ *
+ * @param dataArray An array of data which is written into the stream
+ * @param runLoopMode The run loop mode in which to perform the async write
+ */
+- (void)asyncWriteDataArray: (OFArray OF_GENERIC(OFData *) *)dataArray
+		runLoopMode: (of_run_loop_mode_t)runLoopMode;
+
 /*!
  * @brief Asynchronously writes a string in UTF-8 encoding into the stream.
  *
@@ -1472,6 +1572,22 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 - (size_t)lowlevelWriteBuffer: (const void *)buffer
 		       length: (size_t)length;
 
+/*!
+ * @brief Performs a lowlevel write of several buffers.
+ *
+ * @warning Do not call this directly!
+ *
+ * @note Override this method when subclassing if the data of several buffers
+ *	 can be written at once, e.g. using `writev()`. The default
+ *	 implementation calls @ref lowlevelWriteBuffer:length: for each buffer.
+ *
+ * @param buffers The buffers with the data to write
+ * @param count The number of buffers
+ * @return The number of bytes written
+ */
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count;
+
 /*!
  * @brief Returns whether the lowlevel is at the end of the stream.
  *
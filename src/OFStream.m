@@ -42,6 +42,7 @@
 
 #import "OFStream.h"
 #import "OFStream+Private.h"
+#import "OFArray.h"
 #import "OFData.h"
 #import "OFKernelEventObserver.h"
 #import "OFRunLoop+Private.h"
@@ -61,6 +62,130 @@
 #import "of_asprintf.h"
 
 #define MIN_READ_SIZE 512
+#define DEFAULT_WRITE_BUFFER_SIZE 65536
+/*
+ * The read buffer is kept for reuse once it has been drained, unless a huge
+ * line or unread made it grow beyond this.
+ */
+#define MAX_KEPT_READ_BUFFER_SIZE 65536
+/*
+ * Shorter delimiters are searched for using memchr() on their first byte,
+ * longer delimiters using a skip table.
+ */
+#define MIN_SKIP_TABLE_DELIMITER_LENGTH 4
+
+@interface OFStream ()
+- (char *)of_readBufferSpaceForLength: (size_t)length;
+- (void)of_consumeReadBufferLength: (size_t)length;
+- (nullable OFString *)
+    of_stringFromReadBufferTillDelimiter: (const char *)delimiter
+				  length: (size_t)delimiterLength
+			       skipTable: (nullable const uint8_t *)skipTable
+				encoding: (of_string_encoding_t)encoding
+		    stripsCarriageReturn: (bool)stripsCarriageReturn;
+- (nullable OFString *)
+    of_tryReadTillDelimiter: (const char *)delimiter
+		     length: (size_t)delimiterLength
+		   encoding: (of_string_encoding_t)encoding
+       stripsCarriageReturn: (bool)stripsCarriageReturn;
+@end
+
+/*
+ * Creates the table for a Boyer-Moore-Horspool search, which contains how far
+ * the search can advance if a byte is the last one compared to the delimiter.
+ * Skips are capped at UINT8_MAX, which only makes the search for very long
+ * delimiters advance less than possible.
+ */
+static void
+makeSkipTable(const char *delimiter, size_t delimiterLength,
+    uint8_t skipTable[256])
+{
+	uint8_t maxSkip = (delimiterLength < UINT8_MAX
+	    ? (uint8_t)delimiterLength : UINT8_MAX);
+
+	memset(skipTable, maxSkip, 256);
+
+	for (size_t i = 0; i < delimiterLength - 1; i++)
+		if (delimiterLength - 1 - i < maxSkip)
+			skipTable[(unsigned char)delimiter[i]] =
+			    (uint8_t)(delimiterLength - 1 - i);
+}
+
+/*
+ * Returns the index of the first byte of the first occurrence of the
+ * delimiter or of the first \0, whichever ends first, and stores the number of
+ * bytes that need to be skipped after it. Returns the length if neither has
+ * been found.
+ */
+static size_t
+findDelimiter(const char *buffer, size_t length, const char *delimiter,
+    size_t delimiterLength, const uint8_t *skipTable, size_t *skip)
+{
+	const char *nul = memchr(buffer, '\0', length);
+	size_t searchLength = (nul != NULL ? (size_t)(nul - buffer) : length);
+
+	if (skipTable != NULL) {
+		const unsigned char *bytes = (const unsigned char *)buffer;
+		unsigned char last =
+		    (unsigned char)delimiter[delimiterLength - 1];
+
+		for (size_t i = 0; i + delimiterLength <= searchLength;
+		    i += skipTable[bytes[i + delimiterLength - 1]]) {
+			if (bytes[i + delimiterLength - 1] == last &&
+			    memcmp(buffer + i, delimiter,
+			    delimiterLength - 1) == 0) {
+				*skip = delimiterLength;
+				return i;
+			}
+		}
+	} else {
+		for (size_t i = 0; i + delimiterLength <= searchLength; i++) {
+			const char *pos = memchr(buffer + i, delimiter[0],
+			    searchLength - delimiterLength - i + 1);
+
+			if (pos == NULL)
+				break;
+
+			i = pos - buffer;
+
+			if (memcmp(pos + 1, delimiter + 1,
+			    delimiterLength - 1) == 0) {
+				*skip = delimiterLength;
+				return i;
+			}
+		}
+	}
+
+	if (nul != NULL) {
+		*skip = 1;
+		return searchLength;
+	}
+
+	return length;
+}
+
+#ifdef HAVE_SYS_UIO_H
+size_t
+of_stream_fill_io_vectors(struct iovec *iov,
+    const of_stream_buffer_t *buffers, size_t count, size_t *length)
+{
+	size_t iovCount = (count < OF_MAX_IO_VECTORS
+	    ? count : OF_MAX_IO_VECTORS);
+
+	*length = 0;
+
+	for (size_t i = 0; i < iovCount; i++) {
+		if (buffers[i].length > SSIZE_MAX - *length)
+			@throw [OFOutOfRangeException exception];
+
+		iov[i].iov_base = (void *)buffers[i].buffer;
+		iov[i].iov_len = buffers[i].length;
+		*length += buffers[i].length;
+	}
+
+	return iovCount;
+}
+#endif
 
 @implementation OFStream
 @synthesize of_waitingForDelimiter = _waitingForDelimiter, delegate = _delegate;
@@ -88,6 +213,7 @@
 	self = [super init];
 
 	_blocking = true;
+	_writeBufferSize = DEFAULT_WRITE_BUFFER_SIZE;
 
 	return self;
 }
@@ -109,6 +235,33 @@
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
+{
+	size_t ret = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t bytesWritten = [self
+		    lowlevelWriteBuffer: buffers[i].buffer
+				 length: buffers[i].length];
+
+		ret += bytesWritten;
+
+		if (bytesWritten < buffers[i].length)
+			break;
+	}
+
+	return ret;
+}
+
+- (bool)of_overridesLowlevelWriteBufferOfClass: (Class)class_
+{
+	return ([self methodForSelector:
+	    @selector(lowlevelWriteBuffer:length:)] !=
+	    [class_ instanceMethodForSelector:
+	    @selector(lowlevelWriteBuffer:length:)]);
+}
+
 - (id)copy
 {
 	return [self retain];
@@ -122,6 +275,56 @@
 	return [self lowlevelIsAtEndOfStream];
 }
 
+- (char *)of_readBufferSpaceForLength: (size_t)length
+{
+	size_t offset = _readBuffer - _readBufferMemory, capacity;
+
+	if (_readBufferCapacity - offset - _readBufferLength >= length)
+		return _readBuffer + _readBufferLength;
+
+	/* Move the data that has not been read yet to the front first. */
+	if (offset > 0) {
+		memmove(_readBufferMemory, _readBuffer, _readBufferLength);
+		_readBuffer = _readBufferMemory;
+
+		if (_readBufferCapacity - _readBufferLength >= length)
+			return _readBuffer + _readBufferLength;
+	}
+
+	if (SIZE_MAX - _readBufferLength < length)
+		@throw [OFOutOfRangeException exception];
+
+	capacity = _readBufferLength + length;
+	if (capacity < _readBufferCapacity * 2 &&
+	    _readBufferCapacity <= SIZE_MAX / 2)
+		capacity = _readBufferCapacity * 2;
+
+	_readBufferMemory = [self resizeMemory: _readBufferMemory
+					  size: capacity];
+	_readBuffer = _readBufferMemory;
+	_readBufferCapacity = capacity;
+
+	return _readBuffer + _readBufferLength;
+}
+
+- (void)of_consumeReadBufferLength: (size_t)length
+{
+	_readBuffer += length;
+	_readBufferLength -= length;
+	_readBufferScanned = (_readBufferScanned > length
+	    ? _readBufferScanned - length : 0);
+
+	if (_readBufferLength == 0) {
+		if (_readBufferCapacity > MAX_KEPT_READ_BUFFER_SIZE) {
+			[self freeMemory: _readBufferMemory];
+			_readBufferMemory = NULL;
+			_readBufferCapacity = 0;
+		}
+
+		_readBuffer = _readBufferMemory;
+	}
+}
+
 - (size_t)readIntoBuffer: (void *)buffer
 		  length: (size_t)length
 {
@@ -132,52 +335,24 @@
 		 * to do a syscall for every read.
 		 */
 		if (length < MIN_READ_SIZE) {
-			char tmp[MIN_READ_SIZE], *readBuffer;
-			size_t bytesRead;
+			char *readBuffer =
+			    [self of_readBufferSpaceForLength: MIN_READ_SIZE];
 
-			bytesRead = [self
-			    lowlevelReadIntoBuffer: tmp
+			_readBufferLength = [self
+			    lowlevelReadIntoBuffer: readBuffer
 					    length: MIN_READ_SIZE];
-
-			if (bytesRead > length) {
-				memcpy(buffer, tmp, length);
-
-				readBuffer = [self allocMemoryWithSize:
-				    bytesRead - length];
-				memcpy(readBuffer, tmp + length,
-				    bytesRead - length);
-
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bytesRead - length;
-
-				return length;
-			} else {
-				memcpy(buffer, tmp, bytesRead);
-				return bytesRead;
-			}
-		}
-
-		return [self lowlevelReadIntoBuffer: buffer
-					     length: length];
+		} else
+			return [self lowlevelReadIntoBuffer: buffer
+						     length: length];
 	}
 
-	if (length >= _readBufferLength) {
-		size_t ret = _readBufferLength;
-		memcpy(buffer, _readBuffer, _readBufferLength);
-
-		[self freeMemory: _readBufferMemory];
-		_readBuffer = _readBufferMemory = NULL;
-		_readBufferLength = 0;
-
-		return ret;
-	} else {
-		memcpy(buffer, _readBuffer, length);
+	if (length > _readBufferLength)
+		length = _readBufferLength;
 
-		_readBuffer += length;
-		_readBufferLength -= length;
+	memcpy(buffer, _readBuffer, length);
+	[self of_consumeReadBufferLength: length];
 
-		return length;
-	}
+	return length;
 }
 
 - (void)readIntoBuffer: (void *)buffer
@@ -705,158 +880,122 @@
 	return ret;
 }
 
-- (OFString *)tryReadLineWithEncoding: (of_string_encoding_t)encoding
+- (OFString *)
+    of_stringFromReadBufferTillDelimiter: (const char *)delimiter
+				  length: (size_t)delimiterLength
+			       skipTable: (const uint8_t *)skipTable
+				encoding: (of_string_encoding_t)encoding
+		    stripsCarriageReturn: (bool)stripsCarriageReturn
 {
-	size_t pageSize, bufferLength, retLength;
-	char *retCString, *buffer, *readBuffer;
+	size_t idx, skip, length;
 	OFString *ret;
 
-	/* Look if there's a line or \0 in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if OF_UNLIKELY (_readBuffer[i] == '\n' ||
-			    _readBuffer[i] == '\0') {
-				retLength = i;
-
-				if (i > 0 && _readBuffer[i - 1] == '\r')
-					retLength--;
+	/* Only search the bytes that have not been searched before. */
+	if (_readBufferScanned >= _readBufferLength)
+		return nil;
 
-				ret = [OFString stringWithCString: _readBuffer
-							 encoding: encoding
-							   length: retLength];
+	idx = _readBufferScanned + findDelimiter(
+	    _readBuffer + _readBufferScanned,
+	    _readBufferLength - _readBufferScanned,
+	    delimiter, delimiterLength, skipTable, &skip);
 
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
+	if (idx == _readBufferLength) {
+		/* The end might be the start of a delimiter. */
+		if (_readBufferLength >= delimiterLength)
+			_readBufferScanned =
+			    _readBufferLength - delimiterLength + 1;
 
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+		return nil;
 	}
 
-	/* Read and see if we got a newline or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = [self allocMemoryWithSize: pageSize];
+	length = idx;
+	if (stripsCarriageReturn && length > 0 &&
+	    _readBuffer[length - 1] == '\r')
+		length--;
 
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
+	ret = [OFString stringWithCString: _readBuffer
+				 encoding: encoding
+				   length: length];
 
-			retLength = _readBufferLength;
+	[self of_consumeReadBufferLength: idx + skip];
 
-			if (retLength > 0 && _readBuffer[retLength - 1] == '\r')
-				retLength--;
+	return ret;
+}
 
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: retLength];
+- (OFString *)of_tryReadTillDelimiter: (const char *)delimiter
+			       length: (size_t)delimiterLength
+			     encoding: (of_string_encoding_t)encoding
+		 stripsCarriageReturn: (bool)stripsCarriageReturn
+{
+	uint8_t skipTableBuffer[256], *skipTable = NULL;
+	size_t pageSize;
+	char *buffer;
+	OFString *ret;
 
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
+	if (delimiterLength >= MIN_SKIP_TABLE_DELIMITER_LENGTH) {
+		makeSkipTable(delimiter, delimiterLength, skipTableBuffer);
+		skipTable = skipTableBuffer;
+	}
 
-			_waitingForDelimiter = false;
-			return ret;
-		}
+	/* Look if there's a delimiter or \0 in our buffer */
+	ret = [self of_stringFromReadBufferTillDelimiter: delimiter
+						  length: delimiterLength
+					       skipTable: skipTable
+						encoding: encoding
+				    stripsCarriageReturn: stripsCarriageReturn];
+	if (ret != nil) {
+		_waitingForDelimiter = false;
+		return ret;
+	}
 
-		bufferLength = [self lowlevelReadIntoBuffer: buffer
-						     length: pageSize];
-
-		/* Look if there's a newline or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if OF_UNLIKELY (buffer[i] == '\n' ||
-			    buffer[i] == '\0') {
-				retLength = _readBufferLength + i;
-				retCString = [self
-				    allocMemoryWithSize: retLength];
-
-				if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				memcpy(retCString + _readBufferLength,
-				    buffer, i);
-
-				if (retLength > 0 &&
-				    retCString[retLength - 1] == '\r')
-					retLength--;
-
-				@try {
-					char *rcs = retCString;
-					size_t rl = retLength;
-
-					ret = [OFString
-					    stringWithCString: rcs
-						     encoding: encoding
-						       length: rl];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = [self
-						    allocMemoryWithSize:
-						    _readBufferLength +
-						    bufferLength];
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						[self freeMemory:
-						    _readBufferMemory];
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					[self freeMemory: retCString];
-				}
-
-				readBuffer = [self
-				    allocMemoryWithSize: bufferLength - i - 1];
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				[self freeMemory: _readBufferMemory];
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	if ([self lowlevelIsAtEndOfStream]) {
+		size_t length = _readBufferLength;
 
-		/* There was no newline or \0 */
-		if (bufferLength > 0) {
-			readBuffer = [self allocMemoryWithSize:
-			    _readBufferLength + bufferLength];
+		_waitingForDelimiter = false;
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+		if (length == 0)
+			return nil;
 
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		[self freeMemory: buffer];
+		if (stripsCarriageReturn && _readBuffer[length - 1] == '\r')
+			length--;
+
+		ret = [OFString stringWithCString: _readBuffer
+					 encoding: encoding
+					   length: length];
+
+		[self of_consumeReadBufferLength: _readBufferLength];
+
+		return ret;
+	}
+
+	/* Read directly into our buffer and only search what was read */
+	pageSize = [OFSystemInfo pageSize];
+	buffer = [self of_readBufferSpaceForLength: pageSize];
+	_readBufferLength += [self lowlevelReadIntoBuffer: buffer
+						   length: pageSize];
+
+	ret = [self of_stringFromReadBufferTillDelimiter: delimiter
+						  length: delimiterLength
+					       skipTable: skipTable
+						encoding: encoding
+				    stripsCarriageReturn: stripsCarriageReturn];
+	if (ret != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
 	_waitingForDelimiter = true;
 	return nil;
 }
 
+- (OFString *)tryReadLineWithEncoding: (of_string_encoding_t)encoding
+{
+	return [self of_tryReadTillDelimiter: "\n"
+				      length: 1
+				    encoding: encoding
+			stripsCarriageReturn: true];
+}
+
 - (OFString *)readLine
 {
 	return [self readLineWithEncoding: OF_STRING_ENCODING_UTF_8];
@@ -941,168 +1080,19 @@
 - (OFString *)tryReadTillDelimiter: (OFString *)delimiter
 			  encoding: (of_string_encoding_t)encoding
 {
-	const char *delimiterCString;
-	size_t j, delimiterLength, pageSize, bufferLength, retLength;
-	char *retCString, *buffer, *readBuffer;
-	OFString *ret;
-
-	delimiterCString = [delimiter cStringWithEncoding: encoding];
-	delimiterLength = [delimiter cStringLengthWithEncoding: encoding];
-	j = 0;
+	size_t delimiterLength =
+	    [delimiter cStringLengthWithEncoding: encoding];
 
 	if (delimiterLength == 0)
 		@throw [OFInvalidArgumentException exception];
 
-	/* Look if there's something in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if (_readBuffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || _readBuffer[i] == '\0') {
-				if (_readBuffer[i] == '\0')
-					delimiterLength = 1;
-
-				ret = [OFString
-				    stringWithCString: _readBuffer
-					     encoding: encoding
-					      length: i + 1 - delimiterLength];
-
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
-	}
-
-	/* Read and see if we got a delimiter or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = [self allocMemoryWithSize: pageSize];
-
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
-
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: _readBufferLength];
-
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
-
-			_waitingForDelimiter = false;
-			return ret;
-		}
-
-		bufferLength = [self lowlevelReadIntoBuffer: buffer
-						     length: pageSize];
-
-		/* Look if there's a delimiter or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if (buffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || buffer[i] == '\0') {
-				if (buffer[i] == '\0')
-					delimiterLength = 1;
-
-				retLength = _readBufferLength + i + 1 -
-				    delimiterLength;
-				retCString = [self
-				    allocMemoryWithSize: retLength];
-
-				if (_readBuffer != NULL &&
-				    _readBufferLength <= retLength)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				else if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    retLength);
-				if (i >= delimiterLength)
-					memcpy(retCString + _readBufferLength,
-					    buffer, i + 1 - delimiterLength);
-
-				@try {
-					char *rcs = retCString;
-					size_t rl = retLength;
-
-					ret = [OFString
-					    stringWithCString: rcs
-						     encoding: encoding
-						       length: rl];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = [self
-						    allocMemoryWithSize:
-						    _readBufferLength +
-						    bufferLength];
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						[self freeMemory:
-						    _readBufferMemory];
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					[self freeMemory: retCString];
-				}
-
-				readBuffer = [self allocMemoryWithSize:
-				    bufferLength - i - 1];
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				[self freeMemory: _readBufferMemory];
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
-
-		/* Neither the delimiter nor \0 was found */
-		if (bufferLength > 0) {
-			readBuffer = [self allocMemoryWithSize:
-			    _readBufferLength + bufferLength];
-
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
-
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		[self freeMemory: buffer];
-	}
-
-	_waitingForDelimiter = true;
-	return nil;
+	return [self
+	    of_tryReadTillDelimiter: [delimiter cStringWithEncoding: encoding]
+			     length: delimiterLength
+			   encoding: encoding
+	       stripsCarriageReturn: false];
 }
 
-
 - (OFString *)readTillDelimiter: (OFString *)delimiter
 {
 	return [self readTillDelimiter: delimiter
@@ -1138,42 +1128,155 @@
 	_writeBuffered = enable;
 }
 
+- (size_t)writeBufferSize
+{
+	return _writeBufferSize;
+}
+
+- (void)setWriteBufferSize: (size_t)size
+{
+	if (size == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	if (_writeBufferLength > size) {
+		[self flushWriteBuffer];
+
+		/* Only possible in non-blocking mode */
+		if (_writeBufferLength > size)
+			@throw [OFOutOfRangeException exception];
+	}
+
+	if (_writeBuffer != NULL)
+		_writeBuffer = [self resizeMemory: _writeBuffer
+					     size: size];
+
+	_writeBufferSize = size;
+}
+
 - (void)flushWriteBuffer
 {
-	if (_writeBuffer == NULL)
+	size_t length = _writeBufferLength, bytesWritten;
+
+	if (length == 0)
 		return;
 
-	[self lowlevelWriteBuffer: _writeBuffer
-			   length: _writeBufferLength];
+	bytesWritten = [self lowlevelWriteBuffer: _writeBuffer
+					  length: length];
 
-	[self freeMemory: _writeBuffer];
-	_writeBuffer = NULL;
-	_writeBufferLength = 0;
+	/* Keep what could not be written, which the next flush writes. */
+	memmove(_writeBuffer, _writeBuffer + bytesWritten,
+	    length - bytesWritten);
+	_writeBufferLength -= bytesWritten;
+
+	if (_blocking && bytesWritten < length)
+		@throw [OFWriteFailedException
+		    exceptionWithObject: self
+			requestedLength: length
+			   bytesWritten: bytesWritten
+				  errNo: 0];
 }
 
 - (size_t)writeBuffer: (const void *)buffer
 	       length: (size_t)length
 {
-	if (!_writeBuffered) {
-		size_t bytesWritten = [self lowlevelWriteBuffer: buffer
-							 length: length];
+	size_t bytesWritten;
 
-		if (_blocking && bytesWritten < length)
-			@throw [OFWriteFailedException
-			    exceptionWithObject: self
-				requestedLength: length
-				   bytesWritten: bytesWritten
-					  errNo: 0];
+	if (_writeBuffered) {
+		if (length > _writeBufferSize - _writeBufferLength)
+			[self flushWriteBuffer];
 
-		return bytesWritten;
-	} else {
-		_writeBuffer = [self resizeMemory: _writeBuffer
-					     size: _writeBufferLength + length];
-		memcpy(_writeBuffer + _writeBufferLength, buffer, length);
-		_writeBufferLength += length;
+		if (_writeBufferLength > 0 || length < _writeBufferSize) {
+			/*
+			 * In non-blocking mode, flushing might not have made
+			 * enough room.
+			 */
+			if (length > _writeBufferSize - _writeBufferLength)
+				length = _writeBufferSize - _writeBufferLength;
+
+			if (_writeBuffer == NULL)
+				_writeBuffer = [self
+				    allocMemoryWithSize: _writeBufferSize];
+
+			memcpy(_writeBuffer + _writeBufferLength,
+			    buffer, length);
+			_writeBufferLength += length;
+
+			return length;
+		}
+
+		/* Nothing is gained by copying what fills the buffer. */
+	}
+
+	bytesWritten = [self lowlevelWriteBuffer: buffer
+					  length: length];
+
+	if (_blocking && bytesWritten < length)
+		@throw [OFWriteFailedException
+		    exceptionWithObject: self
+			requestedLength: length
+			   bytesWritten: bytesWritten
+				  errNo: 0];
+
+	return bytesWritten;
+}
+
+- (size_t)writeBuffers: (const of_stream_buffer_t *)buffers
+		 count: (size_t)count
+{
+	size_t length = 0, bytesWritten;
+
+	for (size_t i = 0; i < count; i++) {
+		if (buffers[i].length > SIZE_MAX - length)
+			@throw [OFOutOfRangeException exception];
 
-		return length;
+		length += buffers[i].length;
 	}
+
+	if (_writeBuffered) {
+		if (length > _writeBufferSize - _writeBufferLength)
+			[self flushWriteBuffer];
+
+		if (_writeBufferLength > 0 || length < _writeBufferSize) {
+			size_t ret = 0;
+
+			if (_writeBuffer == NULL)
+				_writeBuffer = [self
+				    allocMemoryWithSize: _writeBufferSize];
+
+			/*
+			 * In non-blocking mode, flushing might not have made
+			 * enough room.
+			 */
+			for (size_t i = 0; i < count &&
+			    _writeBufferLength < _writeBufferSize; i++) {
+				size_t bufferLength = buffers[i].length;
+
+				if (bufferLength >
+				    _writeBufferSize - _writeBufferLength)
+					bufferLength = _writeBufferSize -
+					    _writeBufferLength;
+
+				memcpy(_writeBuffer + _writeBufferLength,
+				    buffers[i].buffer, bufferLength);
+				_writeBufferLength += bufferLength;
+				ret += bufferLength;
+			}
+
+			return ret;
+		}
+	}
+
+	bytesWritten = [self lowlevelWriteBuffers: buffers
+					    count: count];
+
+	if (_blocking && bytesWritten < length)
+		@throw [OFWriteFailedException
+		    exceptionWithObject: self
+			requestedLength: length
+			   bytesWritten: bytesWritten
+				  errNo: 0];
+
+	return bytesWritten;
 }
 
 #ifdef OF_HAVE_SOCKETS
@@ -1198,6 +1301,28 @@
 				    delegate: _delegate];
 }
 
+- (void)asyncWriteDataArray: (OFArray OF_GENERIC(OFData *) *)dataArray
+{
+	[self asyncWriteDataArray: dataArray
+		      runLoopMode: of_run_loop_mode_default];
+}
+
+- (void)asyncWriteDataArray: (OFArray OF_GENERIC(OFData *) *)dataArray
+		runLoopMode: (of_run_loop_mode_t)runLoopMode
+{
+	OFStream <OFReadyForWritingObserving> *stream =
+	    (OFStream <OFReadyForWritingObserving> *)self;
+
+	for (OFData *data in dataArray)
+		[OFRunLoop of_addAsyncWriteForStream: stream
+						data: data
+						mode: runLoopMode
+# ifdef OF_HAVE_BLOCKS
+					       block: NULL
+# endif
+					    delegate: _delegate];
+}
+
 - (void)asyncWriteString: (OFString *)string
 {
 	[self asyncWriteString: string
@@ -1893,25 +2018,35 @@
 - (void)unreadFromBuffer: (const void *)buffer
 		  length: (size_t)length
 {
-	char *readBuffer;
+	size_t offset = _readBuffer - _readBufferMemory;
 
 	if (length > SIZE_MAX - _readBufferLength)
 		@throw [OFOutOfRangeException exception];
 
-	readBuffer = [self allocMemoryWithSize: _readBufferLength + length];
-	memcpy(readBuffer, buffer, length);
-	memcpy(readBuffer + length, _readBuffer, _readBufferLength);
+	if (offset < length) {
+		if (_readBufferCapacity - _readBufferLength < length) {
+			_readBufferMemory = [self
+			    resizeMemory: _readBufferMemory
+				    size: _readBufferLength + length];
+			_readBufferCapacity = _readBufferLength + length;
+		}
+
+		memmove(_readBufferMemory + length, _readBufferMemory + offset,
+		    _readBufferLength);
+		offset = length;
+	}
 
-	[self freeMemory: _readBufferMemory];
-	_readBuffer = _readBufferMemory = readBuffer;
+	_readBuffer = _readBufferMemory + offset - length;
+	memcpy(_readBuffer, buffer, length);
 	_readBufferLength += length;
+	_readBufferScanned = 0;
 }
 
 - (void)close
 {
 	[self freeMemory: _readBufferMemory];
 	_readBuffer = _readBufferMemory = NULL;
-	_readBufferLength = 0;
+	_readBufferLength = _readBufferCapacity = _readBufferScanned = 0;
 
 	[self freeMemory: _writeBuffer];
 	_writeBuffer = NULL;
@@ -16,11 +16,34 @@
  */
 
 #import "OFStream.h"
+#import "OFSeekableStream.h"
 
 #import "socket.h"
 
 OF_ASSUME_NONNULL_BEGIN
 
+#ifdef OF_HAVE_FILES
+@class OFStreamSocket;
+
+# ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief A block which is called when the contents of a file were written
+ *	  asynchronously to a stream socket.
+ *
+ * @param socket The socket to which the contents of the file were written
+ * @param file The file whose contents were written
+ * @param bytesWritten The number of bytes which have been written. This
+ *		       matches the requested length if no exception was
+ *		       encountered and the file was not shorter.
+ * @param exception An exception which occurred while writing or `nil` on
+ *		    success
+ */
+typedef void (^of_stream_socket_async_write_file_block_t)(
+    OFStreamSocket *_Nonnull socket, OFFile *_Nonnull file,
+    size_t bytesWritten, id _Nullable exception);
+# endif
+#endif
+
 /*!
  * @class OFStreamSocket OFStreamSocket.h ObjFW/OFStreamSocket.h
  *
@@ -31,6 +54,11 @@ OF_ASSUME_NONNULL_BEGIN
 {
 	of_socket_t _socket;
 	bool _atEndOfStream;
+#ifdef OF_HAVE_FILES
+	OFFile *_Nullable _unsentFile;
+	char *_Nullable _unsentFileData;
+	size_t _unsentFileDataLength;
+#endif
 }
 
 /*!
@@ -39,6 +67,103 @@ OF_ASSUME_NONNULL_BEGIN
  * @return A new, autoreleased OFTCPSocket
  */
 + (instancetype)socket;
+
+#ifdef OF_HAVE_FILES
+/*!
+ * @brief Writes the specified part of the specified file into the socket.
+ *
+ * Where the operating system supports it, the data is passed from the file to
+ * the socket by the kernel, using `sendfile()` for regular files and
+ * `splice()` for pipes, without being copied into the process. Otherwise, or
+ * if the socket needs to process the data itself, e.g. to encrypt it, the
+ * data is read into a buffer and written from there.
+ *
+ * The current position of the file is neither used nor changed. If the
+ * socket could not take all bytes that were read from a pipe, the remaining
+ * bytes are kept and written first by the next call for the same pipe.
+ *
+ * @param file The file to write from
+ * @param offset The offset in the file at which to start. This must be 0 for
+ *		 pipes.
+ * @param length The number of bytes to write
+ * @return The number of bytes written. This is less than the requested length
+ *	   if the end of the file was reached or if the socket is in
+ *	   non-blocking mode and could not take more data.
+ */
+- (size_t)writeFromFile: (OFFile *)file
+		 offset: (of_offset_t)offset
+		 length: (size_t)length;
+
+/*!
+ * @brief Asynchronously writes the specified part of the specified file into
+ *	  the socket.
+ *
+ * See @ref writeFromFile:offset:length: for details. When done, the
+ * delegate's `stream:didWriteFromFile:bytesWritten:exception:` is called.
+ *
+ * @param file The file to write from
+ * @param offset The offset in the file at which to start
+ * @param length The number of bytes to write
+ */
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length;
+
+/*!
+ * @brief Asynchronously writes the specified part of the specified file into
+ *	  the socket.
+ *
+ * See @ref writeFromFile:offset:length: for details. When done, the
+ * delegate's `stream:didWriteFromFile:bytesWritten:exception:` is called.
+ *
+ * @param file The file to write from
+ * @param offset The offset in the file at which to start
+ * @param length The number of bytes to write
+ * @param runLoopMode The run loop mode in which to perform the async write
+ */
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+	       runLoopMode: (of_run_loop_mode_t)runLoopMode;
+
+# ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Asynchronously writes the specified part of the specified file into
+ *	  the socket.
+ *
+ * See @ref writeFromFile:offset:length: for details.
+ *
+ * @param file The file to write from
+ * @param offset The offset in the file at which to start
+ * @param length The number of bytes to write
+ * @param block The block to call when the contents of the file have been
+ *		written or an exception occurred
+ */
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+		     block: (of_stream_socket_async_write_file_block_t)block;
+
+/*!
+ * @brief Asynchronously writes the specified part of the specified file into
+ *	  the socket.
+ *
+ * See @ref writeFromFile:offset:length: for details.
+ *
+ * @param file The file to write from
+ * @param offset The offset in the file at which to start
+ * @param length The number of bytes to write
+ * @param runLoopMode The run loop mode in which to perform the async write
+ * @param block The block to call when the contents of the file have been
+ *		written or an exception occurred
+ */
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+	       runLoopMode: (of_run_loop_mode_t)runLoopMode
+		     block: (of_stream_socket_async_write_file_block_t)block;
+# endif
+#endif
 @end
 
 OF_ASSUME_NONNULL_END
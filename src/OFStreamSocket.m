@@ -22,9 +22,27 @@
 #include <errno.h>
 #include <string.h>
 
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
+#ifdef OF_HAVE_FILES
+# include <fcntl.h>
+# include <sys/stat.h>
+# ifdef HAVE_SYS_SENDFILE_H
+#  include <sys/sendfile.h>
+# endif
+#endif
+
 #import "OFStreamSocket.h"
+#import "OFStreamSocket+Private.h"
+#import "OFStream+Private.h"
+#ifdef OF_HAVE_FILES
+# import "OFFile.h"
+#endif
+#import "OFRunLoop+Private.h"
 
 #import "OFInitializationFailedException.h"
+#import "OFInvalidArgumentException.h"
 #import "OFNotImplementedException.h"
 #import "OFNotOpenException.h"
 #import "OFOutOfRangeException.h"
@@ -34,6 +52,53 @@
 
 #import "socket_helpers.h"
 
+#if defined(HAVE_SENDMSG) && defined(HAVE_SYS_UIO_H) && !defined(OF_WINDOWS)
+# define USE_SENDMSG
+#endif
+
+#ifdef OF_HAVE_FILES
+# if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#  define USE_SENDFILE
+# endif
+# if defined(HAVE_SPLICE) && defined(SPLICE_F_MOVE)
+#  define USE_SPLICE
+# endif
+/* The size of the buffer used if the kernel cannot write from the file. */
+# define WRITE_FROM_FILE_BUFFER_SIZE 65536
+
+# if defined(OF_FILE_HANDLE_IS_FD) && \
+    (defined(USE_SENDFILE) || defined(USE_SPLICE))
+/*
+ * Returns the number of bytes the kernel wrote from the file to the socket,
+ * 0 at the end of the file or -1 with errno set if it failed or cannot write
+ * from this kind of file.
+ */
+static ssize_t
+kernelWriteFromFile(of_socket_t sock, int fd, bool isPipe, of_offset_t offset,
+    size_t length, bool blocking)
+{
+	if (length > SSIZE_MAX)
+		length = SSIZE_MAX;
+
+	if (isPipe) {
+#  ifdef USE_SPLICE
+		return splice(fd, NULL, sock, NULL, length,
+		    SPLICE_F_MOVE | (blocking ? 0 : SPLICE_F_NONBLOCK));
+#  endif
+	} else {
+#  ifdef USE_SENDFILE
+		off_t fileOffset = (off_t)offset;
+
+		return sendfile(sock, fd, &fileOffset, length);
+#  endif
+	}
+
+	errno = ENOSYS;
+	return -1;
+}
+# endif
+#endif
+
 @implementation OFStreamSocket
 + (void)initialize
 {
@@ -124,6 +189,341 @@
 	return (size_t)bytesWritten;
 }
 
+#ifdef USE_SENDMSG
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
+{
+	size_t ret = 0;
+
+	if (_socket == INVALID_SOCKET)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if ([self of_overridesLowlevelWriteBufferOfClass:
+	    [OFStreamSocket class]])
+		return [super lowlevelWriteBuffers: buffers
+					     count: count];
+
+	while (count > 0) {
+		struct iovec iov[OF_MAX_IO_VECTORS];
+		struct msghdr message;
+		size_t length;
+		size_t iovCount = of_stream_fill_io_vectors(iov, buffers,
+		    count, &length);
+		ssize_t bytesWritten;
+
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = iov;
+		message.msg_iovlen = iovCount;
+
+		if ((bytesWritten = sendmsg(_socket, &message, 0)) < 0)
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: ret + length
+				   bytesWritten: ret
+					  errNo: of_socket_errno()];
+
+		ret += bytesWritten;
+
+		if ((size_t)bytesWritten < length)
+			break;
+
+		buffers += iovCount;
+		count -= iovCount;
+	}
+
+	return ret;
+}
+#endif
+
+#ifdef OF_HAVE_FILES
+- (size_t)writeFromFile: (OFFile *)file
+		 offset: (of_offset_t)offset
+		 length: (size_t)length
+{
+	return [self of_writeFromFile: file
+			       offset: offset
+			       length: length
+				 once: false
+			    endOfFile: NULL];
+}
+
+- (size_t)of_writeFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+		      once: (bool)once
+		 endOfFile: (bool *)endOfFile
+{
+	size_t ret = 0, bufferSize;
+	bool isPipe = false;
+	of_offset_t position = 0;
+	char *buffer;
+# ifdef OF_FILE_HANDLE_IS_FD
+	struct stat st;
+	int fd;
+# endif
+
+	if (endOfFile != NULL)
+		*endOfFile = false;
+
+	if (_socket == INVALID_SOCKET)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (offset < 0)
+		@throw [OFInvalidArgumentException exception];
+
+	if (length == 0)
+		return 0;
+
+	if (once && length > WRITE_FROM_FILE_BUFFER_SIZE)
+		length = WRITE_FROM_FILE_BUFFER_SIZE;
+
+# ifdef OF_FILE_HANDLE_IS_FD
+	fd = file.fileDescriptorForReading;
+
+	if (fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+		if (offset != 0)
+			@throw [OFInvalidArgumentException exception];
+
+		isPipe = true;
+	}
+# endif
+
+	/*
+	 * Bytes that were read from a pipe, but could not be written, need to
+	 * be written before anything else is read from it. Those of another
+	 * pipe would be lost if this one could not be written completely
+	 * either.
+	 */
+	if (_unsentFileDataLength > 0) {
+		size_t unsentLength;
+
+		if (_unsentFile != file) {
+			if (isPipe)
+				@throw [OFInvalidArgumentException exception];
+		} else {
+			unsentLength = (length < _unsentFileDataLength
+			    ? length : _unsentFileDataLength);
+
+			@try {
+				ret = [self writeBuffer: _unsentFileData
+						 length: unsentLength];
+			} @catch (OFWriteFailedException *e) {
+				if (e.errNo != EAGAIN &&
+				    e.errNo != EWOULDBLOCK)
+					@throw e;
+
+				ret = e.bytesWritten;
+			}
+
+			memmove(_unsentFileData, _unsentFileData + ret,
+			    _unsentFileDataLength - ret);
+			_unsentFileDataLength -= ret;
+
+			if (ret < unsentLength || ret == length || once)
+				return ret;
+		}
+	}
+
+# if defined(OF_FILE_HANDLE_IS_FD) && \
+    (defined(USE_SENDFILE) || defined(USE_SPLICE))
+	/*
+	 * Data that is still in the write buffer needs to be written first,
+	 * which can only be guaranteed in blocking mode.
+	 */
+	if ((_blocking || !self.writeBuffered) &&
+	    ![self of_overridesLowlevelWriteBufferOfClass:
+	    [OFStreamSocket class]]) {
+		size_t kernelStart = ret;
+
+		if (self.writeBuffered)
+			[self flushWriteBuffer];
+
+		while (ret < length) {
+			ssize_t bytesWritten = kernelWriteFromFile(_socket, fd,
+			    isPipe, offset + ret, length - ret, _blocking);
+
+			if (bytesWritten < 0) {
+				int errNo = errno;
+
+				if (errNo == EINTR)
+					continue;
+
+				/* Fall back to reading the file. */
+				if (ret == kernelStart &&
+				    (errNo == EINVAL || errNo == ENOSYS))
+					break;
+
+				/* The socket or the pipe is not ready. */
+				if (errNo == EAGAIN || errNo == EWOULDBLOCK)
+					return ret;
+
+				@throw [OFWriteFailedException
+				    exceptionWithObject: self
+					requestedLength: length
+					   bytesWritten: ret
+						  errNo: errNo];
+			}
+
+			/* The end of the file was reached. */
+			if (bytesWritten == 0) {
+				if (endOfFile != NULL)
+					*endOfFile = true;
+
+				return ret;
+			}
+
+			ret += bytesWritten;
+
+			if (once)
+				return ret;
+		}
+
+		if (ret == length)
+			return ret;
+	}
+# endif
+
+	bufferSize = (length - ret < WRITE_FROM_FILE_BUFFER_SIZE
+	    ? length - ret : WRITE_FROM_FILE_BUFFER_SIZE);
+	buffer = [self allocMemoryWithSize: bufferSize];
+
+	@try {
+		if (!isPipe) {
+			position = [file seekToOffset: 0
+					       whence: SEEK_CUR];
+			[file seekToOffset: offset + ret
+				    whence: SEEK_SET];
+		}
+
+		@try {
+			while (ret < length) {
+				size_t bytesRead, bytesWritten;
+
+				bytesRead = [file
+				    readIntoBuffer: buffer
+					    length: (length - ret < bufferSize
+							? length - ret
+							: bufferSize)];
+
+				if (bytesRead == 0) {
+					if (endOfFile != NULL)
+						*endOfFile = true;
+
+					break;
+				}
+
+				@try {
+					bytesWritten = [self
+					    writeBuffer: buffer
+						 length: bytesRead];
+				} @catch (OFWriteFailedException *e) {
+					if (e.errNo != EAGAIN &&
+					    e.errNo != EWOULDBLOCK)
+						@throw e;
+
+					bytesWritten = e.bytesWritten;
+				}
+
+				ret += bytesWritten;
+
+				if (bytesWritten < bytesRead) {
+					/*
+					 * What was read from a pipe cannot be
+					 * read again, so keep it for the next
+					 * call.
+					 */
+					if (isPipe) {
+						size_t unsentLength =
+						    bytesRead - bytesWritten;
+
+						_unsentFileData = [self
+						    resizeMemory:
+						    _unsentFileData
+							    size: unsentLength];
+						memcpy(_unsentFileData,
+						    buffer + bytesWritten,
+						    unsentLength);
+						_unsentFileDataLength =
+						    unsentLength;
+
+						[_unsentFile release];
+						_unsentFile = [file retain];
+					}
+
+					break;
+				}
+
+				if (once)
+					break;
+			}
+		} @finally {
+			if (!isPipe)
+				[file seekToOffset: position
+					    whence: SEEK_SET];
+		}
+	} @finally {
+		[self freeMemory: buffer];
+	}
+
+	return ret;
+}
+
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+{
+	[self asyncWriteFromFile: file
+			  offset: offset
+			  length: length
+		     runLoopMode: of_run_loop_mode_default];
+}
+
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+	       runLoopMode: (of_run_loop_mode_t)runLoopMode
+{
+	[OFRunLoop of_addAsyncWriteForSocket: self
+					file: file
+				      offset: offset
+				      length: length
+					mode: runLoopMode
+# ifdef OF_HAVE_BLOCKS
+				       block: NULL
+# endif
+				    delegate: _delegate];
+}
+
+# ifdef OF_HAVE_BLOCKS
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+		     block: (of_stream_socket_async_write_file_block_t)block
+{
+	[self asyncWriteFromFile: file
+			  offset: offset
+			  length: length
+		     runLoopMode: of_run_loop_mode_default
+			   block: block];
+}
+
+- (void)asyncWriteFromFile: (OFFile *)file
+		    offset: (of_offset_t)offset
+		    length: (size_t)length
+	       runLoopMode: (of_run_loop_mode_t)runLoopMode
+		     block: (of_stream_socket_async_write_file_block_t)block
+{
+	[OFRunLoop of_addAsyncWriteForSocket: self
+					file: file
+				      offset: offset
+				      length: length
+					mode: runLoopMode
+				       block: block
+				    delegate: nil];
+}
+# endif
+#endif
+
 #if defined(OF_WINDOWS) || defined(OF_AMIGAOS)
 - (void)setBlocking: (bool)enable
 {
@@ -182,6 +582,14 @@
 
 	_atEndOfStream = false;
 
+#ifdef OF_HAVE_FILES
+	[_unsentFile release];
+	_unsentFile = nil;
+	[self freeMemory: _unsentFileData];
+	_unsentFileData = NULL;
+	_unsentFileDataLength = 0;
+#endif
+
 	[super close];
 }
 
@@ -94,8 +94,7 @@ parseDataElement(OFXMLElement *element)
 static OFDate *
 parseDateElement(OFXMLElement *element)
 {
-	return [OFDate dateWithDateString: element.stringValue
-				   format: @"%Y-%m-%dT%H:%M:%SZ"];
+	return [OFDate dateWithISO8601DateString: element.stringValue];
 }
 
 static OFNumber *
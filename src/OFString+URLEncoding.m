@@ -20,63 +20,230 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 #import "OFString+URLEncoding.h"
 #import "OFCharacterSet.h"
 
 #import "OFInvalidFormatException.h"
 #import "OFInvalidEncodingException.h"
 #import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
 
 /* Reference for static linking */
 int _OFString_URLEncoding_reference;
 
+/* From OFURL.m */
+extern const uint8_t of_url_character_classes[128];
+extern uint8_t of_url_character_class(OFCharacterSet *);
+
+static char
+hexDigit(unsigned char nibble)
+{
+	return (nibble > 9 ? nibble - 10 + 'A' : nibble + '0');
+}
+
+static int
+hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+
+	return -1;
+}
+
+/*
+ * Returns the number of bytes at the start of the string that are letters,
+ * digits, '-' or '.', which all of the URL character sets allow.
+ */
+static size_t
+alwaysAllowedPrefixLength(const char *string, size_t length)
+{
+	size_t i = 0;
+
+#ifdef __SSE2__
+	/*
+	 * The comparisons are signed, so bytes >= 0x80 are negative and never
+	 * within a range.
+	 */
+	const __m128i digitsLow = _mm_set1_epi8('0' - 1);
+	const __m128i digitsHigh = _mm_set1_epi8('9' + 1);
+	const __m128i upperLow = _mm_set1_epi8('A' - 1);
+	const __m128i upperHigh = _mm_set1_epi8('Z' + 1);
+	const __m128i lowerLow = _mm_set1_epi8('a' - 1);
+	const __m128i lowerHigh = _mm_set1_epi8('z' + 1);
+	const __m128i minus = _mm_set1_epi8('-'), dot = _mm_set1_epi8('.');
+
+	/* Skip 16 bytes at a time, the exact position is found below. */
+	for (; length - i >= 16; i += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(string + i));
+		__m128i allowed = _mm_or_si128(
+		    _mm_and_si128(_mm_cmpgt_epi8(block, digitsLow),
+		    _mm_cmplt_epi8(block, digitsHigh)),
+		    _mm_and_si128(_mm_cmpgt_epi8(block, upperLow),
+		    _mm_cmplt_epi8(block, upperHigh)));
+		allowed = _mm_or_si128(allowed, _mm_or_si128(
+		    _mm_and_si128(_mm_cmpgt_epi8(block, lowerLow),
+		    _mm_cmplt_epi8(block, lowerHigh)),
+		    _mm_or_si128(_mm_cmpeq_epi8(block, minus),
+		    _mm_cmpeq_epi8(block, dot))));
+
+		if (_mm_movemask_epi8(allowed) != 0xFFFF)
+			break;
+	}
+#endif
+
+	for (; i < length; i++)
+		if (!of_ascii_isalnum(string[i]) && string[i] != '-' &&
+		    string[i] != '.')
+			break;
+
+	return i;
+}
+
+/*
+ * Encodes with one of the URL character sets, which only contain ASCII
+ * characters and can therefore be checked on the UTF-8 bytes.
+ */
+static OFString *
+encodeWithCharacterClass(OFString *string, uint8_t characterClass)
+{
+	const char *UTF8String = string.UTF8String;
+	size_t length = string.UTF8StringLength;
+	size_t first = alwaysAllowedPrefixLength(UTF8String, length);
+	size_t retLength = length, j;
+	char *retCString;
+
+	for (size_t i = first; i < length; i++) {
+		unsigned char c = UTF8String[i];
+
+		if (c < 128 && (of_url_character_classes[c] & characterClass))
+			continue;
+
+		if (SIZE_MAX - retLength <= 2)
+			@throw [OFOutOfRangeException exception];
+
+		retLength += 2;
+	}
+
+	if (retLength == length)
+		return [[string copy] autorelease];
+
+	if ((retCString = malloc(retLength + 1)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: retLength + 1];
+
+	memcpy(retCString, UTF8String, first);
+	j = first;
+
+	for (size_t i = first; i < length; i++) {
+		unsigned char c = UTF8String[i];
+
+		if (c < 128 && (of_url_character_classes[c] & characterClass)) {
+			retCString[j++] = c;
+			continue;
+		}
+
+		retCString[j++] = '%';
+		retCString[j++] = hexDigit(c >> 4);
+		retCString[j++] = hexDigit(c & 0x0F);
+	}
+	retCString[j] = '\0';
+
+	return [OFString stringWithUTF8StringNoCopy: retCString
+					     length: j
+				       freeWhenDone: true];
+}
+
 @implementation OFString (URLEncoding)
 - (OFString *)stringByURLEncodingWithAllowedCharacters:
     (OFCharacterSet *)allowedCharacters
 {
-	OFMutableString *ret = [OFMutableString string];
-	void *pool = objc_autoreleasePoolPush();
-	const of_unichar_t *characters = self.characters;
-	size_t length = self.length;
-	bool (*characterIsMember)(id, SEL, of_unichar_t) =
-	    (bool (*)(id, SEL, of_unichar_t))[allowedCharacters
+	void *pool;
+	const of_unichar_t *characters;
+	size_t length;
+	bool (*characterIsMember)(id, SEL, of_unichar_t);
+	bool needsEscaping = false;
+	size_t retLength = 0, i = 0;
+	uint8_t characterClass;
+	char *retCString;
+
+	if ((characterClass = of_url_character_class(allowedCharacters)) != 0)
+		return encodeWithCharacterClass(self, characterClass);
+
+	pool = objc_autoreleasePoolPush();
+	characters = self.characters;
+	length = self.length;
+	characterIsMember = (bool (*)(id, SEL, of_unichar_t))[allowedCharacters
 	    methodForSelector: @selector(characterIsMember:)];
 
-	for (size_t i = 0; i < length; i++) {
-		of_unichar_t c = characters[i];
+	/*
+	 * First calculate the length of the result, so that it can be written
+	 * into a buffer of the right size and nothing needs to be created at
+	 * all if there is nothing to escape.
+	 */
+	for (size_t j = 0; j < length; j++) {
+		char buffer[4];
+		size_t bufferLen;
+
+		if ((bufferLen = of_string_utf8_encode(characters[j],
+		    buffer)) == 0)
+			@throw [OFInvalidEncodingException exception];
+
+		if (!characterIsMember(allowedCharacters,
+		    @selector(characterIsMember:), characters[j])) {
+			needsEscaping = true;
+			bufferLen *= 3;
+		}
+
+		if (SIZE_MAX - retLength <= bufferLen)
+			@throw [OFOutOfRangeException exception];
+
+		retLength += bufferLen;
+	}
+
+	if (!needsEscaping) {
+		objc_autoreleasePoolPop(pool);
+		return [[self copy] autorelease];
+	}
+
+	if ((retCString = malloc(retLength + 1)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: retLength + 1];
+
+	for (size_t j = 0; j < length; j++) {
+		of_unichar_t c = characters[j];
+		char buffer[4];
+		size_t bufferLen = of_string_utf8_encode(c, buffer);
 
 		if (characterIsMember(allowedCharacters,
-		    @selector(characterIsMember:), c))
-			[ret appendCharacters: &c
-				       length: 1];
-		else {
-			char buffer[4];
-			size_t bufferLen;
-
-			if ((bufferLen = of_string_utf8_encode(c, buffer)) == 0)
-				@throw [OFInvalidEncodingException exception];
-
-			for (size_t j = 0; j < bufferLen; j++) {
-				unsigned char byte = buffer[j];
-				unsigned char high = byte >> 4;
-				unsigned char low = byte & 0x0F;
-				char escaped[3];
-
-				escaped[0] = '%';
-				escaped[1] =
-				    (high > 9 ? high - 10 + 'A' : high + '0');
-				escaped[2] =
-				    (low  > 9 ? low  - 10 + 'A' : low  + '0');
-
-				[ret appendUTF8String: escaped
-					       length: 3];
-			}
+		    @selector(characterIsMember:), c)) {
+			memcpy(retCString + i, buffer, bufferLen);
+			i += bufferLen;
+			continue;
+		}
+
+		for (size_t k = 0; k < bufferLen; k++) {
+			unsigned char byte = buffer[k];
+
+			retCString[i++] = '%';
+			retCString[i++] = hexDigit(byte >> 4);
+			retCString[i++] = hexDigit(byte & 0x0F);
 		}
 	}
+	retCString[i] = '\0';
 
 	objc_autoreleasePoolPop(pool);
 
-	return ret;
+	return [OFString stringWithUTF8StringNoCopy: retCString
+					     length: i
+				       freeWhenDone: true];
 }
 
 - (OFString *)stringByURLDecoding
@@ -84,58 +251,47 @@ int _OFString_URLEncoding_reference;
 	void *pool = objc_autoreleasePoolPush();
 	const char *string = self.UTF8String;
 	size_t length = self.UTF8StringLength;
+	const char *escape;
 	char *retCString, *retCString2;
-	char byte = 0;
-	int state = 0;
 	size_t i = 0;
 
+	/* Nothing to decode, so there is no need for a new string. */
+	if ((escape = memchr(string, '%', length)) == NULL) {
+		objc_autoreleasePoolPop(pool);
+		return [[self copy] autorelease];
+	}
+
 	if ((retCString = malloc(length + 1)) == NULL)
 		@throw [OFOutOfMemoryException
 		    exceptionWithRequestedSize: length + 1];
 
-	while (length--) {
-		char c = *string++;
+	/* Copy everything between the escapes in one go. */
+	do {
+		size_t runLength = escape - string;
+		int high, low;
 
-		switch (state) {
-		case 0:
-			if (c == '%')
-				state = 1;
-			else
-				retCString[i++] = c;
-			break;
-		case 1:
-		case 2:;
-			uint8_t shift = (state == 1 ? 4 : 0);
-
-			if (c >= '0' && c <= '9')
-				byte += (c - '0') << shift;
-			else if (c >= 'A' && c <= 'F')
-				byte += (c - 'A' + 10) << shift;
-			else if (c >= 'a' && c <= 'f')
-				byte += (c - 'a' + 10) << shift;
-			else {
-				free(retCString);
-				@throw [OFInvalidFormatException exception];
-			}
-
-			if (++state == 3) {
-				retCString[i++] = byte;
-				state = 0;
-				byte = 0;
-			}
+		memcpy(retCString + i, string, runLength);
+		i += runLength;
 
-			break;
+		if (length - runLength < 3 ||
+		    (high = hexValue(escape[1])) == -1 ||
+		    (low = hexValue(escape[2])) == -1) {
+			free(retCString);
+			@throw [OFInvalidFormatException exception];
 		}
-	}
+
+		retCString[i++] = (char)((high << 4) | low);
+
+		string = escape + 3;
+		length -= runLength + 3;
+	} while ((escape = memchr(string, '%', length)) != NULL);
+
+	memcpy(retCString + i, string, length);
+	i += length;
 	retCString[i] = '\0';
 
 	objc_autoreleasePoolPop(pool);
 
-	if (state != 0) {
-		free(retCString);
-		@throw [OFInvalidFormatException exception];
-	}
-
 	/* We don't care if it fails, as we only made it smaller. */
 	if ((retCString2 = realloc(retCString, i + 1)) == NULL)
 		retCString2 = retCString;
@@ -17,98 +17,179 @@
 
 #include "config.h"
 
-#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 #import "OFString.h"
+#import "OFXMLNode+Private.h"
 
 #import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
 
 int _OFString_XMLEscaping_reference;
 
-@implementation OFString (XMLEscaping)
-- (OFString *)stringByXMLEscaping
+/*
+ * Returns the index of the first character that needs to be escaped or length
+ * if there is none.
+ */
+static size_t
+firstCharacterToEscape(const char *string, size_t length)
 {
-	void *pool = objc_autoreleasePoolPush();
-	char *retCString;
-	const char *string, *append;
-	size_t length, retLength, appendLen;
-	size_t j;
-	OFString *ret;
+	size_t i = 0;
 
-	string = self.UTF8String;
-	length = self.UTF8StringLength;
+#ifdef __SSE2__
+	const __m128i lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>');
+	const __m128i quot = _mm_set1_epi8('"'), apos = _mm_set1_epi8('\'');
+	const __m128i amp = _mm_set1_epi8('&'), cr = _mm_set1_epi8('\r');
 
-	j = 0;
-	retLength = length;
+	/* Skip 16 bytes at a time, the exact position is found below. */
+	for (; length - i >= 16; i += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(string + i));
+		__m128i match = _mm_or_si128(
+		    _mm_or_si128(_mm_cmpeq_epi8(block, lt),
+		    _mm_cmpeq_epi8(block, gt)),
+		    _mm_or_si128(_mm_cmpeq_epi8(block, quot),
+		    _mm_cmpeq_epi8(block, apos)));
+		match = _mm_or_si128(match, _mm_or_si128(
+		    _mm_cmpeq_epi8(block, amp), _mm_cmpeq_epi8(block, cr)));
 
-	/*
-	 * We can't use allocMemoryWithSize: here as it might be a @"" literal
-	 */
-	if ((retCString = malloc(retLength)) == NULL)
-		@throw [OFOutOfMemoryException
-		    exceptionWithRequestedSize: retLength];
+		if (_mm_movemask_epi8(match) != 0)
+			break;
+	}
+#endif
 
-	for (size_t i = 0; i < length; i++) {
+	for (; i < length; i++) {
 		switch (string[i]) {
 		case '<':
-			append = "&lt;";
-			appendLen = 4;
+		case '>':
+		case '"':
+		case '\'':
+		case '&':
+		case '\r':
+			return i;
+		}
+	}
+
+	return length;
+}
+
+void
+of_xml_escape(const char *string, size_t length,
+    void (*append)(void *, const char *, size_t), void *context)
+{
+	size_t i = 0;
+
+	while (i < length) {
+		size_t runLength =
+		    firstCharacterToEscape(string + i, length - i);
+		const char *replacement;
+		size_t replacementLength;
+
+		if (runLength > 0)
+			append(context, string + i, runLength);
+
+		if ((i += runLength) == length)
+			break;
+
+		switch (string[i++]) {
+		case '<':
+			replacement = "&lt;";
+			replacementLength = 4;
 			break;
 		case '>':
-			append = "&gt;";
-			appendLen = 4;
+			replacement = "&gt;";
+			replacementLength = 4;
 			break;
 		case '"':
-			append = "&quot;";
-			appendLen = 6;
+			replacement = "&quot;";
+			replacementLength = 6;
 			break;
 		case '\'':
-			append = "&apos;";
-			appendLen = 6;
+			replacement = "&apos;";
+			replacementLength = 6;
 			break;
 		case '&':
-			append = "&amp;";
-			appendLen = 5;
-			break;
-		case '\r':
-			append = "&#xD;";
-			appendLen = 5;
+			replacement = "&amp;";
+			replacementLength = 5;
 			break;
 		default:
-			append = NULL;
-			appendLen = 0;
+			replacement = "&#xD;";
+			replacementLength = 5;
+			break;
 		}
 
-		if (append != NULL) {
-			char *newRetCString;
-
-			if ((newRetCString = realloc(retCString,
-			    retLength + appendLen)) == NULL) {
-				free(retCString);
-				@throw [OFOutOfMemoryException
-				     exceptionWithRequestedSize: retLength +
-								 appendLen];
-			}
-			retCString = newRetCString;
-			retLength += appendLen - 1;
-
-			memcpy(retCString + j, append, appendLen);
-			j += appendLen;
-		} else
-			retCString[j++] = string[i];
+		append(context, replacement, replacementLength);
 	}
-	assert(j == retLength);
+}
+
+struct escapeBuffer {
+	char *items;
+	size_t length;
+};
+
+/* The buffer has been allocated with the exact length of the result. */
+static void
+appendToBuffer(void *context, const char *string, size_t length)
+{
+	struct escapeBuffer *buffer = context;
 
-	objc_autoreleasePoolPop(pool);
+	memcpy(buffer->items + buffer->length, string, length);
+	buffer->length += length;
+}
 
-	@try {
-		ret = [OFString stringWithUTF8String: retCString
-					      length: retLength];
-	} @finally {
-		free(retCString);
+@implementation OFString (XMLEscaping)
+- (OFString *)stringByXMLEscaping
+{
+	const char *string = self.UTF8String;
+	size_t length = self.UTF8StringLength;
+	size_t first = firstCharacterToEscape(string, length);
+	size_t retLength;
+	char *retCString;
+	struct escapeBuffer buffer;
+
+	if (first == length)
+		return [[self copy] autorelease];
+
+	/* Calculate the exact length first so that we only allocate once. */
+	retLength = length;
+	for (size_t i = first; i < length; i++) {
+		switch (string[i]) {
+		case '<':
+		case '>':
+			retLength += 3;
+			break;
+		case '"':
+		case '\'':
+			retLength += 5;
+			break;
+		case '&':
+		case '\r':
+			retLength += 4;
+			break;
+		}
+
+		if (retLength < length)
+			@throw [OFOutOfRangeException exception];
 	}
-	return ret;
+
+	if (retLength == SIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	if ((retCString = malloc(retLength + 1)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: retLength + 1];
+
+	buffer.items = retCString;
+	buffer.length = 0;
+	of_xml_escape(string, length, appendToBuffer, &buffer);
+	retCString[buffer.length] = '\0';
+
+	return [OFString stringWithUTF8StringNoCopy: retCString
+					     length: retLength
+				       freeWhenDone: true];
 }
 @end
@@ -17,24 +17,27 @@
 
 #include "config.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #import "OFString.h"
 
 #import "OFInvalidFormatException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
 #import "OFUnknownXMLEntityException.h"
 
 int _OFString_XMLUnescaping_reference;
 
-static OF_INLINE OFString *
-parseNumericEntity(const char *entity, size_t length)
+static bool
+parseNumericEntity(const char *entity, size_t length, char buffer[4],
+    size_t *bufferLength)
 {
 	of_unichar_t c;
 	size_t i;
-	char buffer[5];
 
 	if (length == 1 || *entity != '#')
-		return nil;
+		return false;
 
 	c = 0;
 	entity++;
@@ -42,7 +45,7 @@ parseNumericEntity(const char *entity, size_t length)
 
 	if (entity[0] == 'x') {
 		if (length == 1)
-			return nil;
+			return false;
 
 		entity++;
 		length--;
@@ -55,101 +58,124 @@ parseNumericEntity(const char *entity, size_t length)
 			else if (entity[i] >= 'a' && entity[i] <= 'f')
 				c = (c << 4) | (entity[i] - 'a' + 10);
 			else
-				return nil;
+				return false;
 		}
 	} else {
 		for (i = 0; i < length; i++) {
 			if (entity[i] >= '0' && entity[i] <= '9')
 				c = (c * 10) + (entity[i] - '0');
 			else
-				return nil;
+				return false;
 		}
 	}
 
-	if ((i = of_string_utf8_encode(c, buffer)) == 0)
-		return nil;
-	buffer[i] = 0;
+	if ((*bufferLength = of_string_utf8_encode(c, buffer)) == 0)
+		return false;
 
-	return [OFString stringWithUTF8String: buffer
-				       length: i];
+	return true;
 }
 
-static OFString *
-parseEntities(OFString *self, id (*lookup)(void *, OFString *, OFString *),
-    void *context)
+static void
+append(char **buffer, size_t *length, size_t *capacity, const char *string,
+    size_t stringLength)
 {
-	OFMutableString *ret;
-	void *pool;
-	const char *string;
-	size_t i, last, length;
-	bool inEntity;
+	if (*capacity - *length < stringLength) {
+		size_t newCapacity;
+		char *newBuffer;
 
-	ret = [OFMutableString string];
+		if (SIZE_MAX - *length < stringLength ||
+		    *capacity > SIZE_MAX / 2)
+			@throw [OFOutOfRangeException exception];
 
-	pool = objc_autoreleasePoolPush();
+		newCapacity = *capacity * 2;
+		if (newCapacity - *length < stringLength)
+			newCapacity = *length + stringLength;
 
-	string = self.UTF8String;
-	length = self.UTF8StringLength;
+		if ((newBuffer = realloc(*buffer, newCapacity)) == NULL)
+			@throw [OFOutOfMemoryException
+			    exceptionWithRequestedSize: newCapacity];
 
-	last = 0;
-	inEntity = false;
+		*buffer = newBuffer;
+		*capacity = newCapacity;
+	}
 
-	for (i = 0; i < length; i++) {
-		if (!inEntity && string[i] == '&') {
-			[ret appendUTF8String: string + last
-				       length: i - last];
+	memcpy(*buffer + *length, string, stringLength);
+	*length += stringLength;
+}
 
-			last = i + 1;
-			inEntity = true;
-		} else if (inEntity && string[i] == ';') {
-			const char *entity = string + last;
-			size_t entityLength = i - last;
+static OFString *
+parseEntities(OFString *self, id (*lookup)(void *, OFString *, OFString *),
+    void *context)
+{
+	const char *string = self.UTF8String;
+	size_t length = self.UTF8StringLength;
+	const char *ampersand = NULL;
+	char *ret;
+	size_t retLength, retCapacity, i, last;
+
+	if (length > 0)
+		ampersand = memchr(string, '&', length);
+
+	if (ampersand == NULL)
+		return [[self copy] autorelease];
+
+	/*
+	 * Entities are never shorter than what they are replaced with, unless
+	 * it is an unknown entity resolved by the lookup function.
+	 */
+	retCapacity = length + 1;
+	if ((ret = malloc(retCapacity)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: retCapacity];
+
+	@try {
+		retLength = 0;
+		last = 0;
+		i = ampersand - string;
+
+		while (i < length) {
+			const char *entity, *semicolon;
+			size_t entityLength;
+
+			append(&ret, &retLength, &retCapacity, string + last,
+			    i - last);
+
+			entity = string + i + 1;
+			semicolon = memchr(entity, ';', length - i - 1);
+			if (semicolon == NULL)
+				@throw [OFInvalidFormatException exception];
+
+			entityLength = semicolon - entity;
 
 			if (entityLength == 2 && memcmp(entity, "lt", 2) == 0)
-				[ret appendCString: "<"
-					  encoding: OF_STRING_ENCODING_ASCII
-					    length: 1];
+				append(&ret, &retLength, &retCapacity, "<", 1);
 			else if (entityLength == 2 &&
 			    memcmp(entity, "gt", 2) == 0)
-				[ret appendCString: ">"
-					  encoding: OF_STRING_ENCODING_ASCII
-					    length: 1];
+				append(&ret, &retLength, &retCapacity, ">", 1);
 			else if (entityLength == 4 &&
 			    memcmp(entity, "quot", 4) == 0)
-				[ret appendCString: "\""
-					  encoding: OF_STRING_ENCODING_ASCII
-					    length: 1];
+				append(&ret, &retLength, &retCapacity, "\"", 1);
 			else if (entityLength == 4 &&
 			    memcmp(entity, "apos", 4) == 0)
-				[ret appendCString: "'"
-					  encoding: OF_STRING_ENCODING_ASCII
-					    length: 1];
+				append(&ret, &retLength, &retCapacity, "'", 1);
 			else if (entityLength == 3 &&
 			    memcmp(entity, "amp", 3) == 0)
-				[ret appendCString: "&"
-					  encoding: OF_STRING_ENCODING_ASCII
-					    length: 1];
-			else if (entity[0] == '#') {
-				void *pool2;
-				OFString *tmp;
-
-				pool2 = objc_autoreleasePoolPush();
-				tmp = parseNumericEntity(entity,
-				    entityLength);
+				append(&ret, &retLength, &retCapacity, "&", 1);
+			else if (entityLength > 0 && entity[0] == '#') {
+				char buffer[4];
+				size_t bufferLength;
 
-				if (tmp == nil)
+				if (!parseNumericEntity(entity, entityLength,
+				    buffer, &bufferLength))
 					@throw [OFInvalidFormatException
 					    exception];
 
-				[ret appendString: tmp];
-
-				objc_autoreleasePoolPop(pool2);
+				append(&ret, &retLength, &retCapacity,
+				    buffer, bufferLength);
 			} else {
-				void *pool2;
+				void *pool = objc_autoreleasePoolPush();
 				OFString *name, *tmp;
 
-				pool2 = objc_autoreleasePoolPush();
-
 				name = [OFString
 				    stringWithUTF8String: entity
 						  length: entityLength];
@@ -159,27 +185,32 @@ parseEntities(OFString *self, id (*lookup)(void *, OFString *, OFString *),
 					@throw [OFUnknownXMLEntityException
 					    exceptionWithEntityName: name];
 
-				[ret appendString: tmp];
+				append(&ret, &retLength, &retCapacity,
+				    tmp.UTF8String, tmp.UTF8StringLength);
 
-				objc_autoreleasePoolPop(pool2);
+				objc_autoreleasePoolPop(pool);
 			}
 
-			last = i + 1;
-			inEntity = false;
-		}
-	}
-
-	if (inEntity)
-		@throw [OFInvalidFormatException exception];
+			last = i = semicolon - string + 1;
 
-	[ret appendUTF8String: string + last
-		       length: i - last];
+			if ((ampersand = memchr(string + i, '&',
+			    length - i)) == NULL)
+				break;
 
-	[ret makeImmutable];
+			i = ampersand - string;
+		}
 
-	objc_autoreleasePoolPop(pool);
+		append(&ret, &retLength, &retCapacity, string + last,
+		    length - last);
+		append(&ret, &retLength, &retCapacity, "", 1);
+	} @catch (id e) {
+		free(ret);
+		@throw e;
+	}
 
-	return ret;
+	return [OFString stringWithUTF8StringNoCopy: ret
+					     length: retLength - 1
+				       freeWhenDone: true];
 }
 
 static id
@@ -38,6 +38,7 @@
 #import "OFSerialization.h"
 #import "OFJSONRepresentation.h"
 #import "OFMessagePackRepresentation.h"
+#import "OFBinaryPropertyListRepresentation.h"
 
 OF_ASSUME_NONNULL_BEGIN
 
@@ -120,7 +121,8 @@ typedef void (^of_string_line_enumeration_block_t)(OFString *line, bool *stop);
  * @brief A class for handling strings.
  */
 @interface OFString: OFObject <OFCopying, OFMutableCopying, OFComparing,
-    OFSerialization, OFJSONRepresentation, OFMessagePackRepresentation>
+    OFSerialization, OFJSONRepresentation, OFMessagePackRepresentation,
+    OFBinaryPropertyListRepresentation>
 
 /*!
  * @brief The length of the string in Unicode codepoints.
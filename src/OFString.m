@@ -32,6 +32,7 @@
 
 #import "OFString.h"
 #import "OFArray.h"
+#import "OFBinaryPropertyListWriter.h"
 #import "OFCharacterSet.h"
 #import "OFData.h"
 #import "OFDictionary.h"
@@ -40,6 +41,7 @@
 # import "OFFileManager.h"
 #endif
 #import "OFLocale.h"
+#import "OFMessagePackWriter.h"
 #import "OFStream.h"
 #import "OFURL.h"
 #import "OFURLHandler.h"
@@ -1763,54 +1765,13 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 
 - (OFData *)messagePackRepresentation
 {
-	OFMutableData *data;
-	size_t length;
-
-	length = self.UTF8StringLength;
-
-	if (length <= 31) {
-		uint8_t tmp = 0xA0 | ((uint8_t)length & 0x1F);
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: length + 1];
-
-		[data addItem: &tmp];
-	} else if (length <= UINT8_MAX) {
-		uint8_t type = 0xD9;
-		uint8_t tmp = (uint8_t)length;
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: length + 2];
-
-		[data addItem: &type];
-		[data addItem: &tmp];
-	} else if (length <= UINT16_MAX) {
-		uint8_t type = 0xDA;
-		uint16_t tmp = OF_BSWAP16_IF_LE((uint16_t)length);
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: length + 3];
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else if (length <= UINT32_MAX) {
-		uint8_t type = 0xDB;
-		uint32_t tmp = OF_BSWAP32_IF_LE((uint32_t)length);
-
-		data = [OFMutableData dataWithItemSize: 1
-					      capacity: length + 5];
-
-		[data addItem: &type];
-		[data addItems: &tmp
-			 count: sizeof(tmp)];
-	} else
-		@throw [OFOutOfRangeException exception];
-
-	[data addItems: self.UTF8String
-		 count: length];
+	return [OFMessagePackWriter messagePackRepresentationOfObject: self];
+}
 
-	return data;
+- (OFData *)binaryPropertyListRepresentation
+{
+	return [OFBinaryPropertyListWriter
+	    binaryPropertyListRepresentationOfObject: self];
 }
 
 - (of_range_t)rangeOfString: (OFString *)string
@@ -35,6 +35,35 @@
 #import "OFInvalidFormatException.h"
 #import "OFOutOfMemoryException.h"
 
+#define URL_CHARACTER_SCHEME	0x01
+#define URL_CHARACTER_HOST	0x02
+#define URL_CHARACTER_PATH	0x04
+#define URL_CHARACTER_QUERY	0x08
+
+/*
+ * Which of the URL character sets each ASCII character is a member of. The
+ * host set is also used for the user and password, the query set is also used
+ * for the fragment.
+ */
+const uint8_t of_url_character_classes[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x0E, 0x00, 0x00, 0x0E, 0x00, 0x0E, 0x0E,
+	0x0E, 0x0E, 0x0E, 0x0F, 0x0E, 0x0F, 0x0F, 0x0C,
+	0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0C, 0x0E, 0x00, 0x0E, 0x00, 0x08,
+	0x0C, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x0E,
+	0x00, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+	0x0F, 0x0F, 0x0F, 0x00, 0x00, 0x00, 0x0E, 0x00
+};
+
 static OFCharacterSet *URLAllowedCharacterSet = nil;
 static OFCharacterSet *URLSchemeAllowedCharacterSet = nil;
 static OFCharacterSet *URLPathAllowedCharacterSet = nil;
@@ -196,29 +225,8 @@ URLPathToPath(OFString *path)
 
 - (bool)characterIsMember: (of_unichar_t)character
 {
-	if (character < CHAR_MAX && of_ascii_isalnum(character))
-		return true;
-
-	switch (character) {
-	case '-':
-	case '.':
-	case '_':
-	case '~':
-	case '!':
-	case '$':
-	case '&':
-	case '\'':
-	case '(':
-	case ')':
-	case '*':
-	case '+':
-	case ',':
-	case ';':
-	case '=':
-		return true;
-	default:
-		return false;
-	}
+	return (character < 128 &&
+	    (of_url_character_classes[character] & URL_CHARACTER_HOST));
 }
 @end
 
@@ -239,17 +247,8 @@ URLPathToPath(OFString *path)
 
 - (bool)characterIsMember: (of_unichar_t)character
 {
-	if (character < CHAR_MAX && of_ascii_isalnum(character))
-		return true;
-
-	switch (character) {
-	case '+':
-	case '-':
-	case '.':
-		return true;
-	default:
-		return false;
-	}
+	return (character < 128 &&
+	    (of_url_character_classes[character] & URL_CHARACTER_SCHEME));
 }
 @end
 
@@ -270,32 +269,8 @@ URLPathToPath(OFString *path)
 
 - (bool)characterIsMember: (of_unichar_t)character
 {
-	if (character < CHAR_MAX && of_ascii_isalnum(character))
-		return true;
-
-	switch (character) {
-	case '-':
-	case '.':
-	case '_':
-	case '~':
-	case '!':
-	case '$':
-	case '&':
-	case '\'':
-	case '(':
-	case ')':
-	case '*':
-	case '+':
-	case ',':
-	case ';':
-	case '=':
-	case ':':
-	case '@':
-	case '/':
-		return true;
-	default:
-		return false;
-	}
+	return (character < 128 &&
+	    (of_url_character_classes[character] & URL_CHARACTER_PATH));
 }
 @end
 
@@ -316,33 +291,8 @@ URLPathToPath(OFString *path)
 
 - (bool)characterIsMember: (of_unichar_t)character
 {
-	if (character < CHAR_MAX && of_ascii_isalnum(character))
-		return true;
-
-	switch (character) {
-	case '-':
-	case '.':
-	case '_':
-	case '~':
-	case '!':
-	case '$':
-	case '&':
-	case '\'':
-	case '(':
-	case ')':
-	case '*':
-	case '+':
-	case ',':
-	case ';':
-	case '=':
-	case ':':
-	case '@':
-	case '/':
-	case '?':
-		return true;
-	default:
-		return false;
-	}
+	return (character < 128 &&
+	    (of_url_character_classes[character] & URL_CHARACTER_QUERY));
 }
 @end
 
@@ -377,16 +327,66 @@ URLPathToPath(OFString *path)
 }
 @end
 
+static bool
+isEscaped(const char *UTF8String, size_t length, uint8_t characterClass)
+{
+	for (size_t i = 0; i < length; i++) {
+		unsigned char c = UTF8String[i];
+
+		if (c >= 128 ||
+		    (!(of_url_character_classes[c] & characterClass) &&
+		    c != '%'))
+			return false;
+	}
+
+	return true;
+}
+
+static OFString *
+copyEscapedComponent(const char *UTF8String, size_t length,
+    uint8_t characterClass)
+{
+	if (!isEscaped(UTF8String, length, characterClass))
+		@throw [OFInvalidFormatException exception];
+
+	return [[OFString alloc] initWithUTF8String: UTF8String
+					     length: length];
+}
+
+uint8_t
+of_url_character_class(OFCharacterSet *characterSet)
+{
+	if (characterSet == URLAllowedCharacterSet)
+		return URL_CHARACTER_HOST;
+	if (characterSet == URLSchemeAllowedCharacterSet)
+		return URL_CHARACTER_SCHEME;
+	if (characterSet == URLPathAllowedCharacterSet)
+		return URL_CHARACTER_PATH;
+	if (characterSet == URLQueryOrFragmentAllowedCharacterSet)
+		return URL_CHARACTER_QUERY;
+
+	return 0;
+}
+
 void
 of_url_verify_escaped(OFString *string, OFCharacterSet *characterSet)
 {
 	void *pool = objc_autoreleasePoolPush();
+	uint8_t characterClass = of_url_character_class(characterSet);
 
-	characterSet = [[[OFInvertedCharacterSetWithoutPercent alloc]
-	    of_initWithCharacterSet: characterSet] autorelease];
+	if (characterClass != 0) {
+		/* One of ours, so it can be checked on the bytes. */
+		if (!isEscaped(string.UTF8String, string.UTF8StringLength,
+		    characterClass))
+			@throw [OFInvalidFormatException exception];
+	} else {
+		characterSet = [[[OFInvertedCharacterSetWithoutPercent alloc]
+		    of_initWithCharacterSet: characterSet] autorelease];
 
-	if ([string indexOfCharacterFromSet: characterSet] != OF_NOT_FOUND)
-		@throw [OFInvalidFormatException exception];
+		if ([string indexOfCharacterFromSet: characterSet] !=
+		    OF_NOT_FOUND)
+			@throw [OFInvalidFormatException exception];
+	}
 
 	objc_autoreleasePoolPop(pool);
 }
@@ -464,82 +464,68 @@ of_url_verify_escaped(OFString *string, OFCharacterSet *characterSet)
 
 - (instancetype)initWithString: (OFString *)string
 {
-	char *UTF8String, *UTF8String2 = NULL;
-
 	self = [super init];
 
 	@try {
 		void *pool = objc_autoreleasePoolPush();
-		char *tmp, *tmp2;
+		const char *UTF8String = string.UTF8String;
+		const char *end = UTF8String + string.UTF8StringLength;
+		const char *tmp, *authorityEnd, *pathEnd;
+		bool isLowercase = true;
 
-		if ((UTF8String2 = of_strdup(string.UTF8String)) == NULL)
-			@throw [OFOutOfMemoryException
-			     exceptionWithRequestedSize:
-			     string.UTF8StringLength];
+		/*
+		 * Everything is found in a single pass over the string and each
+		 * component is only created once it has been verified.
+		 */
 
-		UTF8String = UTF8String2;
-
-		if ((tmp = strchr(UTF8String, ':')) == NULL)
+		if ((tmp = memchr(UTF8String, ':', end - UTF8String)) == NULL)
 			@throw [OFInvalidFormatException exception];
 
-		if (strncmp(tmp, "://", 3) != 0)
+		if (end - tmp < 3 || tmp[1] != '/' || tmp[2] != '/')
 			@throw [OFInvalidFormatException exception];
 
-		for (tmp2 = UTF8String; tmp2 < tmp; tmp2++)
-			*tmp2 = of_ascii_tolower(*tmp2);
-
-		_URLEncodedScheme = [[OFString alloc]
-		    initWithUTF8String: UTF8String
-				length: tmp - UTF8String];
-
-		of_url_verify_escaped(_URLEncodedScheme,
-		    [OFCharacterSet URLSchemeAllowedCharacterSet]);
+		for (const char *iter = UTF8String; iter < tmp; iter++)
+			if (of_ascii_tolower(*iter) != *iter)
+				isLowercase = false;
 
-		UTF8String = tmp + 3;
+		_URLEncodedScheme = copyEscapedComponent(UTF8String,
+		    tmp - UTF8String, URL_CHARACTER_SCHEME);
 
-		if ((tmp = strchr(UTF8String, '/')) != NULL) {
-			*tmp = '\0';
-			tmp++;
+		if (!isLowercase) {
+			OFString *old = _URLEncodedScheme;
+			_URLEncodedScheme = [old.lowercaseString copy];
+			[old release];
 		}
 
-		if ((tmp2 = strchr(UTF8String, '@')) != NULL) {
-			char *tmp3;
-
-			*tmp2 = '\0';
-			tmp2++;
+		UTF8String = tmp + 3;
 
-			if ((tmp3 = strchr(UTF8String, ':')) != NULL) {
-				*tmp3 = '\0';
-				tmp3++;
+		if ((authorityEnd = memchr(UTF8String, '/',
+		    end - UTF8String)) == NULL)
+			authorityEnd = end;
 
-				_URLEncodedUser = [[OFString alloc]
-				    initWithUTF8String: UTF8String];
-				_URLEncodedPassword = [[OFString alloc]
-				    initWithUTF8String: tmp3];
+		if ((tmp = memchr(UTF8String, '@',
+		    authorityEnd - UTF8String)) != NULL) {
+			const char *userEnd;
 
-				of_url_verify_escaped(_URLEncodedPassword,
-				    [OFCharacterSet
-				    URLPasswordAllowedCharacterSet]);
-			} else
-				_URLEncodedUser = [[OFString alloc]
-				    initWithUTF8String: UTF8String];
+			if ((userEnd = memchr(UTF8String, ':',
+			    tmp - UTF8String)) != NULL)
+				_URLEncodedPassword = copyEscapedComponent(
+				    userEnd + 1, tmp - userEnd - 1,
+				    URL_CHARACTER_HOST);
+			else
+				userEnd = tmp;
 
-			of_url_verify_escaped(_URLEncodedUser,
-			    [OFCharacterSet URLUserAllowedCharacterSet]);
+			_URLEncodedUser = copyEscapedComponent(UTF8String,
+			    userEnd - UTF8String, URL_CHARACTER_HOST);
 
-			UTF8String = tmp2;
+			UTF8String = tmp + 1;
 		}
 
-		if ((tmp2 = strchr(UTF8String, ':')) != NULL) {
-			OFString *portString;
-
-			*tmp2 = '\0';
-			tmp2++;
-
-			_URLEncodedHost = [[OFString alloc]
-			    initWithUTF8String: UTF8String];
-
-			portString = [OFString stringWithUTF8String: tmp2];
+		if ((tmp = memchr(UTF8String, ':',
+		    authorityEnd - UTF8String)) != NULL) {
+			OFString *portString = [OFString
+			    stringWithUTF8String: tmp + 1
+					  length: authorityEnd - tmp - 1];
 
 			if (portString.decimalValue > 65535)
 				@throw [OFInvalidFormatException exception];
@@ -547,51 +533,38 @@ of_url_verify_escaped(OFString *string, OFCharacterSet *characterSet)
 			_port = [[OFNumber alloc] initWithUInt16:
 			    (uint16_t)portString.decimalValue];
 		} else
-			_URLEncodedHost = [[OFString alloc]
-			    initWithUTF8String: UTF8String];
+			tmp = authorityEnd;
 
-		of_url_verify_escaped(_URLEncodedHost,
-		    [OFCharacterSet URLHostAllowedCharacterSet]);
+		_URLEncodedHost = copyEscapedComponent(UTF8String,
+		    tmp - UTF8String, URL_CHARACTER_HOST);
 
-		if ((UTF8String = tmp) != NULL) {
-			if ((tmp = strchr(UTF8String, '#')) != NULL) {
-				*tmp = '\0';
+		if ((UTF8String = authorityEnd) < end) {
+			pathEnd = end;
 
-				_URLEncodedFragment = [[OFString alloc]
-				    initWithUTF8String: tmp + 1];
-
-				of_url_verify_escaped(_URLEncodedFragment,
-				    [OFCharacterSet
-				    URLFragmentAllowedCharacterSet]);
+			if ((tmp = memchr(UTF8String, '#',
+			    end - UTF8String)) != NULL) {
+				_URLEncodedFragment = copyEscapedComponent(
+				    tmp + 1, end - tmp - 1,
+				    URL_CHARACTER_QUERY);
+				pathEnd = tmp;
 			}
 
-			if ((tmp = strchr(UTF8String, '?')) != NULL) {
-				*tmp = '\0';
-
-				_URLEncodedQuery = [[OFString alloc]
-				    initWithUTF8String: tmp + 1];
-
-				of_url_verify_escaped(_URLEncodedQuery,
-				    [OFCharacterSet
-				    URLQueryAllowedCharacterSet]);
+			if ((tmp = memchr(UTF8String, '?',
+			    pathEnd - UTF8String)) != NULL) {
+				_URLEncodedQuery = copyEscapedComponent(
+				    tmp + 1, pathEnd - tmp - 1,
+				    URL_CHARACTER_QUERY);
+				pathEnd = tmp;
 			}
 
-			UTF8String--;
-			*UTF8String = '/';
-
-			_URLEncodedPath = [[OFString alloc]
-			    initWithUTF8String: UTF8String];
-
-			of_url_verify_escaped(_URLEncodedPath,
-			    [OFCharacterSet URLPathAllowedCharacterSet]);
+			_URLEncodedPath = copyEscapedComponent(UTF8String,
+			    pathEnd - UTF8String, URL_CHARACTER_PATH);
 		}
 
 		objc_autoreleasePoolPop(pool);
 	} @catch (id e) {
 		[self release];
 		@throw e;
-	} @finally {
-		free(UTF8String2);
 	}
 
 	return self;
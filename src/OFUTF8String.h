@@ -48,6 +48,7 @@ extern "C" {
 extern int of_string_utf8_check(const char *, size_t, size_t *);
 extern size_t of_string_utf8_get_index(const char *, size_t);
 extern size_t of_string_utf8_get_position(const char *, size_t, size_t);
+extern uint32_t of_string_utf8_hash(const char *, size_t, bool);
 #ifdef __cplusplus
 }
 #endif
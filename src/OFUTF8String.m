@@ -172,6 +172,46 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	return idx;
 }
 
+uint32_t
+of_string_utf8_hash(const char *string, size_t length, bool isUTF8)
+{
+	uint32_t hash;
+
+	OF_HASH_INIT(hash);
+
+	if (!isUTF8) {
+		/* ASCII only, so every byte is a character < 0x80. */
+		for (size_t i = 0; i < length; i++) {
+			OF_HASH_ADD(hash, 0);
+			OF_HASH_ADD(hash, 0);
+			OF_HASH_ADD(hash, (unsigned char)string[i]);
+		}
+
+		OF_HASH_FINALIZE(hash);
+
+		return hash;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		of_unichar_t c;
+		ssize_t cLength;
+
+		if ((cLength = of_string_utf8_decode(string + i, length - i,
+		    &c)) <= 0)
+			@throw [OFInvalidEncodingException exception];
+
+		OF_HASH_ADD(hash, (c & 0xFF0000) >> 16);
+		OF_HASH_ADD(hash, (c & 0x00FF00) >> 8);
+		OF_HASH_ADD(hash, c & 0x0000FF);
+
+		i += cLength - 1;
+	}
+
+	OF_HASH_FINALIZE(hash);
+
+	return hash;
+}
+
 @implementation OFUTF8String
 - (instancetype)init
 {
@@ -931,34 +971,14 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 
 - (uint32_t)hash
 {
-	uint32_t hash;
-
 	if (_s->hashed)
 		return _s->hash;
 
-	OF_HASH_INIT(hash);
-
-	for (size_t i = 0; i < _s->cStringLength; i++) {
-		of_unichar_t c;
-		ssize_t length;
-
-		if ((length = of_string_utf8_decode(_s->cString + i,
-		    _s->cStringLength - i, &c)) <= 0)
-			@throw [OFInvalidEncodingException exception];
-
-		OF_HASH_ADD(hash, (c & 0xFF0000) >> 16);
-		OF_HASH_ADD(hash, (c & 0x00FF00) >> 8);
-		OF_HASH_ADD(hash, c & 0x0000FF);
-
-		i += length - 1;
-	}
-
-	OF_HASH_FINALIZE(hash);
-
-	_s->hash = hash;
+	_s->hash = of_string_utf8_hash(_s->cString, _s->cStringLength,
+	    _s->isUTF8);
 	_s->hashed = true;
 
-	return hash;
+	return _s->hash;
 }
 
 - (of_unichar_t)characterAtIndex: (size_t)idx
@@ -129,6 +129,31 @@
 	return self.XMLString;
 }
 
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
+{
+	const char *CDATA = _CDATA.UTF8String;
+	size_t length = _CDATA.UTF8StringLength, last = 0;
+
+	of_xml_writer_append(writer, "<![CDATA[", 9);
+
+	for (size_t i = 0; i + 2 < length; i++) {
+		if (CDATA[i] != ']' || CDATA[i + 1] != ']' ||
+		    CDATA[i + 2] != '>')
+			continue;
+
+		of_xml_writer_append(writer, CDATA + last, i - last);
+		of_xml_writer_append(writer, "]]>]]&gt;<![CDATA[", 18);
+
+		i += 2;
+		last = i + 1;
+	}
+
+	of_xml_writer_append(writer, CDATA + last, length - last);
+	of_xml_writer_append(writer, "]]>", 3);
+}
+
 - (OFString *)description
 {
 	return self.XMLString;
@@ -121,6 +121,13 @@
 	return _characters.stringByXMLEscaping;
 }
 
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
+{
+	of_xml_writer_append_escaped(writer, _characters);
+}
+
 - (OFString *)description
 {
 	return _characters.stringByXMLEscaping;
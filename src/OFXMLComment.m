@@ -134,6 +134,18 @@
 	return ret;
 }
 
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
+{
+	if (indentation > 0 && level > 0)
+		of_xml_writer_append_indentation(writer, level * indentation);
+
+	of_xml_writer_append(writer, "<!--", 4);
+	of_xml_writer_append_string(writer, _comment);
+	of_xml_writer_append(writer, "-->", 3);
+}
+
 - (OFString *)description
 {
 	return [OFString stringWithFormat: @"<!--%@-->", _comment];
@@ -22,14 +22,11 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <assert.h>
-
 #import "OFXMLElement.h"
 #import "OFXMLNode+Private.h"
 #import "OFString.h"
 #import "OFArray.h"
 #import "OFDictionary.h"
-#import "OFData.h"
 #import "OFXMLAttribute.h"
 #import "OFXMLCharacters.h"
 #import "OFXMLCDATA.h"
@@ -425,16 +422,14 @@ static Class CDATAClass = Nil;
 	return ret;
 }
 
-- (OFString *)of_XMLStringWithParent: (OFXMLElement *)parent
-			  namespaces: (OFDictionary *)allNamespaces
-			 indentation: (unsigned int)indentation
-			       level: (unsigned int)level
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		     parent: (OFXMLElement *)parent
+		 namespaces: (OFDictionary *)allNamespaces
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
 {
 	void *pool;
-	char *cString;
-	size_t length, i;
 	OFString *prefix, *parentPrefix;
-	OFString *ret;
 	OFString *defaultNS;
 
 	pool = objc_autoreleasePoolPush();
@@ -443,21 +438,32 @@ static Class CDATAClass = Nil;
 	    (parent != nil && parent->_namespace != nil
 	    ? parent->_namespace : (OFString *)@"")];
 
-	/* Add the namespaces of the current element */
+	/*
+	 * Add the namespaces of the current element. Only copy the namespaces
+	 * of the parent if this actually changes something, which is rarely
+	 * the case.
+	 */
 	if (allNamespaces != nil) {
 		OFEnumerator *keyEnumerator = [_namespaces keyEnumerator];
 		OFEnumerator *objectEnumerator = [_namespaces objectEnumerator];
-		OFMutableDictionary *tmp;
+		OFMutableDictionary *tmp = nil;
 		OFString *key, *object;
 
-		tmp = [[allNamespaces mutableCopy] autorelease];
-
 		while ((key = [keyEnumerator nextObject]) != nil &&
-		    (object = [objectEnumerator nextObject]) != nil)
+		    (object = [objectEnumerator nextObject]) != nil) {
+			if ([[allNamespaces objectForKey: key]
+			    isEqual: object])
+				continue;
+
+			if (tmp == nil)
+				tmp = [[allNamespaces mutableCopy] autorelease];
+
 			[tmp setObject: object
 				forKey: key];
+		}
 
-		allNamespaces = tmp;
+		if (tmp != nil)
+			allNamespaces = tmp;
 	} else
 		allNamespaces = _namespaces;
 
@@ -471,62 +477,31 @@ static Class CDATAClass = Nil;
 	else
 		defaultNS = _defaultNamespace;
 
-	i = 0;
-	length = _name.UTF8StringLength + 3 + (level * indentation);
-	cString = [self allocMemoryWithSize: length];
-
-	memset(cString + i, ' ', level * indentation);
-	i += level * indentation;
+	of_xml_writer_append_indentation(writer, level * indentation);
 
 	/* Start of tag */
-	cString[i++] = '<';
+	of_xml_writer_append(writer, "<", 1);
 
 	if (prefix != nil && ![_namespace isEqual: defaultNS]) {
-		length += prefix.UTF8StringLength + 1;
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		memcpy(cString + i, prefix.UTF8String, prefix.UTF8StringLength);
-		i += prefix.UTF8StringLength;
-		cString[i++] = ':';
+		of_xml_writer_append_string(writer, prefix);
+		of_xml_writer_append(writer, ":", 1);
 	}
 
-	memcpy(cString + i, _name.UTF8String, _name.UTF8StringLength);
-	i += _name.UTF8StringLength;
+	of_xml_writer_append_string(writer, _name);
 
 	/* xmlns if necessary */
 	if (prefix == nil && ((_namespace != nil &&
 	    ![_namespace isEqual: defaultNS]) ||
 	    (_namespace == nil && defaultNS != nil))) {
-		length += _namespace.UTF8StringLength + 9;
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		memcpy(cString + i, " xmlns='", 8);
-		i += 8;
-		memcpy(cString + i, _namespace.UTF8String,
-		    _namespace.UTF8StringLength);
-		i += _namespace.UTF8StringLength;
-		cString[i++] = '\'';
+		of_xml_writer_append(writer, " xmlns='", 8);
+		if (_namespace != nil)
+			of_xml_writer_append_string(writer, _namespace);
+		of_xml_writer_append(writer, "'", 1);
 	}
 
 	/* Attributes */
 	for (OFXMLAttribute *attribute in _attributes) {
-		void *pool2 = objc_autoreleasePoolPush();
-		const char *attributeNameCString = attribute->_name.UTF8String;
-		size_t attributeNameLength = attribute->_name.UTF8StringLength;
 		OFString *attributePrefix = nil;
-		OFString *tmp = attribute.stringValue.stringByXMLEscaping;
 		char delimiter = (attribute->_useDoubleQuotes ? '"' : '\'');
 
 		if (attribute->_namespace != nil &&
@@ -536,39 +511,20 @@ static Class CDATAClass = Nil;
 			    exceptionWithNamespace: [attribute namespace]
 					   element: self];
 
-		length += attributeNameLength + (attributePrefix != nil
-		    ? attributePrefix.UTF8StringLength + 1 : 0) +
-		    tmp.UTF8StringLength + 4;
-
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		cString[i++] = ' ';
+		of_xml_writer_append(writer, " ", 1);
 		if (attributePrefix != nil) {
-			memcpy(cString + i, attributePrefix.UTF8String,
-			    attributePrefix.UTF8StringLength);
-			i += attributePrefix.UTF8StringLength;
-			cString[i++] = ':';
+			of_xml_writer_append_string(writer, attributePrefix);
+			of_xml_writer_append(writer, ":", 1);
 		}
-		memcpy(cString + i, attributeNameCString, attributeNameLength);
-		i += attributeNameLength;
-		cString[i++] = '=';
-		cString[i++] = delimiter;
-		memcpy(cString + i, tmp.UTF8String, tmp.UTF8StringLength);
-		i += tmp.UTF8StringLength;
-		cString[i++] = delimiter;
-
-		objc_autoreleasePoolPop(pool2);
+		of_xml_writer_append_string(writer, attribute->_name);
+		of_xml_writer_append(writer, "=", 1);
+		of_xml_writer_append(writer, &delimiter, 1);
+		of_xml_writer_append_escaped(writer, attribute->_stringValue);
+		of_xml_writer_append(writer, &delimiter, 1);
 	}
 
 	/* Children */
 	if (_children != nil) {
-		OFMutableData *tmp = [OFMutableData data];
 		bool indent;
 
 		if (indentation > 0) {
@@ -584,110 +540,75 @@ static Class CDATAClass = Nil;
 		} else
 			indent = false;
 
+		of_xml_writer_append(writer, ">", 1);
+
 		for (OFXMLNode *child in _children) {
-			OFString *childString;
 			unsigned int ind = (indent ? indentation : 0);
 
 			if (ind)
-				[tmp addItem: "\n"];
+				of_xml_writer_append(writer, "\n", 1);
 
 			if ([child isKindOfClass: [OFXMLElement class]])
-				childString = [(OFXMLElement *)child
-				    of_XMLStringWithParent: self
-						namespaces: allNamespaces
+				[(OFXMLElement *)child
+				    of_writeXMLToWriter: writer
+						 parent: self
+					     namespaces: allNamespaces
+					    indentation: ind
+						  level: level + 1];
+			else
+				[child of_writeXMLToWriter: writer
 					       indentation: ind
 						     level: level + 1];
-			else
-				childString = [child
-				    XMLStringWithIndentation: ind
-						       level: level + 1];
-
-			[tmp addItems: childString.UTF8String
-				count: childString.UTF8StringLength];
 		}
 
-		if (indent)
-			[tmp addItem: "\n"];
-
-		length += tmp.count + _name.UTF8StringLength + 2 +
-		    (indent ? level * indentation : 0);
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		cString[i++] = '>';
-
-		memcpy(cString + i, tmp.items, tmp.count);
-		i += tmp.count;
-
 		if (indent) {
-			memset(cString + i, ' ', level * indentation);
-			i += level * indentation;
+			of_xml_writer_append(writer, "\n", 1);
+			of_xml_writer_append_indentation(writer,
+			    level * indentation);
 		}
 
-		cString[i++] = '<';
-		cString[i++] = '/';
+		of_xml_writer_append(writer, "</", 2);
 		if (prefix != nil) {
-			length += prefix.UTF8StringLength + 1;
-			@try {
-				cString = [self resizeMemory: cString
-							size: length];
-			} @catch (id e) {
-				[self freeMemory: cString];
-				@throw e;
-			}
-
-			memcpy(cString + i, prefix.UTF8String,
-			    prefix.UTF8StringLength);
-			i += prefix.UTF8StringLength;
-			cString[i++] = ':';
+			of_xml_writer_append_string(writer, prefix);
+			of_xml_writer_append(writer, ":", 1);
 		}
-		memcpy(cString + i, _name.UTF8String, _name.UTF8StringLength);
-		i += _name.UTF8StringLength;
+		of_xml_writer_append_string(writer, _name);
 	} else
-		cString[i++] = '/';
+		of_xml_writer_append(writer, "/", 1);
 
-	cString[i++] = '>';
-	assert(i == length);
+	of_xml_writer_append(writer, ">", 1);
 
 	objc_autoreleasePoolPop(pool);
+}
 
-	@try {
-		ret = [OFString stringWithUTF8String: cString
-					      length: length];
-	} @finally {
-		[self freeMemory: cString];
-	}
-	return ret;
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
+{
+	[self of_writeXMLToWriter: writer
+			   parent: nil
+		       namespaces: nil
+		      indentation: indentation
+			    level: level];
 }
 
 - (OFString *)XMLString
 {
-	return [self of_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: 0
-				      level: 0];
+	return [self of_XMLStringWithIndentation: 0
+					   level: 0];
 }
 
 - (OFString *)XMLStringWithIndentation: (unsigned int)indentation
 {
-	return [self of_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: indentation
-				      level: 0];
+	return [self of_XMLStringWithIndentation: indentation
+					   level: 0];
 }
 
 - (OFString *)XMLStringWithIndentation: (unsigned int)indentation
 				 level: (unsigned int)level
 {
-	return [self of_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: indentation
-				      level: level];
+	return [self of_XMLStringWithIndentation: indentation
+					   level: level];
 }
 
 - (OFXMLElement *)XMLElementBySerializing
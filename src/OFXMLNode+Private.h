@@ -19,8 +19,50 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFStream;
+
+/*
+ * Collects the XML representation of a tree of nodes. If stream is set, the
+ * buffer has a fixed size and is written to the stream whenever it is full,
+ * otherwise it grows until the complete representation is in it.
+ */
+struct of_xml_writer {
+	OFStream *_Nullable stream;
+	char *_Nullable buffer;
+	size_t length, capacity;
+};
+
 @interface OFXMLNode ()
 - (instancetype)of_init OF_METHOD_FAMILY(init);
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level;
+- (OFString *)of_XMLStringWithIndentation: (unsigned int)indentation
+				    level: (unsigned int)level;
 @end
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern void of_xml_writer_append(struct of_xml_writer *writer,
+    const char *string, size_t length);
+extern void of_xml_writer_append_string(struct of_xml_writer *writer,
+    OFString *string);
+extern void of_xml_writer_append_escaped(struct of_xml_writer *writer,
+    OFString *string);
+extern void of_xml_writer_append_indentation(struct of_xml_writer *writer,
+    size_t count);
+extern void of_xml_writer_flush(struct of_xml_writer *writer);
+/*
+ * Calls append with the runs of characters that need no escaping and with the
+ * replacement of every character that does. Implemented in
+ * OFString+XMLEscaping.m, which uses it for -[OFString stringByXMLEscaping].
+ */
+extern void of_xml_escape(const char *string, size_t length,
+    void (*append)(void *context, const char *string, size_t length),
+    void *context);
+#ifdef __cplusplus
+}
+#endif
+
 OF_ASSUME_NONNULL_END
@@ -20,6 +20,7 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFStream;
 @class OFXMLElement;
 
 /*!
@@ -85,6 +86,19 @@ OF_ASSUME_NONNULL_BEGIN
  */
 - (OFString *)XMLStringWithIndentation: (unsigned int)indentation
 				 level: (unsigned int)level;
+
+/*!
+ * @brief Writes the OFXMLNode as an XML string with indentation to the
+ *	  specified stream.
+ *
+ * The node is walked only once and everything is written to the stream
+ * through a small buffer, so no string for the complete node is created.
+ *
+ * @param stream The stream to write the XML string to
+ * @param indentation The indentation for the XML string
+ */
+- (void)writeXMLToStream: (OFStream *)stream
+	     indentation: (unsigned int)indentation;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -17,9 +17,117 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #import "OFXMLNode.h"
+#import "OFXMLNode+Private.h"
+#import "OFStream.h"
 #import "OFString.h"
 
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+
+#define STREAM_BUFFER_SIZE 4096
+
+void
+of_xml_writer_flush(struct of_xml_writer *writer)
+{
+	if (writer->stream == nil || writer->length == 0)
+		return;
+
+	[writer->stream writeBuffer: writer->buffer
+			     length: writer->length];
+	writer->length = 0;
+}
+
+static void
+makeRoom(struct of_xml_writer *writer, size_t length)
+{
+	size_t capacity;
+	char *buffer;
+
+	if (writer->capacity - writer->length >= length)
+		return;
+
+	if (writer->stream != nil)
+		capacity = STREAM_BUFFER_SIZE;
+	else {
+		if (SIZE_MAX - writer->length < length)
+			@throw [OFOutOfRangeException exception];
+
+		capacity = writer->length + length;
+		if (capacity < 256)
+			capacity = 256;
+		if (capacity < writer->capacity * 2 &&
+		    writer->capacity <= SIZE_MAX / 2)
+			capacity = writer->capacity * 2;
+	}
+
+	if ((buffer = realloc(writer->buffer, capacity)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: capacity];
+
+	writer->buffer = buffer;
+	writer->capacity = capacity;
+}
+
+void
+of_xml_writer_append(struct of_xml_writer *writer, const char *string,
+    size_t length)
+{
+	if (writer->stream != nil) {
+		if (writer->capacity - writer->length < length)
+			of_xml_writer_flush(writer);
+
+		/* Don't copy what does not fit into the buffer anyway. */
+		if (length >= STREAM_BUFFER_SIZE) {
+			[writer->stream writeBuffer: string
+					     length: length];
+			return;
+		}
+	}
+
+	makeRoom(writer, length);
+
+	memcpy(writer->buffer + writer->length, string, length);
+	writer->length += length;
+}
+
+void
+of_xml_writer_append_string(struct of_xml_writer *writer, OFString *string)
+{
+	of_xml_writer_append(writer, string.UTF8String,
+	    string.UTF8StringLength);
+}
+
+static void
+appendToWriter(void *writer, const char *string, size_t length)
+{
+	of_xml_writer_append(writer, string, length);
+}
+
+void
+of_xml_writer_append_escaped(struct of_xml_writer *writer, OFString *string)
+{
+	of_xml_escape(string.UTF8String, string.UTF8StringLength,
+	    appendToWriter, writer);
+}
+
+void
+of_xml_writer_append_indentation(struct of_xml_writer *writer, size_t count)
+{
+	static const char spaces[] = "                                ";
+
+	while (count > 0) {
+		size_t length = (count < sizeof(spaces) - 1
+		    ? count : sizeof(spaces) - 1);
+
+		of_xml_writer_append(writer, spaces, length);
+		count -= length;
+	}
+}
+
 @implementation OFXMLNode
 - (instancetype)of_init
 {
@@ -84,6 +192,54 @@
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	of_xml_writer_append_string(writer,
+	    [self XMLStringWithIndentation: indentation
+				     level: level]);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFString *)of_XMLStringWithIndentation: (unsigned int)indentation
+				    level: (unsigned int)level
+{
+	struct of_xml_writer writer = { nil, NULL, 0, 0 };
+
+	@try {
+		[self of_writeXMLToWriter: &writer
+			      indentation: indentation
+				    level: level];
+		of_xml_writer_append(&writer, "", 1);
+	} @catch (id e) {
+		free(writer.buffer);
+		@throw e;
+	}
+
+	return [OFString stringWithUTF8StringNoCopy: writer.buffer
+					     length: writer.length - 1
+				       freeWhenDone: true];
+}
+
+- (void)writeXMLToStream: (OFStream *)stream
+	     indentation: (unsigned int)indentation
+{
+	struct of_xml_writer writer = { stream, NULL, 0, 0 };
+
+	@try {
+		[self of_writeXMLToWriter: &writer
+			      indentation: indentation
+				    level: 0];
+		of_xml_writer_flush(&writer);
+	} @finally {
+		free(writer.buffer);
+	}
+}
+
 - (OFString *)description
 {
 	return [self XMLStringWithIndentation: 2];
@@ -84,27 +84,70 @@ appendToBuffer(OFMutableData *buffer, const char *string,
 	}
 }
 
+/*
+ * Counts the lines in the specified run of characters the same way the
+ * per-character loop in -[parseBuffer:length:] does, treating \r\n as a
+ * single line break.
+ */
+static void
+countLines(const char *run, size_t length, size_t *lineNumber,
+    bool *lastCarriageReturn)
+{
+	const char *end = run + length;
+	const char *tmp;
+
+	if (length == 0)
+		return;
+
+	for (tmp = run; (tmp = memchr(tmp, '\r', end - tmp)) != NULL; tmp++)
+		(*lineNumber)++;
+
+	for (tmp = run; (tmp = memchr(tmp, '\n', end - tmp)) != NULL; tmp++)
+		if (tmp > run ? tmp[-1] != '\r' : !*lastCarriageReturn)
+			(*lineNumber)++;
+
+	*lastCarriageReturn = (end[-1] == '\r');
+}
+
 static OFString *
 transformString(OFXMLParser *parser, OFMutableData *buffer, size_t cut,
     bool unescape)
 {
 	char *items = buffer.mutableItems;
 	size_t length = buffer.count - cut;
-	bool hasEntities = false;
+	bool hasEntities = (length > 0 && memchr(items, '&', length) != NULL);
+	char *read, *write, *end;
 	OFString *ret;
 
-	for (size_t i = 0; i < length; i++) {
-		if (items[i] == '\r') {
-			if (i + 1 < length && items[i + 1] == '\n') {
-				[buffer removeItemAtIndex: i];
-				items = buffer.mutableItems;
-
-				i--;
-				length--;
-			} else
-				items[i] = '\n';
-		} else if (items[i] == '&')
-			hasEntities = true;
+	/*
+	 * Normalize \r\n and \r to \n by compacting the buffer in place, moving
+	 * everything between two \r as a whole. The buffer is emptied by the
+	 * caller afterwards, so the count does not need to be adjusted.
+	 */
+	if (length > 0 && (read = memchr(items, '\r', length)) != NULL) {
+		write = read;
+		end = items + length;
+
+		while (read < end) {
+			char *next;
+
+			/* read points to \r */
+			if (read + 1 < end && read[1] == '\n')
+				read++;
+			else {
+				*write++ = '\n';
+				read++;
+			}
+
+			if ((next = memchr(read, '\r', end - read)) == NULL)
+				next = end;
+
+			memmove(write, read, next - read);
+			write += next - read;
+			read = next;
+		}
+
+		length = write - items;
 	}
 
 	ret = [OFString stringWithUTF8String: items
@@ -259,7 +302,54 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	_data = buffer;
 
 	for (_i = _last = 0; _i < length; _i++) {
-		size_t j = _i;
+		size_t j;
+		char delimiter = 0;
+
+		/*
+		 * In states where all characters up to a certain delimiter are
+		 * only collected, skip to the delimiter directly instead of
+		 * dispatching for every character. _last is not touched, so
+		 * the skipped characters are appended to _buffer as a whole.
+		 */
+		switch (_state) {
+		case OF_XMLPARSER_OUTSIDE_TAG:
+			/* Otherwise, only whitespace is allowed */
+			if (!_finishedParsing && _previous.count > 0)
+				delimiter = '<';
+			break;
+		case OF_XMLPARSER_IN_ATTRIBUTE_VALUE:
+			delimiter = _delimiter;
+			break;
+		case OF_XMLPARSER_IN_PROCESSING_INSTRUCTIONS:
+			if (_level == 0)
+				delimiter = '?';
+			break;
+		case OF_XMLPARSER_IN_CDATA:
+			if (_level == 0)
+				delimiter = ']';
+			break;
+		case OF_XMLPARSER_IN_COMMENT_1:
+			if (_level == 0)
+				delimiter = '-';
+			break;
+		default:
+			break;
+		}
+
+		if (delimiter != 0) {
+			const char *found = memchr(_data + _i, delimiter,
+			    length - _i);
+			size_t end = (found != NULL
+			    ? (size_t)(found - _data) : length);
+
+			countLines(_data + _i, end - _i, &_lineNumber,
+			    &_lastCarriageReturn);
+
+			if ((_i = end) == length)
+				break;
+		}
+
+		j = _i;
 
 		lookupTable[_state](self, selectors[_state]);
 
@@ -135,6 +135,18 @@
 	return ret;
 }
 
+- (void)of_writeXMLToWriter: (struct of_xml_writer *)writer
+		indentation: (unsigned int)indentation
+		      level: (unsigned int)level
+{
+	if (indentation > 0 && level > 0)
+		of_xml_writer_append_indentation(writer, level * indentation);
+
+	of_xml_writer_append(writer, "<?", 2);
+	of_xml_writer_append_string(writer, _processingInstructions);
+	of_xml_writer_append(writer, "?>", 2);
+}
+
 - (OFString *)description
 {
 	return [OFString stringWithFormat: @"<?%@?>", _processingInstructions];
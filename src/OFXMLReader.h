@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFString.h"
+#import "OFXMLParser.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMutableArray OF_GENERIC(ObjectType);
+@class OFStream;
+@class OFXMLReaderEvent;
+
+/*!
+ * @brief The type of an event returned by OFXMLReader.
+ */
+typedef enum {
+	/*! The end of the document was reached */
+	OF_XML_READER_EVENT_END_OF_DOCUMENT,
+	/*! The start of an element */
+	OF_XML_READER_EVENT_START_ELEMENT,
+	/*! The end of an element */
+	OF_XML_READER_EVENT_END_ELEMENT,
+	/*! Characters */
+	OF_XML_READER_EVENT_CHARACTERS,
+	/*! CDATA */
+	OF_XML_READER_EVENT_CDATA,
+	/*! A comment */
+	OF_XML_READER_EVENT_COMMENT,
+	/*! Processing instructions */
+	OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS
+} of_xml_reader_event_t;
+
+/*!
+ * @class OFXMLReader OFXMLReader.h ObjFW/OFXMLReader.h
+ *
+ * @brief A pull-style XML reader.
+ *
+ * OFXMLReader reads an XML document from a stream in small chunks and returns
+ * one event at a time, which makes it possible to iterate over huge documents
+ * with bounded memory. It uses OFXMLParser internally, so it accepts exactly
+ * the same documents.
+ *
+ * Everything that is needed about the current event is available as
+ * properties of the reader, so no OFXMLElement or other node objects are
+ * created. The events of a chunk are queued in records that are reused for the
+ * next chunk, so after the first chunks, only the strings and OFXMLAttribute
+ * objects created by the parser are allocated.
+ */
+@interface OFXMLReader: OFObject <OFXMLParserDelegate>
+{
+	OFStream *_stream;
+	OFXMLParser *_parser;
+	char *_buffer;
+	OFMutableArray OF_GENERIC(OFXMLReaderEvent *) *_events;
+	size_t _eventsCount, _eventsIndex;
+	OFXMLReaderEvent *_Nullable _currentEvent;
+	size_t _depth, _skipDepth;
+	bool _skipping;
+}
+
+/*!
+ * @brief The stream the reader reads from.
+ */
+@property (readonly, nonatomic) OFStream *stream;
+
+/*!
+ * @brief The depth limit for the underlying XML parser.
+ *
+ * See @ref OFXMLParser::depthLimit.
+ */
+@property (nonatomic) size_t depthLimit;
+
+/*!
+ * @brief The type of the current event.
+ */
+@property (readonly, nonatomic) of_xml_reader_event_t eventType;
+
+/*!
+ * @brief The name of the current element.
+ *
+ * This is only set for `OF_XML_READER_EVENT_START_ELEMENT` and
+ * `OF_XML_READER_EVENT_END_ELEMENT`.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFString *name;
+
+/*!
+ * @brief The prefix of the current element.
+ *
+ * This is only set for `OF_XML_READER_EVENT_START_ELEMENT` and
+ * `OF_XML_READER_EVENT_END_ELEMENT`.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFString *prefix;
+
+/*!
+ * @brief The namespace of the current element.
+ *
+ * This is only set for `OF_XML_READER_EVENT_START_ELEMENT` and
+ * `OF_XML_READER_EVENT_END_ELEMENT`.
+ */
+#ifndef __cplusplus
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFString *namespace;
+#else
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic, getter=namespace)
+    OFString *namespace_;
+#endif
+
+/*!
+ * @brief The string value of the current event.
+ *
+ * This is set for characters, CDATA, comments and processing instructions.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFString *stringValue;
+
+/*!
+ * @brief The depth of the current element, 1 being the root element.
+ *
+ * For events other than the start and end of an element, this is the depth of
+ * the element they are in.
+ */
+@property (readonly, nonatomic) size_t depth;
+
+/*!
+ * @brief The number of attributes of the current element.
+ */
+@property (readonly, nonatomic) size_t attributesCount;
+
+/*!
+ * @brief Creates a new OFXMLReader that reads from the specified stream.
+ *
+ * @param stream The stream to read the XML document from
+ * @return A new, autoreleased OFXMLReader
+ */
++ (instancetype)readerWithStream: (OFStream *)stream;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated OFXMLReader to read from the
+ *	  specified stream.
+ *
+ * @param stream The stream to read the XML document from
+ * @return An initialized OFXMLReader
+ */
+- (instancetype)initWithStream: (OFStream *)stream OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Advances to the next event and returns its type.
+ *
+ * @return The type of the next event
+ * @throw OFMalformedXMLException The document is malformed or the stream ended
+ *				  before the document was complete
+ */
+- (of_xml_reader_event_t)nextEvent;
+
+/*!
+ * @brief Skips the element that has just started, including all of its
+ *	  children.
+ *
+ * After this, the current event is the end of the skipped element. Nothing is
+ * queued for the skipped children, but the parser still needs to parse them
+ * completely, including creating their strings and attributes, so this only
+ * saves the cost of queueing them compared to calling @ref nextEvent until
+ * the end of the element is reached.
+ *
+ * @throw OFInvalidArgumentException The current event is not the start of an
+ *				     element
+ */
+- (void)skipCurrentElement;
+
+/*!
+ * @brief Returns the name of the attribute of the current element at the
+ *	  specified index.
+ *
+ * @param index The index of the attribute
+ * @return The name of the attribute
+ */
+- (OFString *)attributeNameAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the namespace of the attribute of the current element at the
+ *	  specified index.
+ *
+ * @param index The index of the attribute
+ * @return The namespace of the attribute or `nil`
+ */
+- (nullable OFString *)attributeNamespaceAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the value of the attribute of the current element at the
+ *	  specified index.
+ *
+ * @param index The index of the attribute
+ * @return The value of the attribute
+ */
+- (OFString *)attributeValueAtIndex: (size_t)index;
+
+/*!
+ * @brief Returns the value of the attribute of the current element with the
+ *	  specified name and namespace.
+ *
+ * @param name The name of the attribute
+ * @param ns The namespace of the attribute or `nil`
+ * @return The value of the attribute or `nil` if the current element has no
+ *	   such attribute
+ */
+- (nullable OFString *)attributeValueForName: (OFString *)name
+				   namespace: (nullable OFString *)ns;
+@end
+
+OF_ASSUME_NONNULL_END
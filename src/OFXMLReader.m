@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFXMLReader.h"
+#import "OFArray.h"
+#import "OFStream.h"
+#import "OFXMLAttribute.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFMalformedXMLException.h"
+#import "OFOutOfRangeException.h"
+
+/*
+ * Small enough to keep the number of queued events low, large enough to not
+ * call into the stream for every few bytes.
+ */
+#define BUFFER_SIZE 4096
+
+@interface OFXMLReaderEvent: OFObject
+{
+@public
+	of_xml_reader_event_t _type;
+	OFString *_name, *_prefix, *_namespace, *_stringValue;
+	OFMutableArray OF_GENERIC(OFXMLAttribute *) *_attributes;
+	size_t _depth;
+}
+
+- (void)of_reset;
+@end
+
+@interface OFXMLReader ()
+- (void)of_addEventOfType: (of_xml_reader_event_t)type
+		     name: (OFString *)name
+		   prefix: (OFString *)prefix
+		namespace: (OFString *)namespace
+	      stringValue: (OFString *)stringValue
+	       attributes: (OFArray *)attributes;
+- (bool)of_parseChunk;
+@end
+
+@implementation OFXMLReaderEvent
+- (void)of_reset
+{
+	[_name release];
+	[_prefix release];
+	[_namespace release];
+	[_stringValue release];
+	_name = _prefix = _namespace = _stringValue = nil;
+
+	[_attributes removeAllObjects];
+}
+
+- (void)dealloc
+{
+	[_name release];
+	[_prefix release];
+	[_namespace release];
+	[_stringValue release];
+	[_attributes release];
+
+	[super dealloc];
+}
+@end
+
+@implementation OFXMLReader
+@synthesize stream = _stream;
+
++ (instancetype)readerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [super init];
+
+	@try {
+		_stream = [stream retain];
+		_parser = [[OFXMLParser alloc] init];
+		_parser.delegate = self;
+		_buffer = [self allocMemoryWithSize: BUFFER_SIZE];
+		_events = [[OFMutableArray alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_stream release];
+	[_parser release];
+	[_events release];
+	[_currentEvent release];
+
+	[super dealloc];
+}
+
+- (size_t)depthLimit
+{
+	return _parser.depthLimit;
+}
+
+- (void)setDepthLimit: (size_t)depthLimit
+{
+	_parser.depthLimit = depthLimit;
+}
+
+- (of_xml_reader_event_t)eventType
+{
+	if (_currentEvent == nil)
+		return OF_XML_READER_EVENT_END_OF_DOCUMENT;
+
+	return _currentEvent->_type;
+}
+
+- (OFString *)name
+{
+	if (_currentEvent == nil)
+		return nil;
+
+	return _currentEvent->_name;
+}
+
+- (OFString *)prefix
+{
+	if (_currentEvent == nil)
+		return nil;
+
+	return _currentEvent->_prefix;
+}
+
+- (OFString *)namespace
+{
+	if (_currentEvent == nil)
+		return nil;
+
+	return _currentEvent->_namespace;
+}
+
+- (OFString *)stringValue
+{
+	if (_currentEvent == nil)
+		return nil;
+
+	return _currentEvent->_stringValue;
+}
+
+- (size_t)depth
+{
+	if (_currentEvent == nil)
+		return 0;
+
+	return _currentEvent->_depth;
+}
+
+- (size_t)attributesCount
+{
+	if (_currentEvent == nil)
+		return 0;
+
+	return _currentEvent->_attributes.count;
+}
+
+- (OFString *)attributeNameAtIndex: (size_t)idx
+{
+	if (_currentEvent == nil || idx >= _currentEvent->_attributes.count)
+		@throw [OFOutOfRangeException exception];
+
+	return [_currentEvent->_attributes objectAtIndex: idx].name;
+}
+
+- (OFString *)attributeNamespaceAtIndex: (size_t)idx
+{
+	if (_currentEvent == nil || idx >= _currentEvent->_attributes.count)
+		@throw [OFOutOfRangeException exception];
+
+	return [_currentEvent->_attributes objectAtIndex: idx].namespace;
+}
+
+- (OFString *)attributeValueAtIndex: (size_t)idx
+{
+	if (_currentEvent == nil || idx >= _currentEvent->_attributes.count)
+		@throw [OFOutOfRangeException exception];
+
+	return [_currentEvent->_attributes objectAtIndex: idx].stringValue;
+}
+
+- (OFString *)attributeValueForName: (OFString *)name
+			  namespace: (OFString *)namespace
+{
+	if (_currentEvent == nil)
+		return nil;
+
+	for (OFXMLAttribute *attribute in _currentEvent->_attributes) {
+		OFString *attributeNamespace = attribute.namespace;
+
+		if (![attribute.name isEqual: name])
+			continue;
+
+		if (attributeNamespace == namespace ||
+		    [attributeNamespace isEqual: namespace])
+			return attribute.stringValue;
+	}
+
+	return nil;
+}
+
+- (void)of_addEventOfType: (of_xml_reader_event_t)type
+		     name: (OFString *)name
+		   prefix: (OFString *)prefix
+		namespace: (OFString *)namespace
+	      stringValue: (OFString *)stringValue
+	       attributes: (OFArray *)attributes
+{
+	OFXMLReaderEvent *event;
+
+	/*
+	 * The events of the previous chunk are done with, so they are reused
+	 * instead of creating new ones.
+	 */
+	if (_eventsCount < _events.count) {
+		event = [_events objectAtIndex: _eventsCount];
+		[event of_reset];
+	} else {
+		event = [[OFXMLReaderEvent alloc] init];
+
+		@try {
+			[_events addObject: event];
+		} @finally {
+			[event release];
+		}
+	}
+
+	event->_type = type;
+	event->_name = [name copy];
+	event->_prefix = [prefix copy];
+	event->_namespace = [namespace copy];
+	event->_stringValue = [stringValue copy];
+	event->_depth = _depth;
+
+	/* The parser reuses its array, so the attributes are added to ours. */
+	if (attributes.count > 0) {
+		if (event->_attributes == nil)
+			event->_attributes = [[OFMutableArray alloc] init];
+
+		[event->_attributes addObjectsFromArray: attributes];
+	}
+
+	_eventsCount++;
+}
+
+- (bool)of_parseChunk
+{
+	size_t length;
+
+	if (_stream.atEndOfStream) {
+		if (!_parser.hasFinishedParsing)
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: _parser];
+
+		return false;
+	}
+
+	length = [_stream readIntoBuffer: _buffer
+				  length: BUFFER_SIZE];
+	[_parser parseBuffer: _buffer
+		      length: length];
+
+	return true;
+}
+
+- (of_xml_reader_event_t)nextEvent
+{
+	[_currentEvent release];
+	_currentEvent = nil;
+
+	while (_eventsIndex >= _eventsCount) {
+		_eventsIndex = _eventsCount = 0;
+
+		if (![self of_parseChunk])
+			return OF_XML_READER_EVENT_END_OF_DOCUMENT;
+	}
+
+	_currentEvent = [[_events objectAtIndex: _eventsIndex++] retain];
+
+	return _currentEvent->_type;
+}
+
+- (void)skipCurrentElement
+{
+	size_t depth;
+
+	if (_currentEvent == nil ||
+	    _currentEvent->_type != OF_XML_READER_EVENT_START_ELEMENT)
+		@throw [OFInvalidArgumentException exception];
+
+	depth = _currentEvent->_depth;
+
+	/* The end of the element might already be queued. */
+	while (_eventsIndex < _eventsCount) {
+		OFXMLReaderEvent *event =
+		    [_events objectAtIndex: _eventsIndex++];
+
+		if (event->_type == OF_XML_READER_EVENT_END_ELEMENT &&
+		    event->_depth == depth) {
+			[_currentEvent release];
+			_currentEvent = [event retain];
+			return;
+		}
+	}
+
+	_eventsIndex = _eventsCount = 0;
+
+	/*
+	 * Otherwise, let the parser run without queueing anything until the
+	 * element ends, at which point its end is queued as usual.
+	 */
+	_skipping = true;
+	_skipDepth = depth;
+
+	@try {
+		while (_skipping)
+			if (![self of_parseChunk])
+				@throw [OFMalformedXMLException
+				    exceptionWithParser: _parser];
+	} @finally {
+		_skipping = false;
+	}
+
+	[self nextEvent];
+}
+
+-		 (void)parser: (OFXMLParser *)parser
+  foundProcessingInstructions: (OFString *)processingInstructions
+{
+	if (_skipping)
+		return;
+
+	[self of_addEventOfType: OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS
+			   name: nil
+			 prefix: nil
+		      namespace: nil
+		    stringValue: processingInstructions
+		     attributes: nil];
+}
+
+-    (void)parser: (OFXMLParser *)parser
+  didStartElement: (OFString *)name
+	   prefix: (OFString *)prefix
+	namespace: (OFString *)namespace
+       attributes: (OFArray *)attributes
+{
+	_depth++;
+
+	if (_skipping)
+		return;
+
+	[self of_addEventOfType: OF_XML_READER_EVENT_START_ELEMENT
+			   name: name
+			 prefix: prefix
+		      namespace: namespace
+		    stringValue: nil
+		     attributes: attributes];
+}
+
+-  (void)parser: (OFXMLParser *)parser
+  didEndElement: (OFString *)name
+	 prefix: (OFString *)prefix
+      namespace: (OFString *)namespace
+{
+	if (_skipping && _depth == _skipDepth)
+		_skipping = false;
+
+	if (!_skipping)
+		[self of_addEventOfType: OF_XML_READER_EVENT_END_ELEMENT
+				   name: name
+				 prefix: prefix
+			      namespace: namespace
+			    stringValue: nil
+			     attributes: nil];
+
+	_depth--;
+}
+
+-    (void)parser: (OFXMLParser *)parser
+  foundCharacters: (OFString *)characters
+{
+	if (_skipping)
+		return;
+
+	[self of_addEventOfType: OF_XML_READER_EVENT_CHARACTERS
+			   name: nil
+			 prefix: nil
+		      namespace: nil
+		    stringValue: characters
+		     attributes: nil];
+}
+
+- (void)parser: (OFXMLParser *)parser
+    foundCDATA: (OFString *)CDATA
+{
+	if (_skipping)
+		return;
+
+	[self of_addEventOfType: OF_XML_READER_EVENT_CDATA
+			   name: nil
+			 prefix: nil
+		      namespace: nil
+		    stringValue: CDATA
+		     attributes: nil];
+}
+
+- (void)parser: (OFXMLParser *)parser
+  foundComment: (OFString *)comment
+{
+	if (_skipping)
+		return;
+
+	[self of_addEventOfType: OF_XML_READER_EVENT_COMMENT
+			   name: nil
+			 prefix: nil
+		      namespace: nil
+		    stringValue: comment
+		     attributes: nil];
+}
+@end
@@ -58,6 +58,7 @@
 #import "OFInflateStream.h"
 #import "OFInflate64Stream.h"
 #import "OFGZIPStream.h"
+#import "OFBase64EncodingStream.h"
 #import "OFLHAArchive.h"
 #import "OFLHAArchiveEntry.h"
 #import "OFTarArchive.h"
@@ -114,8 +115,11 @@
 #import "OFXMLProcessingInstructions.h"
 #import "OFXMLParser.h"
 #import "OFXMLElementBuilder.h"
+#import "OFXMLReader.h"
 
 #import "OFMessagePackExtension.h"
+#import "OFMessagePackReader.h"
+#import "OFMessagePackWriter.h"
 
 #import "OFApplication.h"
 #import "OFSystemInfo.h"
@@ -33,9 +33,18 @@ OF_ASSUME_NONNULL_BEGIN
 extern "C" {
 #endif
 extern OFString *of_base64_encode(const void *, size_t);
+extern size_t of_base64_encode_buffer(char *, const void *, size_t);
 extern bool of_base64_decode(OFMutableData *, const char *, size_t);
+extern size_t of_base64_decoded_length(const char *, size_t);
+extern bool of_base64_decode_buffer(void *, const char *, size_t);
 #ifdef __cplusplus
 }
 #endif
 
+static OF_INLINE size_t
+of_base64_encoded_length(size_t length)
+{
+	return (length + 2) / 3 * 4;
+}
+
 OF_ASSUME_NONNULL_END
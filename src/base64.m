@@ -17,9 +17,23 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+
 #import "OFString.h"
 #import "OFData.h"
+#import "OFSystemInfo.h"
 #import "base64.h"
+#import "once.h"
+
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+
+#if (defined(OF_X86_64) || defined(OF_X86)) && \
+    (defined(__clang__) || OF_GCC_VERSION >= 409)
+# define HAVE_BASE64_SIMD
+# include <cpuid.h>
+# include <immintrin.h>
+#endif
 
 const uint8_t of_base64_encode_table[64] = {
 	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N',
@@ -40,119 +54,420 @@ const int8_t of_base64_decode_table[128] = {
 	48, 49, 50, 51, -1, -1, -1, -1, -1
 };
 
-OFString *
-of_base64_encode(const void *data, size_t length)
+typedef size_t (*encode_function)(char *, const uint8_t *, size_t);
+typedef size_t (*decode_function)(uint8_t *, const uint8_t *, size_t);
+
+#ifdef HAVE_BASE64_SIMD
+/*
+ * The vectorized code follows the approach by Wojciech Muła and Daniel Lemire:
+ * The 6 bit groups are moved into separate bytes with shuffles and
+ * multiplications and then translated into ASCII (or back) by looking up an
+ * offset with pshufb.
+ */
+static __attribute__((__target__("ssse3"))) __m128i
+encodeReshuffleSSSE3(__m128i input)
 {
-	OFMutableString *ret = [OFMutableString string];
-	uint8_t *buffer = (uint8_t *)data;
-	size_t i;
-	uint8_t rest;
-	char tb[4];
-	uint32_t sb;
+	__m128i t0, t1, t2, t3;
+
+	input = _mm_shuffle_epi8(input, _mm_set_epi8(
+	    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+	t0 = _mm_and_si128(input, _mm_set1_epi32(0x0FC0FC00));
+	t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+	t2 = _mm_and_si128(input, _mm_set1_epi32(0x003F03F0));
+	t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+	return _mm_or_si128(t1, t3);
+}
 
-	rest = length % 3;
+static __attribute__((__target__("ssse3"))) __m128i
+encodeTranslateSSSE3(__m128i input)
+{
+	__m128i result = _mm_subs_epu8(input, _mm_set1_epi8(51));
+	__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), input);
+
+	result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+	result = _mm_shuffle_epi8(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0), result);
 
-	for (i = 0; i < length - rest; i += 3) {
-		sb = (buffer[i] << 16) | (buffer[i + 1] << 8) | buffer[i + 2];
+	return _mm_add_epi8(result, input);
+}
 
-		tb[0] = of_base64_encode_table[(sb & 0xFC0000) >> 18];
-		tb[1] = of_base64_encode_table[(sb & 0x03F000) >> 12];
-		tb[2] = of_base64_encode_table[(sb & 0x000FC0) >> 6];
-		tb[3] = of_base64_encode_table[sb & 0x00003F];
+static __attribute__((__target__("ssse3"))) size_t
+encodeSSSE3(char *output, const uint8_t *input, size_t length)
+{
+	size_t i = 0;
 
-		[ret appendCString: tb
-			  encoding: OF_STRING_ENCODING_ASCII
-			    length: 4];
+	/* 16 bytes are loaded, but only 12 are used. */
+	for (; length - i >= 16; i += 12, output += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(input + i));
+
+		block = encodeTranslateSSSE3(encodeReshuffleSSSE3(block));
+		_mm_storeu_si128((__m128i *)output, block);
 	}
 
-	switch (rest) {
-	case 1:
-		tb[0] = of_base64_encode_table[buffer[i] >> 2];
-		tb[1] = of_base64_encode_table[(buffer[i] & 3) << 4];
-		tb[2] = tb[3] = '=';
+	return i;
+}
 
-		[ret appendCString: tb
-			  encoding: OF_STRING_ENCODING_ASCII
-			    length: 4];
+static __attribute__((__target__("avx2"))) size_t
+encodeAVX2(char *output, const uint8_t *input, size_t length)
+{
+	size_t i = 0;
+
+	/* Two lanes of 12 bytes each, the second load reads 4 bytes more. */
+	for (; length - i >= 28; i += 24, output += 32) {
+		__m256i block, t0, t1, t2, t3, result, less;
+
+		block = _mm256_inserti128_si256(_mm256_castsi128_si256(
+		    _mm_loadu_si128((const __m128i *)(input + i))),
+		    _mm_loadu_si128((const __m128i *)(input + i + 12)), 1);
+
+		block = _mm256_shuffle_epi8(block, _mm256_set_epi8(
+		    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+		    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+		t0 = _mm256_and_si256(block, _mm256_set1_epi32(0x0FC0FC00));
+		t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+		t2 = _mm256_and_si256(block, _mm256_set1_epi32(0x003F03F0));
+		t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+		block = _mm256_or_si256(t1, t3);
+
+		result = _mm256_subs_epu8(block, _mm256_set1_epi8(51));
+		less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), block);
+		result = _mm256_or_si256(result,
+		    _mm256_and_si256(less, _mm256_set1_epi8(13)));
+		result = _mm256_shuffle_epi8(_mm256_setr_epi8(
+		    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+		    '/' - 63, 'A', 0, 0,
+		    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+		    '/' - 63, 'A', 0, 0), result);
+		block = _mm256_add_epi8(result, block);
+
+		_mm256_storeu_si256((__m256i *)output, block);
+	}
 
-		break;
-	case 2:
-		sb = (buffer[i] << 16) | (buffer[i + 1] << 8);
+	return i;
+}
+
+/*
+ * Returns the number of characters decoded. Decoding stops at the first block
+ * that contains anything but the 64 characters of the alphabet, which is then
+ * handled by the scalar code.
+ */
+static __attribute__((__target__("ssse3"))) size_t
+decodeSSSE3(uint8_t *output, const uint8_t *input, size_t length)
+{
+	const __m128i lookupLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11,
+	    0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lookupHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04,
+	    0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lookupRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71,
+	    -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask2F = _mm_set1_epi8(0x2F);
+	size_t i = 0;
+
+	/*
+	 * 16 bytes are stored, but only 12 are used, so make sure that the
+	 * output has room for them.
+	 */
+	for (; length - i >= 28; i += 16, output += 12) {
+		__m128i block, highNibbles, lowNibbles, high, low, roll;
+
+		block = _mm_loadu_si128((const __m128i *)(input + i));
+		highNibbles = _mm_and_si128(_mm_srli_epi32(block, 4), mask2F);
+		lowNibbles = _mm_and_si128(block, mask2F);
+		high = _mm_shuffle_epi8(lookupHigh, highNibbles);
+		low = _mm_shuffle_epi8(lookupLow, lowNibbles);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(low, high),
+		    _mm_setzero_si128())) != 0xFFFF)
+			break;
+
+		roll = _mm_shuffle_epi8(lookupRoll, _mm_add_epi8(
+		    _mm_cmpeq_epi8(block, mask2F), highNibbles));
+		block = _mm_add_epi8(block, roll);
+
+		block = _mm_maddubs_epi16(block, _mm_set1_epi32(0x01400140));
+		block = _mm_madd_epi16(block, _mm_set1_epi32(0x00011000));
+		block = _mm_shuffle_epi8(block, _mm_setr_epi8(
+		    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+		_mm_storeu_si128((__m128i *)output, block);
+	}
+
+	return i;
+}
+
+static __attribute__((__target__("avx2"))) size_t
+decodeAVX2(uint8_t *output, const uint8_t *input, size_t length)
+{
+	const __m256i lookupLow = _mm256_setr_epi8(
+	    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+	    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lookupHigh = _mm256_setr_epi8(
+	    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+	    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lookupRoll = _mm256_setr_epi8(
+	    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+	    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask2F = _mm256_set1_epi8(0x2F);
+	size_t i = 0;
+
+	/* 32 bytes are stored, but only 24 are used. */
+	for (; length - i >= 48; i += 32, output += 24) {
+		__m256i block, highNibbles, lowNibbles, high, low, roll;
+
+		block = _mm256_loadu_si256((const __m256i *)(input + i));
+		highNibbles = _mm256_and_si256(
+		    _mm256_srli_epi32(block, 4), mask2F);
+		lowNibbles = _mm256_and_si256(block, mask2F);
+		high = _mm256_shuffle_epi8(lookupHigh, highNibbles);
+		low = _mm256_shuffle_epi8(lookupLow, lowNibbles);
+
+		if (!_mm256_testz_si256(low, high))
+			break;
+
+		roll = _mm256_shuffle_epi8(lookupRoll, _mm256_add_epi8(
+		    _mm256_cmpeq_epi8(block, mask2F), highNibbles));
+		block = _mm256_add_epi8(block, roll);
+
+		block = _mm256_maddubs_epi16(block,
+		    _mm256_set1_epi32(0x01400140));
+		block = _mm256_madd_epi16(block, _mm256_set1_epi32(0x00011000));
+		block = _mm256_shuffle_epi8(block, _mm256_setr_epi8(
+		    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+		block = _mm256_permutevar8x32_epi32(block,
+		    _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+		_mm256_storeu_si256((__m256i *)output, block);
+	}
+
+	return i;
+}
+#endif
+
+#ifdef HAVE_BASE64_SIMD
+/*
+ * +[OFSystemInfo supportsAVX2] only checks the CPU, but the AVX2 code can
+ * only be used if the OS saves the YMM registers, as it raises SIGILL
+ * otherwise.
+ */
+static bool
+OSSupportsAVX(void)
+{
+	unsigned int eax, ebx, ecx, edx;
 
-		tb[0] = of_base64_encode_table[(sb & 0xFC0000) >> 18];
-		tb[1] = of_base64_encode_table[(sb & 0x03F000) >> 12];
-		tb[2] = of_base64_encode_table[(sb & 0x000FC0) >> 6];
-		tb[3] = '=';
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
 
-		[ret appendCString: tb
-			  encoding: OF_STRING_ENCODING_ASCII
-			    length: 4];
+	/* OSXSAVE */
+	if (!(ecx & (1u << 27)))
+		return false;
+
+	/* XCR0 needs to have both the XMM and the YMM state enabled. */
+	__asm__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+	return ((eax & 0x6) == 0x6);
+}
+#endif
 
+static encode_function encodeFunction = NULL;
+static decode_function decodeFunction = NULL;
+static of_once_t selectFunctionsControl = OF_ONCE_INIT;
+
+static void
+selectFunctions(void)
+{
+#ifdef HAVE_BASE64_SIMD
+	if ([OFSystemInfo supportsAVX2] && OSSupportsAVX()) {
+		encodeFunction = encodeAVX2;
+		decodeFunction = decodeAVX2;
+	} else if ([OFSystemInfo supportsSSSE3]) {
+		encodeFunction = encodeSSSE3;
+		decodeFunction = decodeSSSE3;
+	}
+#endif
+}
+
+size_t
+of_base64_encode_buffer(char *buffer, const void *data, size_t length)
+{
+	const uint8_t *input = (const uint8_t *)data;
+	char *output = buffer;
+	size_t i = 0;
+	uint32_t sb;
+
+	of_once(&selectFunctionsControl, selectFunctions);
+
+	if (encodeFunction != NULL) {
+		i = encodeFunction(output, input, length);
+		output += i / 3 * 4;
+	}
+
+	for (; length - i >= 3; i += 3) {
+		sb = (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+
+		*output++ = of_base64_encode_table[(sb & 0xFC0000) >> 18];
+		*output++ = of_base64_encode_table[(sb & 0x03F000) >> 12];
+		*output++ = of_base64_encode_table[(sb & 0x000FC0) >> 6];
+		*output++ = of_base64_encode_table[sb & 0x00003F];
+	}
+
+	switch (length - i) {
+	case 1:
+		*output++ = of_base64_encode_table[input[i] >> 2];
+		*output++ = of_base64_encode_table[(input[i] & 3) << 4];
+		*output++ = '=';
+		*output++ = '=';
+		break;
+	case 2:
+		sb = (input[i] << 16) | (input[i + 1] << 8);
+
+		*output++ = of_base64_encode_table[(sb & 0xFC0000) >> 18];
+		*output++ = of_base64_encode_table[(sb & 0x03F000) >> 12];
+		*output++ = of_base64_encode_table[(sb & 0x000FC0) >> 6];
+		*output++ = '=';
 		break;
 	}
 
-	[ret makeImmutable];
+	return output - buffer;
+}
+
+size_t
+of_base64_decoded_length(const char *string, size_t length)
+{
+	if ((length & 3) != 0)
+		return SIZE_MAX;
+
+	if (length == 0)
+		return 0;
 
-	return ret;
+	if (string[length - 1] != '=')
+		return length / 4 * 3;
+	if (string[length - 2] != '=')
+		return length / 4 * 3 - 1;
+
+	return length / 4 * 3 - 2;
 }
 
 bool
-of_base64_decode(OFMutableData *data, const char *string, size_t length)
+of_base64_decode_buffer(void *buffer, const char *string, size_t length)
 {
-	const uint8_t *buffer = (const uint8_t *)string;
-	size_t i;
+	const uint8_t *input = (const uint8_t *)string;
+	uint8_t *output = buffer;
+	size_t i = 0;
 
 	if ((length & 3) != 0)
 		return false;
 
-	if (data.itemSize != 1)
-		return false;
+	of_once(&selectFunctionsControl, selectFunctions);
+
+	if (decodeFunction != NULL) {
+		i = decodeFunction(output, input, length);
+		output += i / 4 * 3;
+	}
 
-	for (i = 0; i < length; i += 4) {
+	for (; i < length; i += 4) {
 		uint32_t sb = 0;
 		uint8_t count = 3;
-		char db[3];
 		int8_t tmp;
 
-		if (buffer[i] > 0x7F || buffer[i + 1] > 0x7F ||
-		    buffer[i + 2] > 0x7F || buffer[i + 3] > 0x7F)
+		if (input[i] > 0x7F || input[i + 1] > 0x7F ||
+		    input[i + 2] > 0x7F || input[i + 3] > 0x7F)
 			return false;
 
-		if (buffer[i] == '=' || buffer[i + 1] == '=' ||
-		    (buffer[i + 2] == '=' && buffer[i + 3] != '='))
+		if (input[i] == '=' || input[i + 1] == '=' ||
+		    (input[i + 2] == '=' && input[i + 3] != '='))
 			return false;
 
-		if (buffer[i + 2] == '=')
+		if (input[i + 2] == '=')
 			count--;
-		if (buffer[i + 3] == '=')
+		if (input[i + 3] == '=')
 			count--;
 
-		if ((tmp = of_base64_decode_table[buffer[i]]) == -1)
+		/* Padding is only allowed at the very end. */
+		if (count < 3 && i + 4 != length)
+			return false;
+
+		if ((tmp = of_base64_decode_table[input[i]]) == -1)
 			return false;
 
 		sb |= tmp << 18;
 
-		if ((tmp = of_base64_decode_table[buffer[i + 1]]) == -1)
+		if ((tmp = of_base64_decode_table[input[i + 1]]) == -1)
 			return false;
 
 		sb |= tmp << 12;
 
-		if ((tmp = of_base64_decode_table[buffer[i + 2]]) == -1)
+		if ((tmp = of_base64_decode_table[input[i + 2]]) == -1)
 			return false;
 
 		sb |= tmp << 6;
 
-		if ((tmp = of_base64_decode_table[buffer[i + 3]]) == -1)
+		if ((tmp = of_base64_decode_table[input[i + 3]]) == -1)
 			return false;
 
 		sb |= tmp;
 
-		db[0] = (sb & 0xFF0000) >> 16;
-		db[1] = (sb & 0x00FF00) >> 8;
-		db[2] = sb & 0x0000FF;
+		*output++ = (sb & 0xFF0000) >> 16;
 
-		[data addItems: db
-			 count: count];
+		if (count > 1)
+			*output++ = (sb & 0x00FF00) >> 8;
+		if (count > 2)
+			*output++ = sb & 0x0000FF;
+	}
+
+	return true;
+}
+
+OFString *
+of_base64_encode(const void *data, size_t length)
+{
+	size_t encodedLength;
+	char *buffer;
+
+	if (length > SIZE_MAX / 4 * 3 - 3)
+		@throw [OFOutOfRangeException exception];
+
+	encodedLength = of_base64_encoded_length(length);
+
+	if ((buffer = malloc(encodedLength + 1)) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: encodedLength + 1];
+
+	of_base64_encode_buffer(buffer, data, length);
+	buffer[encodedLength] = '\0';
+
+	return [OFString stringWithUTF8StringNoCopy: buffer
+					     length: encodedLength
+				       freeWhenDone: true];
+}
+
+bool
+of_base64_decode(OFMutableData *data, const char *string, size_t length)
+{
+	size_t count = of_base64_decoded_length(string, length);
+	size_t oldCount = data.count;
+
+	if (count == SIZE_MAX)
+		return false;
+
+	if (data.itemSize != 1)
+		return false;
+
+	[data increaseCountBy: count];
+
+	if (!of_base64_decode_buffer((char *)data.mutableItems + oldCount,
+	    string, length)) {
+		[data removeItemsInRange: of_range(oldCount, count)];
+		return false;
 	}
 
 	return true;
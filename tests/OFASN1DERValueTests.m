@@ -345,6 +345,38 @@ static OFString *module = @"OFData+ASN1DERValue";
 	    [[OFData dataWithItems: "\x31\x04\x02\x01\x01\x00\x00"
 			     count: 7] ASN1DERValue])
 
+	/* Lazy parsing */
+	TEST(@"Lazy parsing of sequence and set",
+	    (array = [[OFData dataWithItems: "\x30\x0D\x31\x09\x02\x01\x7B"
+					     "\x0C\x04Test\x05\x00"
+				      count: 15]
+	    ASN1DERValueWithOptions: OF_ASN1_DER_VALUE_LAZY
+			 depthLimit: 32]) &&
+	    [array isKindOfClass: [OFArray class]] && array.count == 2 &&
+	    (set = [array objectAtIndex: 0]) &&
+	    [set isKindOfClass: [OFSet class]] && set.count == 2 &&
+	    [array objectAtIndex: 1] == [OFNull null])
+
+	TEST(@"Counting of lazy sequence without parsing the elements",
+	    [[[OFData dataWithItems: "\x30\x06\x05\x01\x00\x05\x01\x00"
+			      count: 8]
+	    ASN1DERValueWithOptions: OF_ASN1_DER_VALUE_LAZY
+			 depthLimit: 32] count] == 2)
+
+	EXPECT_EXCEPTION(@"Detection of invalid element in lazy sequence",
+	    OFInvalidFormatException,
+	    [[[OFData dataWithItems: "\x30\x06\x05\x01\x00\x05\x01\x00"
+			      count: 8]
+	    ASN1DERValueWithOptions: OF_ASN1_DER_VALUE_LAZY
+			 depthLimit: 32] objectAtIndex: 0])
+
+	EXPECT_EXCEPTION(@"Detection of truncated lazy sequence",
+	    OFTruncatedDataException,
+	    [[[OFData dataWithItems: "\x30\x02\x05\x01"
+			      count: 4]
+	    ASN1DERValueWithOptions: OF_ASN1_DER_VALUE_LAZY
+			 depthLimit: 32] count])
+
 	/* NumericString */
 	TEST(@"Parsing of NumericString",
 	    [[[[OFData dataWithItems: "\x12\x0B" "12345 67890"
@@ -30,6 +30,8 @@ const char *str = "Hello!";
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	OFMutableData *mutable;
 	OFData *immutable;
+	OFMutableData *base64Data;
+	uint8_t base64Byte;
 	void *raw[2];
 	of_range_t range;
 
@@ -159,6 +161,11 @@ const char *str = "Hello!";
 	    isEqual: [OFData dataWithItems: "cde"
 				     count: 3]])
 
+	TEST(@"-[subdataWithRange:] without copying",
+	    [[immutable subdataWithRange: of_range(2, 4)]
+	    subdataWithRange: of_range(1, 2)].items ==
+	    (const char *)immutable.items + 6)
+
 	EXPECT_EXCEPTION(@"-[subdataWithRange:] failing on out of range #1",
 	    OFOutOfRangeException, [immutable subdataWithRange: of_range(7, 1)])
 
@@ -191,12 +198,40 @@ const char *str = "Hello!";
 	    memcmp([[OFData dataWithBase64EncodedString: @"YWJjZGU="]
 	    items], "abcde", 5) == 0)
 
+	base64Data = [OFMutableData dataWithCapacity: 1000];
+	for (size_t i = 0; i < 1000; i++) {
+		base64Byte = (uint8_t)(i * 7);
+		[base64Data addItem: &base64Byte];
+	}
+
+	TEST(@"Base64 round trip of long data",
+	    [[OFData dataWithBase64EncodedString:
+	    base64Data.stringByBase64Encoding] isEqual: base64Data])
+
+	EXPECT_EXCEPTION(@"Detection of invalid Base64 characters",
+	    OFInvalidFormatException,
+	    [OFData dataWithBase64EncodedString: @"YWJjZG!="])
+
+	EXPECT_EXCEPTION(@"Detection of Base64 padding in the middle",
+	    OFInvalidFormatException,
+	    [OFData dataWithBase64EncodedString: @"YQ==YWJj"])
+
 	TEST(@"Building strings",
 	    (mutable = [OFMutableData dataWithItems: str
 					       count: 6]) &&
 	    R([mutable addItem: ""]) &&
 	    strcmp(mutable.items, str) == 0)
 
+#ifdef OF_HAVE_FILES
+	TEST(@"+[dataWithContentsOfMappedFile:]",
+	    (immutable = [OFData dataWithContentsOfFile: @"testfile.bin"]) &&
+	    [[OFData dataWithContentsOfMappedFile: @"testfile.bin"]
+	    isEqual: immutable] &&
+	    [[[OFData dataWithContentsOfMappedFile: @"testfile.bin"]
+	    subdataWithRange: of_range(3, 100)]
+	    isEqual: [immutable subdataWithRange: of_range(3, 100)]])
+#endif
+
 	EXPECT_EXCEPTION(@"Detect out of range in -[itemAtIndex:]",
 	    OFOutOfRangeException, [mutable itemAtIndex: mutable.count])
 
@@ -27,7 +27,7 @@ static OFString *module = @"OFDate";
 - (void)dateTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
-	OFDate *d1, *d2;
+	OFDate *d1, *d2, *d3;
 
 	struct tm tm;
 	int16_t tz;
@@ -71,6 +71,38 @@ static OFString *module = @"OFDate";
 	    [OFDate dateWithLocalDateString: @"2000-06-20T12:34:56+0200x"
 				     format: @"%Y-%m-%dT%H:%M:%S%z"])
 
+	TEST(@"+[dateWithHTTPDateString:]",
+	    [[OFDate dateWithHTTPDateString: @"Sun, 06 Nov 1994 08:49:37 GMT"]
+	    .timeIntervalSince1970 == 784111777 &&
+	    [[OFDate dateWithHTTPDateString: @"Sunday, 06-Nov-94 08:49:37 GMT"]
+	    .timeIntervalSince1970 == 784111777 &&
+	    [[OFDate dateWithHTTPDateString: @"Sun Nov  6 08:49:37 1994"]
+	    .timeIntervalSince1970 == 784111777)
+
+	EXPECT_EXCEPTION(@"Detection of invalid dates in "
+	    @"+[dateWithHTTPDateString:]", OFInvalidFormatException,
+	    [OFDate dateWithHTTPDateString: @"Sun, 29 Feb 1994 08:49:37 GMT"])
+
+	TEST(@"-[HTTPDateString]",
+	    [d1.HTTPDateString isEqual: @"Thu, 01 Jan 1970 00:00:00 GMT"] &&
+	    [[OFDate dateWithTimeIntervalSince1970: 951782400].HTTPDateString
+	    isEqual: @"Tue, 29 Feb 2000 00:00:00 GMT"] &&
+	    [[OFDate dateWithTimeIntervalSince1970: -1].HTTPDateString
+	    isEqual: @"Wed, 31 Dec 1969 23:59:59 GMT"])
+
+	TEST(@"+[dateWithISO8601DateString:]",
+	    [[[OFDate dateWithISO8601DateString: @"2000-06-20T12:34:56+02:00"]
+	    description] isEqual: @"2000-06-20T10:34:56Z"] &&
+	    [[OFDate dateWithISO8601DateString: @"1970-01-01T00:00:00.25Z"]
+	    .timeIntervalSince1970 == 0.25)
+
+	EXPECT_EXCEPTION(@"Detection of unparsed in "
+	    @"+[dateWithISO8601DateString:]", OFInvalidFormatException,
+	    [OFDate dateWithISO8601DateString: @"2000-06-20T12:34:56Zx"])
+
+	TEST(@"-[ISO8601DateString]",
+	    [d2.ISO8601DateString isEqual: @"1970-01-02T01:00:05Z"])
+
 	TEST(@"-[isEqual:]",
 	    [d1 isEqual: [OFDate dateWithTimeIntervalSince1970: 0]] &&
 	    ![d1 isEqual: [OFDate dateWithTimeIntervalSince1970: 0.0000001]])
@@ -95,6 +127,13 @@ static OFString *module = @"OFDate";
 
 	TEST(@"-[dayOfYear]", d1.dayOfYear == 1 && d2.dayOfYear == 2)
 
+	TEST(@"Components of dates before 1970 and in leap years",
+	    (d3 = [OFDate dateWithTimeIntervalSince1970: -86400]) &&
+	    d3.year == 1969 && d3.monthOfYear == 12 && d3.dayOfMonth == 31 &&
+	    d3.dayOfYear == 365 && d3.dayOfWeek == 3 &&
+	    (d3 = [OFDate dateWithTimeIntervalSince1970: 978220800]) &&
+	    d3.year == 2000 && d3.dayOfYear == 366 && d3.dayOfWeek == 0)
+
 	TEST(@"-[earlierDate:]", [[d1 earlierDate: d2] isEqual: d1])
 
 	TEST(@"-[laterDate:]", [[d1 laterDate: d2] isEqual: d2])
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFFileManager";
+
+@implementation TestsAppDelegate (OFFileManagerTests)
+- (void)fileManagerTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	/* FIXME: Find a way to write files on Nintendo DS */
+#ifndef OF_NINTENDO_DS
+	OFFileManager *fileManager = [OFFileManager defaultManager];
+	OFString *directory, *source, *destination;
+	OFString *emptySource, *emptyDestination;
+	OFData *data;
+# ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
+	of_file_attributes_t attributes;
+# endif
+
+# ifndef OF_IOS
+	directory = @"tmpdir";
+# else
+	directory = [OFString pathWithComponents: [OFArray arrayWithObjects:
+	    [[OFApplication environment] objectForKey: @"HOME"],
+	    @"tmp", @"tmpdir", nil]];
+# endif
+	source = [directory stringByAppendingPathComponent: @"source"];
+	destination =
+	    [directory stringByAppendingPathComponent: @"destination"];
+	emptySource = [directory stringByAppendingPathComponent: @"empty"];
+	emptyDestination =
+	    [directory stringByAppendingPathComponent: @"emptycopy"];
+
+	data = [OFData dataWithContentsOfFile: @"testfile.bin"];
+
+	[fileManager createDirectoryAtPath: directory];
+	[data writeToFile: source];
+	[[OFData data] writeToFile: emptySource];
+# ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
+	attributes = [OFDictionary
+	    dictionaryWithObject: [OFNumber numberWithUInt16: 0640]
+			  forKey: of_file_attribute_key_posix_permissions];
+	[fileManager setAttributes: attributes
+		      ofItemAtPath: source];
+	[fileManager setAttributes: attributes
+		      ofItemAtPath: emptySource];
+# endif
+
+	TEST(@"-[copyItemAtPath:toPath:]",
+	    R([fileManager copyItemAtPath: source
+				   toPath: destination]) &&
+	    [[OFData dataWithContentsOfFile: destination] isEqual: data])
+
+	TEST(@"-[copyItemAtPath:toPath:] with an empty file",
+	    R([fileManager copyItemAtPath: emptySource
+				   toPath: emptyDestination]) &&
+	    [[fileManager attributesOfItemAtPath: emptyDestination]
+	    fileSize] == 0)
+
+# ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
+	TEST(@"-[copyItemAtPath:toPath:] copies permissions",
+	    [[fileManager attributesOfItemAtPath: destination]
+	    filePOSIXPermissions] == 0640 &&
+	    [[fileManager attributesOfItemAtPath: emptyDestination]
+	    filePOSIXPermissions] == 0640)
+# endif
+
+	TEST(@"-[contentsOfFileAtPath:options:] mapping a file",
+	    [[fileManager contentsOfFileAtPath: source
+				       options: OF_FILE_MANAGER_CONTENTS_MAPPED]
+	    isEqual: data])
+
+	TEST(@"-[contentsOfFileAtPath:options:] mapping an empty file",
+	    [[fileManager contentsOfFileAtPath: emptySource
+				       options: OF_FILE_MANAGER_CONTENTS_MAPPED]
+	    count] == 0)
+
+	EXPECT_EXCEPTION(@"Detection of an existing destination",
+	    OFCopyItemFailedException,
+	    [fileManager copyItemAtPath: emptySource
+				 toPath: destination])
+
+	TEST(@"Existing destination is left unchanged",
+	    [[OFData dataWithContentsOfFile: destination] isEqual: data])
+
+	[fileManager removeItemAtPath: directory];
+#endif
+
+	[pool drain];
+}
+@end
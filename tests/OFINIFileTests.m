@@ -49,7 +49,7 @@ static OFString *module = @"OFINIFile";
 	OFINICategory *tests, *foobar, *types;
 	OFArray *array;
 #ifndef OF_NINTENDO_DS
-	OFString *writePath;
+	OFString *writePath, *lazyOutput;
 #endif
 
 	TEST(@"+[fileWithPath:encoding:]",
@@ -137,6 +137,28 @@ static OFString *module = @"OFINIFile";
 				encoding: OF_STRING_ENCODING_CODEPAGE_437]
 	    isEqual: output])
 	[[OFFileManager defaultManager] removeItemAtPath: writePath];
+
+	TEST(@"+[fileWithPath:encoding:options:] with OF_INI_FILE_LAZY",
+	    (file = [OFINIFile fileWithPath: @"testfile.ini"
+				   encoding: OF_STRING_ENCODING_CODEPAGE_437
+				    options: OF_INI_FILE_LAZY]) &&
+	    [[[file categoryForName: @"foobar"] stringForKey: @"quxquxqux"]
+	    isEqual: @"hello\"wörld"])
+
+	TEST(@"-[writeToFile:encoding:] after loading lazily",
+	    R([file writeToFile: writePath
+		       encoding: OF_STRING_ENCODING_CODEPAGE_437]) &&
+	    (lazyOutput = [OFString
+	    stringWithContentsOfFile: writePath
+			    encoding: OF_STRING_ENCODING_CODEPAGE_437]) &&
+	    R([[OFINIFile fileWithPath: @"testfile.ini"
+			      encoding: OF_STRING_ENCODING_CODEPAGE_437]
+	    writeToFile: writePath
+	       encoding: OF_STRING_ENCODING_CODEPAGE_437]) &&
+	    [lazyOutput isEqual: [OFString
+	    stringWithContentsOfFile: writePath
+			    encoding: OF_STRING_ENCODING_CODEPAGE_437]])
+	[[OFFileManager defaultManager] removeItemAtPath: writePath];
 #else
 	(void)output;
 #endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFMessagePack";
+
+@implementation TestsAppDelegate (OFMessagePackTests)
+- (void)messagePackTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFArray *array = [OFArray arrayWithObjects:
+	    [OFNumber numberWithUInt8: 1],
+	    @"foo",
+	    [OFNull null],
+	    [OFNumber numberWithBool: true],
+	    [OFNumber numberWithInt16: -2],
+	    [OFData dataWithItems: "ab"
+			    count: 2],
+	    [OFDictionary dictionaryWithObject: [OFNumber numberWithUInt16: 300]
+					forKey: @"x"],
+	    nil];
+	const unsigned char bytes[] = {
+		0x97, 0x01, 0xA3, 'f', 'o', 'o', 0xC0, 0xC3, 0xFE, 0xC4, 0x02,
+		'a', 'b', 0x81, 0xA1, 'x', 0xCD, 0x01, 0x2C
+	};
+	OFData *data;
+	OFMessagePackReader *reader;
+	OFMessagePackWriter *writer;
+	CaptureStream *stream;
+	id object;
+	bool ok;
+
+	TEST(@"+[OFMessagePackWriter messagePackLengthOfObject:]",
+	    [OFMessagePackWriter messagePackLengthOfObject: array] ==
+	    sizeof(bytes))
+
+	TEST(@"-[messagePackRepresentation]",
+	    (data = array.messagePackRepresentation) &&
+	    data.count == sizeof(bytes) &&
+	    memcmp(data.items, bytes, sizeof(bytes)) == 0)
+
+	TEST(@"-[messagePackValue]", [data.messagePackValue isEqual: array])
+
+	stream = [[[CaptureStream alloc] init] autorelease];
+	writer = [[OFMessagePackWriter alloc] initWithStream: stream];
+	TEST(@"-[OFMessagePackWriter writeObject:] flushes on deallocation",
+	    R([writer writeObject: array]) && stream.data.count == 0 &&
+	    R([writer release]) && stream.data.count == sizeof(bytes) &&
+	    memcmp(stream.data.items, bytes, sizeof(bytes)) == 0)
+
+	EXPECT_EXCEPTION(@"Refusal to encode OFSecureData in containers",
+	    OFNotImplementedException,
+	    [[OFArray arrayWithObject: [OFSecureData dataWithCount: 1]]
+	    messagePackRepresentation])
+
+	reader = [OFMessagePackReader reader];
+	ok = true;
+	for (size_t i = 0; i < sizeof(bytes); i++) {
+		[reader addItems: bytes + i
+			   count: 1];
+
+		object = [reader nextObject];
+		if ((i < sizeof(bytes) - 1 && object != nil) ||
+		    (i == sizeof(bytes) - 1 && ![object isEqual: array]))
+			ok = false;
+	}
+	TEST(@"-[OFMessagePackReader nextObject] with single bytes",
+	    ok && !reader.hasDataInBuffer)
+
+	TEST(@"-[OFMessagePackReader nextObject] with several objects",
+	    R([reader addItems: "\xC3\xA1"
+			 count: 2]) &&
+	    [[reader nextObject] isEqual: [OFNumber numberWithBool: true]] &&
+	    [reader nextObject] == nil && R([reader addItems: "a"
+						       count: 1]) &&
+	    [[reader nextObject] isEqual: @"a"] && !reader.hasDataInBuffer)
+
+	reader = [OFMessagePackReader
+	    readerWithOptions: OF_MESSAGE_PACK_VALUE_NO_COPY];
+	TEST(@"OF_MESSAGE_PACK_VALUE_NO_COPY",
+	    R([reader addItems: bytes
+			 count: sizeof(bytes)]) &&
+	    (object = [reader nextObject]) && [object isEqual: array] &&
+	    (data = [OFData dataWithItems: bytes
+				    count: sizeof(bytes)]) &&
+	    (object = [data messagePackValueWithOptions:
+	    OF_MESSAGE_PACK_VALUE_NO_COPY
+					     depthLimit: 32]) &&
+	    [[object objectAtIndex: 5] items] ==
+	    (const char *)data.items + 11)
+
+	[pool drain];
+}
+@end
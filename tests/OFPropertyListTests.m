@@ -54,6 +54,14 @@ static OFString *PLIST3 = PLIST(
     @" <key>foo</key>"
     @" <string>bar</string>"
     @"</dict>");
+static const unsigned char BPLIST[] =
+    "\x62\x70\x6C\x69\x73\x74\x30\x30\xA7\x01\x02\x03\x04\x05"
+    "\x06\x07\x55\x48\x65\x6C\x6C\x6F\x46\x57\x6F\x72\x6C\x64"
+    "\x21\x33\x41\xC0\x2C\xA7\x38\x00\x00\x00\x09\x08\x23\x40"
+    "\x28\x80\x00\x00\x00\x00\x00\x13\xFF\xFF\xFF\xFF\xFF\xFF"
+    "\xFF\xF6\x08\x10\x16\x1D\x26\x27\x28\x31\x00\x00\x00\x00"
+    "\x00\x00\x01\x01\x00\x00\x00\x00\x00\x00\x00\x08\x00\x00"
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x3A";
 
 @implementation TestsAppDelegate (OFPLISTParser)
 - (void)propertyListTests
@@ -69,6 +77,9 @@ static OFString *PLIST3 = PLIST(
 	    [OFNumber numberWithFloat: 12.25],
 	    [OFNumber numberWithInt: -10],
 	    nil];
+	OFData *binary = [OFData dataWithItems: BPLIST
+					 count: sizeof(BPLIST) - 1];
+	OFDictionary *dictionary;
 
 	TEST(@"-[propertyListValue:] #1",
 	    [PLIST1.propertyListValue isEqual: @"Hello"])
@@ -114,6 +125,61 @@ static OFString *PLIST3 = PLIST(
 	    OFInvalidFormatException,
 	    [PLIST(@"<dict><key x='x'/><string/></dict>") propertyListValue])
 
+	TEST(@"-[OFData propertyListValue] for binary property lists",
+	    [binary.propertyListValue isEqual: array])
+
+	TEST(@"-[OFData propertyListValue] for XML property lists",
+	    [[OFData dataWithItems: PLIST2.UTF8String
+			     count: PLIST2.UTF8StringLength].propertyListValue
+	    isEqual: array])
+
+	TEST(@"-[binaryPropertyListRepresentation]",
+	    [[OFArray arrayWithObjects:
+	    @"Hello",
+	    [OFData dataWithItems: "World!"
+			    count: 6],
+	    [OFDate dateWithTimeIntervalSince1970: 1521030896],
+	    [OFNumber numberWithBool: true],
+	    [OFNumber numberWithBool: false],
+	    [OFNumber numberWithDouble: 12.25],
+	    [OFNumber numberWithInt: -10],
+	    nil].binaryPropertyListRepresentation isEqual: binary])
+
+	TEST(@"-[binaryPropertyListRepresentation] stores equal objects once",
+	    [OFArray arrayWithObjects: @"Hello", @"Hello", @"Hello", nil]
+	    .binaryPropertyListRepresentation.count == 52)
+
+	dictionary = [OFDictionary dictionaryWithKeysAndObjects:
+	    @"array", array,
+	    @"foo", @"bar",
+	    @"äöü€𝄞", [OFArray arrayWithObjects:
+	    [OFNumber numberWithUInt64: UINT64_MAX],
+	    [OFNumber numberWithInt64: INT64_MIN],
+	    [OFNumber numberWithInt: 1],
+	    [OFNumber numberWithDouble: 1],
+	    [OFArray array],
+	    nil],
+	    nil];
+	TEST(@"Round trip through binary property lists",
+	    [dictionary.binaryPropertyListRepresentation.propertyListValue
+	    isEqual: dictionary])
+
+	EXPECT_EXCEPTION(@"-[OFData propertyListValue] detecting unsupported "
+	    @"version", OFUnsupportedVersionException,
+	    [[OFData dataWithItems: "bplist01"
+			     count: 8] propertyListValue])
+
+	EXPECT_EXCEPTION(@"-[OFData propertyListValue] detecting truncated "
+	    @"binary property list", OFInvalidFormatException,
+	    [[binary subdataWithRange: of_range(0, binary.count - 1)]
+	    propertyListValue])
+
+	EXPECT_EXCEPTION(@"-[binaryPropertyListRepresentation] rejecting "
+	    @"non-string keys", OFInvalidArgumentException,
+	    [[OFDictionary dictionaryWithObject: @"x"
+					 forKey: [OFNumber numberWithInt: 1]]
+	    binaryPropertyListRepresentation])
+
 	[pool drain];
 }
 @end
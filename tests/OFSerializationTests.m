@@ -28,7 +28,7 @@ static OFString *module = @"OFSerialization";
 	OFMutableDictionary *d = [OFMutableDictionary dictionary];
 	OFMutableArray *a = [OFMutableArray array];
 	OFList *l = [OFList list];
-	OFData *data;
+	OFData *data, *binary;
 	OFString *s;
 
 	[a addObject: @"Qu\"xbar\ntest"];
@@ -65,6 +65,22 @@ static OFString *module = @"OFSerialization";
 
 	TEST(@"-[objectByDeserializing]", [s.objectByDeserializing isEqual: d])
 
+	TEST(@"-[dataBySerializing]",
+	    (binary = d.dataBySerializing) && binary.count < s.UTF8StringLength)
+
+	TEST(@"-[OFData objectByDeserializing]",
+	    [binary.objectByDeserializing isEqual: d])
+
+	TEST(@"-[OFData objectByDeserializing] with XML",
+	    [[OFData dataWithItems: s.UTF8String
+			     count: s.UTF8StringLength].objectByDeserializing
+	    isEqual: d])
+
+	EXPECT_EXCEPTION(@"-[OFData objectByDeserializing] detecting "
+	    @"truncated data", OFTruncatedDataException,
+	    [[binary subdataWithRange: of_range(0, binary.count - 1)]
+	    objectByDeserializing])
+
 	[pool drain];
 }
 @end
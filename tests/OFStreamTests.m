@@ -70,6 +70,15 @@ static OFString *module = @"OFStream";
 	StreamTester *t = [[[StreamTester alloc] init] autorelease];
 	OFString *str;
 	char *cstr;
+	CaptureStream *buffered, *base64;
+	OFBase64EncodingStream *encoder;
+	of_stream_buffer_t buffers[3] = {
+		{ "l", 1 }, { "mn", 2 }, { "opq", 3 }
+	};
+#if defined(OF_HAVE_FILES) && !defined(OF_NINTENDO_DS)
+	OFString *writePath;
+	OFFile *file;
+#endif
 
 	cstr = [t allocMemoryWithSize: pageSize - 2];
 	memset(cstr, 'X', pageSize - 3);
@@ -79,6 +88,86 @@ static OFString *module = @"OFStream";
 	    (str = [t readLine]).length == pageSize - 3 &&
 	    !strcmp(str.UTF8String, cstr))
 
+	TEST(@"-[unreadFromBuffer:length:]",
+	    R([t unreadFromBuffer: "bar\r\nbaz"
+			   length: 8]) &&
+	    [[t readLine] isEqual: @"bar"] && [[t readLine] isEqual: @"baz"] &&
+	    [t readLine] == nil)
+
+	TEST(@"-[readTillDelimiter:]",
+	    R([t unreadFromBuffer: "foo--b--b--bound--bar"
+			   length: 21]) &&
+	    [[t readTillDelimiter: @"--bound--"] isEqual: @"foo--b--b"] &&
+	    [[t readTillDelimiter: @"--bound--"] isEqual: @"bar"])
+
+	buffered = [[[CaptureStream alloc] init] autorelease];
+	buffered.writeBuffered = true;
+
+	TEST(@"-[setWriteBufferSize:]", R(buffered.writeBufferSize = 4))
+
+	TEST(@"Buffered -[writeBuffer:length:]",
+	    R([buffered writeBuffer: "ab"
+			     length: 2]) && buffered.data.count == 0 &&
+	    R([buffered writeBuffer: "cde"
+			     length: 3]) && buffered.data.count == 2 &&
+	    R([buffered writeBuffer: "fghij"
+			     length: 5]) && buffered.data.count == 10 &&
+	    R([buffered writeBuffer: "k"
+			     length: 1]) && buffered.data.count == 10 &&
+	    memcmp(buffered.data.items, "abcdefghij", 10) == 0)
+
+	TEST(@"-[flushWriteBuffer]", R([buffered flushWriteBuffer]) &&
+	    buffered.data.count == 11 &&
+	    memcmp(buffered.data.items, "abcdefghijk", 11) == 0)
+
+	TEST(@"-[writeBuffers:count:]",
+	    R([buffered writeBuffers: buffers
+			       count: 2]) && buffered.data.count == 11 &&
+	    R([buffered writeBuffers: buffers + 2
+			       count: 1]) && buffered.data.count == 14 &&
+	    R([buffered writeBuffers: buffers
+			       count: 3]) && buffered.data.count == 23 &&
+	    memcmp(buffered.data.items, "abcdefghijklmnopqlmnopq", 23) == 0)
+
+	/* FIXME: Find a way to write files on Nintendo DS */
+#if defined(OF_HAVE_FILES) && !defined(OF_NINTENDO_DS)
+# ifndef OF_IOS
+	writePath = @"tmpfile.bin";
+# else
+	writePath = [OFString pathWithComponents: [OFArray arrayWithObjects:
+	    [[OFApplication environment] objectForKey: @"HOME"],
+	    @"tmp", @"tmpfile.bin", nil]];
+# endif
+	file = [OFFile fileWithPath: writePath
+			       mode: @"w"];
+
+	TEST(@"Unbuffered -[OFFile writeBuffers:count:]",
+	    [file writeBuffers: buffers
+			 count: 3] == 6 && R([file close]) &&
+	    [[OFData dataWithContentsOfFile: writePath] isEqual:
+	    [OFData dataWithItems: "lmnopq"
+			    count: 6]])
+
+	[[OFFileManager defaultManager] removeItemAtPath: writePath];
+#endif
+
+	base64 = [[[CaptureStream alloc] init] autorelease];
+	encoder = [OFBase64EncodingStream streamWithStream: base64];
+
+	TEST(@"-[OFBase64EncodingStream writeBuffer:length:]",
+	    R([encoder writeBuffer: "a"
+			    length: 1]) &&
+	    R([encoder writeBuffer: "bcd"
+			    length: 3]) &&
+	    R([encoder writeBuffer: "e"
+			    length: 1]) &&
+	    base64.data.count == 4 &&
+	    memcmp(base64.data.items, "YWJj", 4) == 0)
+
+	TEST(@"-[OFBase64EncodingStream close]", R([encoder close]) &&
+	    base64.data.count == 8 &&
+	    memcmp(base64.data.items, "YWJjZGU=", 8) == 0)
+
 	[pool drain];
 }
 @end
@@ -266,6 +266,9 @@ static uint16_t sutf16str[] = {
 	TEST(@"-[hash] is the same if -[isEqual:] is true",
 	    s[0].hash == s[2].hash)
 
+	TEST(@"-[hash] of constant strings",
+	    @"täs€".hash == C(@"täs€").hash && @"abc".hash == C(@"abc").hash)
+
 	TEST(@"-[description]", [s[0].description isEqual: s[0]])
 
 	TEST(@"-[appendString:] and -[appendUTF8String:]",
@@ -1231,10 +1234,27 @@ static uint16_t sutf16str[] = {
 	    [[C(@"foo\"ba'_~$]🍏🍌") stringByURLEncodingWithAllowedCharacters:
 	    cs] isEqual: @"foo%22ba'_~$%5D🍏%F0%9F%8D%8C"])
 
+	TEST(@"-[stringByURLEncodingWithAllowedCharacters:] without escaping",
+	    [[C(@"foo'_~$🍏") stringByURLEncodingWithAllowedCharacters: cs]
+	    isEqual: @"foo'_~$🍏"])
+
+	TEST(@"-[stringByURLEncodingWithAllowedCharacters:] with URL path set",
+	    [[C(@"Some-long.path/with spaces/und-Ümläute")
+	    stringByURLEncodingWithAllowedCharacters:
+	    [OFCharacterSet URLPathAllowedCharacterSet]] isEqual:
+	    @"Some-long.path/with%20spaces/und-%C3%9Cml%C3%A4ute"] &&
+	    [[C(@"0123456789-abcdefghij.ABCDEFGHIJ")
+	    stringByURLEncodingWithAllowedCharacters:
+	    [OFCharacterSet URLPathAllowedCharacterSet]] isEqual:
+	    @"0123456789-abcdefghij.ABCDEFGHIJ"])
+
 	TEST(@"-[stringByURLDecoding]",
 	    [C(@"foo%20bar%22+%24%F0%9F%8D%8C").stringByURLDecoding
 	    isEqual: @"foo bar\"+$🍌"])
 
+	TEST(@"-[stringByURLDecoding] without escapes",
+	    [C(@"foo bar+$🍌").stringByURLDecoding isEqual: @"foo bar+$🍌"])
+
 	TEST(@"-[insertString:atIndex:]",
 	    (s[0] = [mutableStringClass stringWithString: @"𝄞öööbä€"]) &&
 	    R([s[0] insertString: @"äöü"
@@ -1359,12 +1379,20 @@ static uint16_t sutf16str[] = {
 	    (is = C(@"<hello> &world'\"!&").stringByXMLEscaping) &&
 	    [is isEqual: @"&lt;hello&gt; &amp;world&apos;&quot;!&amp;"])
 
+	TEST(@"-[stringByXMLEscaping] without anything to escape",
+	    [C(@"Nothing to escape in here").stringByXMLEscaping
+	    isEqual: @"Nothing to escape in here"] &&
+	    [C(@"0123456789abcdefghij\r").stringByXMLEscaping
+	    isEqual: @"0123456789abcdefghij&#xD;"])
+
 	TEST(@"-[stringByXMLUnescaping]",
 	    [is.stringByXMLUnescaping isEqual: @"<hello> &world'\"!&"] &&
 	    [C(@"&#x79;").stringByXMLUnescaping isEqual: @"y"] &&
 	    [C(@"&#xe4;").stringByXMLUnescaping isEqual: @"ä"] &&
 	    [C(@"&#8364;").stringByXMLUnescaping isEqual: @"€"] &&
-	    [C(@"&#x1D11E;").stringByXMLUnescaping isEqual: @"𝄞"])
+	    [C(@"&#x1D11E;").stringByXMLUnescaping isEqual: @"𝄞"] &&
+	    [C(@"Nothing to unescape").stringByXMLUnescaping
+	    isEqual: @"Nothing to unescape"])
 
 	EXPECT_EXCEPTION(@"Detect unknown entities in -[stringByXMLUnescaping]",
 	    OFUnknownXMLEntityException, [C(@"&foo;") stringByXMLUnescaping])
@@ -23,6 +23,77 @@
 
 static OFString *module = @"OFTCPSocket";
 
+@interface AsyncWriteDelegate: OFObject <OFStreamDelegate>
+{
+@public
+	size_t _count;
+	bool _failed;
+}
+@end
+
+@implementation AsyncWriteDelegate
+- (OFData *)stream: (OFStream *)stream
+      didWriteData: (OFData *)data
+      bytesWritten: (size_t)bytesWritten
+	 exception: (id)exception
+{
+	_count++;
+
+	if (exception != nil || bytesWritten != data.count)
+		_failed = true;
+
+	return nil;
+}
+@end
+
+#if defined(OF_HAVE_BLOCKS) && defined(OF_HAVE_THREADS)
+# define LARGE_WRITE_SIZE (8 * 1024 * 1024)
+
+static OFData *
+dataOfCharacter(char character, size_t count)
+{
+	OFMutableData *data = [OFMutableData data];
+
+	[data increaseCountBy: count];
+	memset(data.mutableItems, character, count);
+
+	return data;
+}
+
+/*
+ * Checks that the data of each write arrived in one piece and that the first
+ * write arrived first, no matter where the writes were split.
+ */
+static bool
+checkRuns(const char *buffer, size_t length)
+{
+	size_t expected[4] = { LARGE_WRITE_SIZE, LARGE_WRITE_SIZE, 10, 10 };
+	bool seen[4] = { false };
+
+	if (length == 0 || buffer[0] != 'a')
+		return false;
+
+	for (size_t i = 0; i < length;) {
+		size_t runLength = 1, idx = buffer[i] - 'a';
+
+		if (idx > 3 || seen[idx])
+			return false;
+
+		while (i + runLength < length &&
+		    buffer[i + runLength] == buffer[i])
+			runLength++;
+
+		if (runLength != expected[idx])
+			return false;
+
+		seen[idx] = true;
+		i += runLength;
+	}
+
+	return (seen[0] && seen[1] && seen[2] && seen[3]);
+}
+#endif
+
 @implementation TestsAppDelegate (OFTCPSocketTests)
 - (void)TCPSocketTests
 {
@@ -30,6 +101,17 @@ static OFString *module = @"OFTCPSocket";
 	OFTCPSocket *server, *client = nil, *accepted;
 	uint16_t port;
 	char buf[6];
+	of_stream_buffer_t buffers[3] = {
+		{ "ab", 2 }, { "c", 1 }, { "def", 3 }
+	};
+	AsyncWriteDelegate *delegate =
+	    [[[AsyncWriteDelegate alloc] init] autorelease];
+#if defined(OF_HAVE_BLOCKS) && defined(OF_HAVE_THREADS)
+	OFThread *reader;
+	OFData *received;
+	__block size_t callbacks = 0;
+	__block bool failed = false, wroteMore = false;
+#endif
 
 	TEST(@"+[socket]", (server = [OFTCPSocket socket]) &&
 	    (client = [OFTCPSocket socket]))
@@ -56,6 +138,113 @@ static OFString *module = @"OFTCPSocket";
 							     length: 6] &&
 	    !memcmp(buf, "Hello!", 6))
 
+#ifdef OF_HAVE_FILES
+	TEST(@"-[writeFromFile:offset:length:]",
+	    [client writeFromFile: [OFFile fileWithPath: @"testfile.bin"
+						   mode: @"r"]
+			   offset: 10
+			   length: 6] == 6 &&
+	    R([accepted readIntoBuffer: buf
+			   exactLength: 6]) &&
+	    !memcmp(buf, (const char *)[OFData dataWithContentsOfFile:
+	    @"testfile.bin"].items + 10, 6))
+#endif
+
+	TEST(@"Unbuffered -[writeBuffers:count:]",
+	    [client writeBuffers: buffers
+			   count: 3] == 6 &&
+	    R([accepted readIntoBuffer: buf
+			   exactLength: 6]) && !memcmp(buf, "abcdef", 6))
+
+	client.delegate = delegate;
+	[client asyncWriteDataArray: [OFArray arrayWithObjects:
+	    [OFData dataWithItems: "gh"
+			    count: 2],
+	    [OFData dataWithItems: "i"
+			    count: 1],
+	    [OFData dataWithItems: "jkl"
+			    count: 3], nil]];
+
+	for (size_t i = 0; i < 100 && delegate->_count < 3; i++)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.1]];
+
+	client.delegate = nil;
+
+	TEST(@"-[asyncWriteDataArray:]",
+	    delegate->_count == 3 && !delegate->_failed &&
+	    R([accepted readIntoBuffer: buf
+			   exactLength: 6]) && !memcmp(buf, "ghijkl", 6))
+
+#if defined(OF_HAVE_BLOCKS) && defined(OF_HAVE_THREADS)
+	reader = [OFThread threadWithThreadBlock: ^ id (void) {
+		size_t length = 2 * LARGE_WRITE_SIZE + 20;
+		OFMutableData *data = [OFMutableData dataWithCapacity: length];
+
+		[data increaseCountBy: length];
+		[accepted readIntoBuffer: data.mutableItems
+			     exactLength: length];
+
+		return [data retain];
+	}];
+	reader.supportsSockets = true;
+	[reader start];
+
+	/*
+	 * The writes are too large for the socket in non-blocking mode, so
+	 * they are split at arbitrary points. The first one writes more data
+	 * once it is done.
+	 */
+	client.blocking = false;
+
+	[client asyncWriteData: dataOfCharacter('a', LARGE_WRITE_SIZE)
+			 block: ^ OFData *(OFStream *stream, OFData *data,
+			     size_t bytesWritten, id exception) {
+		callbacks++;
+
+		if (exception != nil || bytesWritten !=
+		    (wroteMore ? 10 : LARGE_WRITE_SIZE))
+			failed = true;
+
+		if (wroteMore)
+			return nil;
+
+		wroteMore = true;
+		return dataOfCharacter('d', 10);
+	}];
+	[client asyncWriteData: dataOfCharacter('b', LARGE_WRITE_SIZE)
+			 block: ^ OFData *(OFStream *stream, OFData *data,
+			     size_t bytesWritten, id exception) {
+		callbacks++;
+
+		if (exception != nil || bytesWritten != LARGE_WRITE_SIZE)
+			failed = true;
+
+		return nil;
+	}];
+	[client asyncWriteData: dataOfCharacter('c', 10)
+			 block: ^ OFData *(OFStream *stream, OFData *data,
+			     size_t bytesWritten, id exception) {
+		callbacks++;
+
+		if (exception != nil || bytesWritten != 10)
+			failed = true;
+
+		return nil;
+	}];
+
+	for (size_t i = 0; i < 100 && callbacks < 4; i++)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.1]];
+
+	client.blocking = true;
+	received = [[reader join] autorelease];
+
+	TEST(@"Coalesced -[asyncWriteData:block:]",
+	    callbacks == 4 && !failed &&
+	    checkRuns(received.items, received.count))
+#endif
+
 	[pool drain];
 }
 @end
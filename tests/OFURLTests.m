@@ -57,6 +57,9 @@ static OFString *url_str = @"ht%3atp://us%3Aer:p%40w@ho%3Ast:1234/"
 	    OFInvalidFormatException,
 	    [OFURL URLWithString: @"http://foo/foo?foo#`"])
 
+	TEST(@"+[URLWithString:] lowercases the scheme",
+	    [[OFURL URLWithString: @"HtTp://foo/"].scheme isEqual: @"http"])
+
 	TEST(@"+[URLWithString:relativeToURL:]",
 	    [[[OFURL URLWithString: @"/foo"
 		     relativeToURL: u1] string] isEqual:
@@ -27,6 +27,8 @@ static OFString *module = @"OFXMLNode";
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	id nodes[4];
 	OFArray *a;
+	CaptureStream *stream;
+	OFXMLElement *element, *child;
 
 	TEST(@"+[elementWithName:]",
 	    (nodes[0] = [OFXMLElement elementWithName: @"foo"]) &&
@@ -138,6 +140,27 @@ static OFString *module = @"OFXMLNode";
 	    @"<!-- foo --></y></x>"] XMLStringWithIndentation: 2] isEqual:
 	    @"<x>\n  <y>\n    <z>a\nb</z>\n    <!-- foo -->\n  </y>\n</x>"])
 
+	stream = [[[CaptureStream alloc] init] autorelease];
+	element = [OFXMLElement elementWithName: @"x"];
+	child = [OFXMLElement elementWithName: @"y"];
+	[element addAttributeWithName: @"a"
+			  stringValue: @"&"];
+	[child addChild: [OFXMLCDATA CDATAWithString: @"a]]>b"]];
+	[child addChild: [OFXMLProcessingInstructions
+	    processingInstructionsWithString: @"p"]];
+	[element addChild: child];
+
+	TEST(@"-[writeXMLToStream:indentation:]",
+	    R([element writeXMLToStream: stream
+			    indentation: 1]) &&
+	    [[OFString stringWithUTF8String: stream.data.items
+				     length: stream.data.count] isEqual:
+	    @"<x a='&amp;'>\n <y><![CDATA[a]]>]]&gt;<![CDATA[b]]><?p?></y>\n"
+	    @"</x>"] &&
+	    [[element XMLStringWithIndentation: 1] isEqual:
+	    [OFString stringWithUTF8String: stream.data.items
+				    length: stream.data.count]])
+
 	[pool drain];
 }
 @end
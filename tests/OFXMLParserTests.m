@@ -339,6 +339,8 @@ enum event_type {
 	    " </foobar>\n"
 	    "</root>";
 	OFXMLParser *parser;
+	OFMutableString *CRLFString;
+	OFXMLElement *element;
 	size_t j, len;
 
 	TEST(@"+[parser]", (parser = [OFXMLParser parser]))
@@ -392,6 +394,18 @@ enum event_type {
 	    OFMalformedXMLException,
 	    [parser parseString: @"<x><?xml?></x>"])
 
+	/* This used to be quadratic, as every \r\n moved the whole buffer */
+	CRLFString = [OFMutableString stringWithString: @"<x a='\r\n\r'>"];
+	for (j = 0; j < 100000; j++)
+		[CRLFString appendString: @"a\r\n"];
+	[CRLFString appendString: @"\r</x>"];
+	TEST(@"Normalizing many CRLFs",
+	    (element = [OFXMLElement elementWithXMLString: CRLFString]) &&
+	    element.stringValue.length == 200001 &&
+	    [[element.stringValue substringWithRange: of_range(0, 6)]
+	    isEqual: @"a\na\na\n"] &&
+	    [[element attributeForName: @"a"].stringValue isEqual: @"\n\n"])
+
 	[pool drain];
 }
 @end
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFXMLReader";
+static const char *document = "<?xml version='1.0'?>\n"
+    "<r xmlns:x='urn:x'><a x:k='1' k='2'>foo<b><c/>bar</b></a>"
+    "<![CDATA[baz]]><!--qux--><d/></r>";
+
+@interface XMLReaderTestStream: OFStream
+{
+	size_t _position;
+}
+@end
+
+@implementation XMLReaderTestStream
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= strlen(document));
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	/* Return tiny chunks so that tokens are split across reads. */
+	size_t left = strlen(document) - _position;
+
+	if (length > 3)
+		length = 3;
+	if (length > left)
+		length = left;
+
+	memcpy(buffer, document + _position, length);
+	_position += length;
+
+	return length;
+}
+@end
+
+@implementation TestsAppDelegate (OFXMLReaderTests)
+- (void)XMLReaderTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFXMLReader *reader;
+
+	TEST(@"+[readerWithStream:]", (reader = [OFXMLReader readerWithStream:
+	    [[[XMLReaderTestStream alloc] init] autorelease]]))
+
+	TEST(@"-[nextEvent] for processing instructions",
+	    [reader nextEvent] == OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS &&
+	    [reader.stringValue isEqual: @"xml version='1.0'"])
+
+	TEST(@"-[nextEvent] for start of root element",
+	    [reader nextEvent] == OF_XML_READER_EVENT_CHARACTERS &&
+	    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+	    [reader.name isEqual: @"r"] && reader.depth == 1)
+
+	TEST(@"-[nextEvent] for start of element with attributes",
+	    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+	    [reader.name isEqual: @"a"] && reader.depth == 2 &&
+	    reader.attributesCount == 2)
+
+	TEST(@"-[attributeNameAtIndex:]",
+	    [[reader attributeNameAtIndex: 0] isEqual: @"k"] &&
+	    [[reader attributeNameAtIndex: 1] isEqual: @"k"])
+
+	TEST(@"-[attributeNamespaceAtIndex:]",
+	    [[reader attributeNamespaceAtIndex: 0] isEqual: @"urn:x"] &&
+	    [reader attributeNamespaceAtIndex: 1] == nil)
+
+	TEST(@"-[attributeValueForName:namespace:]",
+	    [[reader attributeValueForName: @"k"
+				 namespace: nil] isEqual: @"2"] &&
+	    [[reader attributeValueForName: @"k"
+				 namespace: @"urn:x"] isEqual: @"1"] &&
+	    [reader attributeValueForName: @"x"
+				namespace: nil] == nil)
+
+	EXPECT_EXCEPTION(@"Detection of out of range attribute index",
+	    OFOutOfRangeException, [reader attributeValueAtIndex: 2])
+
+	TEST(@"-[skipCurrentElement]", R([reader skipCurrentElement]) &&
+	    reader.eventType == OF_XML_READER_EVENT_END_ELEMENT &&
+	    [reader.name isEqual: @"a"] && reader.depth == 2)
+
+	TEST(@"-[nextEvent] after skipping",
+	    [reader nextEvent] == OF_XML_READER_EVENT_CDATA &&
+	    [reader.stringValue isEqual: @"baz"] &&
+	    [reader nextEvent] == OF_XML_READER_EVENT_COMMENT &&
+	    [reader.stringValue isEqual: @"qux"])
+
+	TEST(@"-[skipCurrentElement] on empty element",
+	    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+	    R([reader skipCurrentElement]) &&
+	    reader.eventType == OF_XML_READER_EVENT_END_ELEMENT &&
+	    [reader.name isEqual: @"d"])
+
+	EXPECT_EXCEPTION(@"Detection of -[skipCurrentElement] on end of "
+	    @"element", OFInvalidArgumentException, [reader skipCurrentElement])
+
+	TEST(@"-[nextEvent] at end of document",
+	    [reader nextEvent] == OF_XML_READER_EVENT_END_ELEMENT &&
+	    [reader.name isEqual: @"r"] && reader.depth == 1 &&
+	    [reader nextEvent] == OF_XML_READER_EVENT_END_OF_DOCUMENT)
+
+	TEST(@"Properties at end of document",
+	    reader.name == nil && reader.stringValue == nil &&
+	    reader.attributesCount == 0 && reader.depth == 0 &&
+	    [reader attributeValueForName: @"k"
+				namespace: nil] == nil)
+
+	EXPECT_EXCEPTION(@"Detection of attribute index at end of document",
+	    OFOutOfRangeException, [reader attributeNameAtIndex: 0])
+
+	[pool drain];
+}
+@end
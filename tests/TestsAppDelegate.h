@@ -86,6 +86,15 @@ enum {
 	     inModule: (OFString *)module;
 @end
 
+/* A stream that collects everything written to it, for use by the tests. */
+@interface CaptureStream: OFStream
+{
+	OFMutableData *_data;
+}
+
+@property (readonly, nonatomic) OFMutableData *data;
+@end
+
 @interface TestsAppDelegate (OFASN1DERValueTests)
 - (void)ASN1DERValueTests;
 @end
@@ -166,6 +175,10 @@ enum {
 - (void)MD5HashTests;
 @end
 
+@interface TestsAppDelegate (OFMessagePackTests)
+- (void)messagePackTests;
+@end
+
 @interface TestsAppDelegate (OFMethodSignatureTests)
 - (void)methodSignatureTests;
 @end
@@ -230,6 +243,10 @@ enum {
 - (void)systemInfoTests;
 @end
 
+@interface TestsAppDelegate (OFFileManagerTests)
+- (void)fileManagerTests;
+@end
+
 @interface TestsAppDelegate (OFHMACTests)
 - (void)HMACTests;
 @end
@@ -279,6 +296,10 @@ enum {
 - (void)XMLParserTests;
 @end
 
+@interface TestsAppDelegate (OFXMLReaderTests)
+- (void)XMLReaderTests;
+@end
+
 @interface TestsAppDelegate (PBKDF2Tests)
 - (void)PBKDF2Tests;
 @end
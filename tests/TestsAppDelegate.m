@@ -397,6 +397,7 @@ main(int argc, char *argv[])
 	[self numberTests];
 	[self streamTests];
 #ifdef OF_HAVE_FILES
+	[self fileManagerTests];
 	[self MD5HashTests];
 	[self RIPEMD160HashTests];
 	[self SHA1HashTests];
@@ -431,11 +432,13 @@ main(int argc, char *argv[])
 	[self XMLParserTests];
 	[self XMLNodeTests];
 	[self XMLElementBuilderTests];
+	[self XMLReaderTests];
 #ifdef OF_HAVE_FILES
 	[self serializationTests];
 #endif
 	[self JSONTests];
 	[self propertyListTests];
+	[self messagePackTests];
 	[self ASN1DERValueTests];
 	[self ASN1DERRepresentationTests];
 #if defined(OF_HAVE_PLUGINS)
@@ -497,3 +500,37 @@ main(int argc, char *argv[])
 #endif
 }
 @end
+
+@implementation CaptureStream
+@synthesize data = _data;
+
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_data = [[OFMutableData alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	[_data addItems: buffer
+		  count: length];
+
+	return length;
+}
+@end